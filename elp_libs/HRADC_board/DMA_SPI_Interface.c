@@ -1,27 +1,106 @@
-/* TODO: Calibrate DMATransferSize for each SPI_CLK value */
-
+#include <math.h>
 #include "DMA_SPI_Interface.h"
 
 __interrupt void local_D_INTCH1_ISR(void);
 __interrupt void local_D_INTCH2_ISR(void);
-void Init_DMA_McBSP_nBuffers(Uint16 n_buffers, Uint16 size_buffers, Uint16 spiClk);
+eDMAPlanStatus Plan_DMA_McBSP_nBuffers(tDMA_Plan *plan, Uint16 n_buffers, Uint16 spiClk,
+									   float freq_sampling, float freq_control);
+void Init_DMA_McBSP_nBuffers(tDMA_Plan *plan);
 void start_DMA(void);
 void stop_DMA(void);
 
 //#pragma DATA_SECTION(buffers_HRADC, "SHARERAMS1_1")
 
-volatile Uint16 DMATransferSize[5][4] = { {1, 15, 45, 60},
-										  {1, 15, 45, 60},
-										  {1, 15, 45, 60},
-										  {1, 15, 45, 60},
-										  {1, 25, 55, 90} };
+/*
+ * Calibrated transmit transfer sizes, for each CLKGDV from
+ * DMA_CALIBRATED_SPI_CLK_MIN and each number of boards
+ */
+static const Uint16 DMATransferSize[DMA_CALIBRATED_SPI_CLK_MAX - DMA_CALIBRATED_SPI_CLK_MIN + 1]
+									[HRADC_BUFFERS_NUM] = { {1, 15, 45, 60},
+															{1, 15, 45, 60},
+															{1, 15, 45, 60},
+															{1, 15, 45, 60},
+															{1, 25, 55, 90} };
 
 volatile Uint32 i_rdata;
 volatile Uint32 dummy_data = 0x00000000;
 //volatile tbuffers_HRADC buffers_HRADC;
-volatile Uint32 buffers_HRADC[4][HRADC_BUFFERS_SIZE];
+volatile Uint32 buffers_HRADC[HRADC_BUFFERS_NUM][HRADC_BUFFERS_SIZE];
+
+//*****************************************************************************
+// Plan DMA transfers from HRADC boards
+//
+// Decimation factor (samples per control period) is given by sampling and
+// control frequencies, rounded to nearest integer, and receive channel
+// transfers all samples from all boards in a control period.
+//
+// On each HRADC conversion (XINT1), transmit channel writes DXR continuously
+// in a single transfer, and McBSP starts a new frame whenever it's empty.
+// For n boards, last write must happen during frame n-2, so frame n-1 is sent
+// and no extra frame follows it. With a single board, each burst is triggered
+// by XINT1. Transfer size is taken from calibrated table, so SPI clocks out of
+// it are rejected with DMA_Plan_Uncalibrated_SPI_Clk, reported to ARM by
+// HRADCs_Info.DMA_PlanStatus.
+//
+// Plan is always filled, with decimation factor limited to buffers size, but
+// it's only valid if DMA_PLAN_IS_VALID() holds for returned status.
+//*****************************************************************************
+eDMAPlanStatus Plan_DMA_McBSP_nBuffers(tDMA_Plan *plan, Uint16 n_buffers, Uint16 spiClk,
+									   float freq_sampling, float freq_control)
+{
+    Uint16 decimation;
+
+    plan->n_buffers = n_buffers;
+    plan->spiClk = spiClk;
+    plan->size_buffers = 1;
+    plan->tx_transfer_size = 1;
+    plan->rx_transfer_size = n_buffers - 1;
+
+    if( (n_buffers == 0) || (n_buffers > HRADC_BUFFERS_NUM) )
+    {
+        return DMA_Plan_Invalid_Num_Buffers;
+    }
+
+    if( (spiClk == 0) || (spiClk > 255) )
+    {
+        return DMA_Plan_Invalid_SPI_Clk;
+    }
+
+    if( (freq_sampling <= 0.0) || (freq_control <= 0.0) )
+    {
+        return DMA_Plan_Invalid_Decimation;
+    }
+
+    decimation = (Uint16) roundf(freq_sampling / freq_control);
+
+    if(decimation > HRADC_BUFFERS_SIZE)
+    {
+        plan->size_buffers = HRADC_BUFFERS_SIZE;
+        plan->rx_transfer_size = n_buffers * HRADC_BUFFERS_SIZE - 1;
+        return DMA_Plan_Buffer_Overflow;
+    }
+
+    if(decimation == 0)
+    {
+        return DMA_Plan_Invalid_Decimation;
+    }
+
+    plan->size_buffers = decimation;
+    plan->rx_transfer_size = n_buffers * decimation - 1;
+
+    if( (spiClk < DMA_CALIBRATED_SPI_CLK_MIN) ||
+        (spiClk > DMA_CALIBRATED_SPI_CLK_MAX) )
+    {
+        return DMA_Plan_Uncalibrated_SPI_Clk;
+    }
+
+    plan->tx_transfer_size =
+            DMATransferSize[spiClk - DMA_CALIBRATED_SPI_CLK_MIN][n_buffers - 1];
+
+    return DMA_Plan_Ok;
+}
 
-void Init_DMA_McBSP_nBuffers(Uint16 n_buffers, Uint16 size_buffers, Uint16 spiClk)
+void Init_DMA_McBSP_nBuffers(tDMA_Plan *plan)
 {
 
 
@@ -53,8 +132,8 @@ void Init_DMA_McBSP_nBuffers(Uint16 n_buffers, Uint16 size_buffers, Uint16 spiCl
   //
   // Interrupt every frame ( (TRANSFER_BUFFER_SIZE-2)/2 bursts/transfer)
   //
-  DmaRegs.CH2.TRANSFER_SIZE = DMATransferSize[spiClk-2][n_buffers-1];
-  DmaRegs.CH1.TRANSFER_SIZE = n_buffers * size_buffers - 1;
+  DmaRegs.CH2.TRANSFER_SIZE = plan->tx_transfer_size;
+  DmaRegs.CH1.TRANSFER_SIZE = plan->rx_transfer_size;
 
   //
   // For transmit, after each burst:
@@ -69,7 +148,7 @@ void Init_DMA_McBSP_nBuffers(Uint16 n_buffers, Uint16 size_buffers, Uint16 spiCl
   //     Add 3 to the destination: move to the next word
   //
   DmaRegs.CH1.SRC_TRANSFER_STEP = 0xFFFF;
-  //DmaRegs.CH1.DST_TRANSFER_STEP = 2 * size_buffers + 1;
+  //DmaRegs.CH1.DST_TRANSFER_STEP = 2 * plan->size_buffers + 1;
   DmaRegs.CH1.DST_TRANSFER_STEP = 2 * HRADC_BUFFERS_SIZE + 1;
   //
   // Transmit source and destination:
@@ -105,7 +184,7 @@ void Init_DMA_McBSP_nBuffers(Uint16 n_buffers, Uint16 size_buffers, Uint16 spiCl
   DmaRegs.CH2.DST_WRAP_STEP = 0;
 
   DmaRegs.CH1.SRC_WRAP_SIZE = 0xFFFF;
-  DmaRegs.CH1.DST_WRAP_SIZE = n_buffers - 1;
+  DmaRegs.CH1.DST_WRAP_SIZE = plan->n_buffers - 1;
   DmaRegs.CH1.SRC_WRAP_STEP = 0;
   DmaRegs.CH1.DST_WRAP_STEP = 2;
 
@@ -122,7 +201,7 @@ void Init_DMA_McBSP_nBuffers(Uint16 n_buffers, Uint16 size_buffers, Uint16 spiCl
   DmaRegs.CH1.MODE.bit.CONTINUOUS = 1;
   DmaRegs.CH2.MODE.bit.CONTINUOUS = 1;
   DmaRegs.CH1.MODE.bit.ONESHOT = 0; //(n_buffers > 1);
-  DmaRegs.CH2.MODE.bit.ONESHOT = (n_buffers > 1);
+  DmaRegs.CH2.MODE.bit.ONESHOT = (plan->n_buffers > 1);
 
   DmaRegs.PRIORITYCTRL1.bit.CH1PRIORITY = 1;
   DmaRegs.DMACTRL.bit.PRIORITYRESET = 1;
@@ -5,6 +5,40 @@
 #define DMA_SPI_INTERFACE_H
 
 #define HRADC_BUFFERS_SIZE	64
+#define HRADC_BUFFERS_NUM	4
+
+/*
+ * Transmit transfer sizes were calibrated for CLKGDV from
+ * DMA_CALIBRATED_SPI_CLK_MIN to DMA_CALIBRATED_SPI_CLK_MAX (SPI_25MHz to
+ * SPI_10_71MHz), for 1 to HRADC_BUFFERS_NUM boards.
+ */
+#define DMA_CALIBRATED_SPI_CLK_MIN	2
+#define DMA_CALIBRATED_SPI_CLK_MAX	6
+
+/*
+ * Plan may only be used if transmit transfer size is calibrated
+ */
+#define DMA_PLAN_IS_VALID(status)	( (status) == DMA_Plan_Ok )
+
+typedef enum
+{
+	DMA_Plan_Ok,
+	DMA_Plan_Invalid_Num_Buffers,		// Number of boards out of [1, HRADC_BUFFERS_NUM]
+	DMA_Plan_Invalid_SPI_Clk,			// CLKGDV out of [1, 255]
+	DMA_Plan_Invalid_Decimation,		// Decimation factor rounds to 0
+	DMA_Plan_Buffer_Overflow,			// Decimation factor above HRADC_BUFFERS_SIZE
+	DMA_Plan_Frame_Overrun,				// Not used (kept for ARM status values)
+	DMA_Plan_Uncalibrated_SPI_Clk		// CLKGDV out of calibrated transfer sizes
+} eDMAPlanStatus;
+
+typedef struct
+{
+	Uint16 n_buffers;					// Number of HRADC boards
+	Uint16 size_buffers;				// Samples per control period (decimation factor)
+	Uint16 spiClk;						// McBSP CLKGDV
+	Uint16 tx_transfer_size;			// Transmit channel bursts per transfer - 1
+	Uint16 rx_transfer_size;			// Receive channel bursts per transfer - 1
+} tDMA_Plan;
 
 typedef volatile struct
 {
@@ -16,13 +50,15 @@ typedef volatile struct
 
 extern __interrupt void local_D_INTCH1_ISR(void);
 extern __interrupt void local_D_INTCH2_ISR(void);
-extern void Init_DMA_McBSP_nBuffers(Uint16 n_buffers, Uint16 size_buffers, Uint16 spiClk);
+extern eDMAPlanStatus Plan_DMA_McBSP_nBuffers(tDMA_Plan *plan, Uint16 n_buffers, Uint16 spiClk,
+											  float freq_sampling, float freq_control);
+extern void Init_DMA_McBSP_nBuffers(tDMA_Plan *plan);
 extern void start_DMA(void);
 extern void stop_DMA(void);
 
 extern volatile Uint32 i_rdata;
 extern volatile Uint32 dummy_data;
 //extern volatile tbuffers_HRADC buffers_HRADC;
-extern volatile Uint32 buffers_HRADC[4][HRADC_BUFFERS_SIZE];
+extern volatile Uint32 buffers_HRADC[HRADC_BUFFERS_NUM][HRADC_BUFFERS_SIZE];
 
 #endif	/* DMA_SPI_INTERFACE_H */
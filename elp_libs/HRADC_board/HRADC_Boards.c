@@ -28,6 +28,9 @@ Uint16 Try_Config_HRADC_board(volatile HRADC_struct *hradcPtr, eInputType Analog
 void SendCommand_HRADC(volatile HRADC_struct *hradcPtr, Uint16 command);
 Uint16 CheckStatus_HRADC(volatile HRADC_struct *hradcPtr);
 
+Uint16 Config_HRADC_Oversampling(volatile HRADC_struct *hradcPtr, Uint16 oversampling);
+void Read_HRADC_Samples(float *samples);
+
 void Config_HRADC_SoC(float freq);
 void Enable_HRADC_Sampling(void);
 void Disable_HRADC_Sampling(void);
@@ -48,6 +51,7 @@ void Read_HRADC_BoardData(HRADC_struct *hradcPtr);
 //	Place them in shared memory RAMS1
 //
 #pragma DATA_SECTION(HRADCs_Info, "SHARERAMS1_1")
+#pragma CODE_SECTION(Read_HRADC_Samples, "ramfuncs");
 /*#pragma DATA_SECTION(HRADC0_board, "SHARERAMS1_1")
 #pragma DATA_SECTION(HRADC1_board, "SHARERAMS1_1")
 #pragma DATA_SECTION(HRADC2_board, "SHARERAMS1_1")
@@ -114,6 +118,66 @@ void Init_HRADC_Info(volatile HRADC_struct *hradcPtr, Uint16 ID, Uint16 buffer_s
 
     hradcPtr->gain = hradcPtr->BoardData.t.gain_Vin_bipolar;
     hradcPtr->offset = hradcPtr->BoardData.t.offset_Vin_bipolar;
+
+    Config_HRADC_Oversampling(hradcPtr, HRADC_OVERSAMPLING_FULL);
+}
+
+/**********************************************************************************************/
+//
+//	Configure how many of the newest samples from the buffer of each control period are
+//	averaged for this board. Ratio is limited to buffer size, and HRADC_OVERSAMPLING_FULL
+//	selects the whole buffer. Slowly varying signals may use lower ratios to save ISR time,
+//	as long as every user, including interlocks, reads them after a low-pass filter (e.g.
+//	capacitor bank voltages on FAC DCDC models), so noise on single samples can't trip
+//	them. Returns 0 if sampling is enabled, so it can't change while ISR is reading samples.
+//
+Uint16 Config_HRADC_Oversampling(volatile HRADC_struct *hradcPtr, Uint16 oversampling)
+{
+	if(HRADCs_Info.enable_Sampling || (hradcPtr->ID >= N_MAX_HRADC))
+	{
+		return 0;
+	}
+
+	if( (oversampling == HRADC_OVERSAMPLING_FULL) ||
+		(oversampling > hradcPtr->size_SamplesBuffer) )
+	{
+		oversampling = hradcPtr->size_SamplesBuffer;
+	}
+
+	HRADCs_Info.oversampling[hradcPtr->ID] = oversampling;
+	HRADCs_Info.inv_Oversampling[hradcPtr->ID] = 1.0 / (float) oversampling;
+
+	return 1;
+}
+
+/**********************************************************************************************/
+//
+//	Average and scale samples from all boards, each one with its own oversampling ratio. Each
+//	board sums its newest samples in a single loop, without branches by sample, and result is
+//	scaled exactly as a full buffer average when ratio equals buffer size. Samples from boards
+//	beyond n_HRADC_boards are not written.
+//
+void Read_HRADC_Samples(float *samples)
+{
+	Uint16 i, j;
+	float acc;
+	volatile Uint32 *p_sample;
+
+	for(j = 0; j < HRADCs_Info.n_HRADC_boards; j++)
+	{
+		p_sample = HRADCs_Info.HRADC_boards[j].SamplesBuffer +
+				   HRADCs_Info.HRADC_boards[j].size_SamplesBuffer -
+				   HRADCs_Info.oversampling[j];
+		acc = 0.0;
+
+		for(i = HRADCs_Info.oversampling[j]; i > 0; i--)
+		{
+			acc += (float) *(p_sample++);
+		}
+
+		acc *= HRADCs_Info.HRADC_boards[j].gain * HRADCs_Info.inv_Oversampling[j];
+		samples[j] = acc + HRADCs_Info.HRADC_boards[j].offset;
+	}
 }
 
 /**********************************************************************************************/
@@ -375,7 +439,7 @@ void Config_HRADC_SoC(float freq)
 
 void Enable_HRADC_Sampling(void)
 {
-	if(HRADCs_Info.enable_Sampling)
+	if(HRADCs_Info.enable_Sampling || !DMA_PLAN_IS_VALID(HRADCs_Info.DMA_PlanStatus))
 	{
 		return;
 	}
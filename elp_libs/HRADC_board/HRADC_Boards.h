@@ -24,6 +24,8 @@
 
 #define TIMEOUT_uS_HRADC_CONFIG 		10000
 
+#define HRADC_OVERSAMPLING_FULL			0		// Average whole buffer of each control period
+
 #define UFM_OPCODE_WREN			0x0006
 #define UFM_OPCODE_WRDI			0x0004
 #define UFM_OPCODE_RDSR			0x0005
@@ -164,6 +166,9 @@ typedef volatile struct
 	Uint16 			enable_Sampling;
 	Uint16 			n_HRADC_boards;
 	HRADC_struct 	HRADC_boards[4];
+	eDMAPlanStatus	DMA_PlanStatus;		// Sampling is only enabled if DMA_PLAN_IS_VALID
+	Uint16			oversampling[4];	// Number of newest samples averaged from each board
+	float			inv_Oversampling[4];// 1/oversampling, set with oversampling ratio
 } HRADCs_struct;
 
 
@@ -189,6 +194,9 @@ extern Uint16 Try_Config_HRADC_board(volatile HRADC_struct *hradcPtr, eInputType
 extern void SendCommand_HRADC(volatile HRADC_struct *hradcPtr, Uint16 command);
 extern Uint16 CheckStatus_HRADC(volatile HRADC_struct *hradcPtr);
 
+extern Uint16 Config_HRADC_Oversampling(volatile HRADC_struct *hradcPtr, Uint16 oversampling);
+extern void Read_HRADC_Samples(float *samples);
+
 extern void Config_HRADC_SoC(float freq);
 extern void Enable_HRADC_Sampling(void);
 extern void Disable_HRADC_Sampling(void);
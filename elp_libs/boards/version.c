@@ -14,6 +14,25 @@
  * 
  * This module contains information about current build version of UDC C28 core.
  *
+ * ARM must check this version before accessing structures shared with C28.
+ * Version 0.46.00 changed the following layouts from 0.45.00:
+ *
+ *  - ipc_mtoc_lowpriority_msg_t: Reset_IPC_Latency added, which shifts
+ *    CtoM_Message_Error.
+ *  - ipc_ctom_lowpriority_msg_t: MtoC_Message_Done added.
+ *  - g_ipc_ctom: msg_mtoc_done added after error_mtoc.
+ *  - g_ipc_mtoc: timestamps, configuration lane message (msg_cfg,
+ *    msg_id_cfg) and timeslicer_id added.
+ *  - g_ipc_latency, g_signals and HRADCs_Info (DMA plan status and per-board
+ *    oversampling) share RAMS1_1.
+ *  - scope_t: sync records and source_id added, so scope sources are set by
+ *    signal ID.
+ *  - wfmref_t and RAMS2345: fixed curve buffers replaced by waveform library.
+ *  - dsp_module_t: DSP_Redundancy and DSP_Share classes added, and
+ *    compensated integrator states added to PI and IIR classes.
+ *  - timeslicer_t: freq_ratio_next added.
+ *  - Parameter bank: DCLink_Digital_Pot_Step added (NUM_PARAMETERS = 55).
+ *
  * @author gabriel.brunheira
  * @date 08/02/2018
  *
@@ -21,4 +40,4 @@
 
 #include "version.h"
 
-const char * udc_c28_version = "0.45.00    01/23";
+const char * udc_c28_version = "0.46.00    10/26";
@@ -157,7 +157,7 @@ SECTIONS
    SHARERAMS0_0        : > RAMS0_0,        PAGE = 1     // g_controller_mtoc
    SHARERAMS0_1        : > RAMS0_1,        PAGE = 1     // g_param_bank
    SHARERAMS1_0        : > RAMS1_0,        PAGE = 1     // g_controller_ctom
-   SHARERAMS1_1        : > RAMS1_1,        PAGE = 1     // HRADCs_Info
+   SHARERAMS1_1        : > RAMS1_1,        PAGE = 1     // HRADCs_Info, g_ipc_latency, g_signals
    //SHARERAMS2          : > RAMS2,        PAGE = 1
    //SHARERAMS3          : > RAMS3,        PAGE = 1
    //SHARERAMS4          : > RAMS4,        PAGE = 1
@@ -0,0 +1,243 @@
+/******************************************************************************
+ * Copyright (C) 2026 by LNLS - Brazilian Synchrotron Light Laboratory
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. LNLS and
+ * the Brazilian Center for Research in Energy and Materials (CNPEM) are not
+ * liable for any misuse of this material.
+ *
+ *****************************************************************************/
+
+/**
+ * @file fast_math.c
+ * @brief Fast math functions.
+ *
+ * Trigonometric and exponential functions use Cody-Waite range reduction
+ * followed by fixed-order polynomials. Square root and reciprocal use Newton-
+ * Raphson iterations from FPU estimate instructions (or from an integer
+ * approximation on targets without them). Both sin and cos polynomials are
+ * always evaluated, and results are selected afterwards, so execution time
+ * doesn't depend on the argument.
+ *
+ * Ref.: Muller, J.-M.; "Elementary Functions: Algorithms and Implementation",
+ * 3rd Edition
+ *
+ * Ref.: Abramowitz, M.; Stegun, I. A.; "Handbook of Mathematical Functions",
+ * eq. 4.4.49
+ *
+ * @date 18/10/2026
+ *
+ */
+
+#include "fast_math.h"
+
+#pragma CODE_SECTION(fast_sinf, "ramfuncs");
+#pragma CODE_SECTION(fast_cosf, "ramfuncs");
+#pragma CODE_SECTION(fast_expf, "ramfuncs");
+#pragma CODE_SECTION(fast_atanf, "ramfuncs");
+#pragma CODE_SECTION(fast_sqrtf, "ramfuncs");
+#pragma CODE_SECTION(fast_recipf, "ramfuncs");
+#pragma CODE_SECTION(fast_sincos_quadrant, "ramfuncs");
+
+#define INV_PI_2        0.636619772367581343f
+#define PI_2            1.570796326794896619f
+#define PI_2_HI         1.5703125f                  // Exact in 9 bits
+#define PI_2_LO         4.838267948966e-4f
+
+#define LOG2_E          1.442695040888963407f
+#define LN_2_HI         0.693145751953125f          // Exact in 16 bits
+#define LN_2_LO         1.428606765330187e-6f
+
+#define EXP_ARG_MAX     88.0f
+#define EXP_ARG_MIN     -87.0f
+
+/// Round float to nearest integer, with ties away from zero
+#define ROUND_TO_INT(x) ((int32_t) ((x) + (((x) < 0.0f) ? -0.5f : 0.5f)))
+
+typedef union
+{
+    float       f;
+    uint32_t    u32;
+} u_fast_math_t;
+
+static float fast_sincos_quadrant(float x, uint16_t quadrant_offset);
+
+/**
+ * Fast sine approximation.
+ *
+ * @param x angle [rad]
+ * @return approximation of sin(x)
+ */
+float fast_sinf(float x)
+{
+    return fast_sincos_quadrant(x, 0);
+}
+
+/**
+ * Fast cosine approximation.
+ *
+ * @param x angle [rad]
+ * @return approximation of cos(x)
+ */
+float fast_cosf(float x)
+{
+    return fast_sincos_quadrant(x, 1);
+}
+
+/**
+ * Fast exponential approximation. Argument is reduced to x = k*ln(2) + r, with
+ * |r| <= ln(2)/2, and exp(r) is evaluated with a 7th-order polynomial. 2^k is
+ * applied directly on float exponent.
+ *
+ * @param x argument from exp(x), saturated to [-87, 88]
+ * @return approximation of exp(x)
+ */
+float fast_expf(float x)
+{
+    int32_t k;
+    float r, p;
+    u_fast_math_t scale;
+
+    if(x > EXP_ARG_MAX)
+    {
+        x = EXP_ARG_MAX;
+    }
+    if(x < EXP_ARG_MIN)
+    {
+        x = EXP_ARG_MIN;
+    }
+
+    k = ROUND_TO_INT(x * LOG2_E);
+    r = (x - (float) k * LN_2_HI) - (float) k * LN_2_LO;
+
+    p = 1.0f + r * (1.0f + r * (1.0f/2.0f + r * (1.0f/6.0f + r * (1.0f/24.0f +
+        r * (1.0f/120.0f + r * (1.0f/720.0f + r * (1.0f/5040.0f)))))));
+
+    scale.u32 = ((uint32_t) (k + 127)) << 23;
+
+    return p * scale.f;
+}
+
+/**
+ * Fast arc tangent approximation. For |x| > 1, it uses
+ * atan(x) = pi/2 - atan(1/x). Reciprocal is always calculated to keep
+ * execution time constant.
+ *
+ * @param x argument from atan(x)
+ * @return approximation of atan(x) [rad]
+ */
+float fast_atanf(float x)
+{
+    float ax, z, z2, y;
+
+    ax = (x < 0.0f) ? -x : x;
+    z = fast_recipf(ax);
+    z = (ax > 1.0f) ? z : ax;
+    z2 = z * z;
+
+    y = z * (0.9999993329f + z2 * (-0.3332985605f + z2 * (0.1994653599f +
+        z2 * (-0.1390853351f + z2 * (0.0964200441f + z2 * (-0.0559098861f +
+        z2 * (0.0218612288f + z2 * (-0.0040540580f))))))));
+
+    y = (ax > 1.0f) ? (PI_2 - y) : y;
+
+    return (x < 0.0f) ? -y : y;
+}
+
+/**
+ * Fast square root approximation. It calculates 1/sqrt(x) with Newton-Raphson
+ * iterations, and then sqrt(x) = x * (1/sqrt(x)).
+ *
+ * @param x argument from sqrt(x)
+ * @return approximation of sqrt(x), or 0.0 for x <= 0.0
+ */
+float fast_sqrtf(float x)
+{
+    float y, half_x;
+
+    if(x <= 0.0f)
+    {
+        return 0.0f;
+    }
+
+#ifdef __TMS320C28XX_FPU32__
+    y = __eisqrtf32(x);
+#else
+    {
+        u_fast_math_t est;
+
+        est.f = x;
+        est.u32 = 0x5F3759DF - (est.u32 >> 1);
+        y = est.f;
+    }
+#endif
+
+    half_x = 0.5f * x;
+
+    y = y * (1.5f - half_x * y * y);
+    y = y * (1.5f - half_x * y * y);
+    y = y * (1.5f - half_x * y * y);
+
+    return x * y;
+}
+
+/**
+ * Fast reciprocal approximation, with Newton-Raphson iterations.
+ *
+ * @param x argument from 1/x, different from 0.0
+ * @return approximation of 1/x
+ */
+float fast_recipf(float x)
+{
+    float y;
+
+#ifdef __TMS320C28XX_FPU32__
+    y = __einvf32(x);
+#else
+    {
+        u_fast_math_t est;
+
+        est.f = x;
+        est.u32 = 0x7EF311C3 - (est.u32 & 0x7FFFFFFF) + (est.u32 & 0x80000000);
+        y = est.f;
+    }
+#endif
+
+    y = y * (2.0f - x * y);
+    y = y * (2.0f - x * y);
+    y = y * (2.0f - x * y);
+
+    return y;
+}
+
+/**
+ * Evaluate sine with argument shifted by a number of quadrants (quadrant
+ * offset of 1 results in cosine). Argument is reduced to x = k*pi/2 + r, with
+ * |r| <= pi/4, and both sin(r) and cos(r) polynomials are evaluated.
+ *
+ * @param x angle [rad]
+ * @param quadrant_offset number of pi/2 shifts added to x
+ * @return approximation of sin(x + quadrant_offset*pi/2)
+ */
+static float fast_sincos_quadrant(float x, uint16_t quadrant_offset)
+{
+    int32_t k;
+    uint16_t quadrant;
+    float r, r2, s, c, y;
+
+    k = ROUND_TO_INT(x * INV_PI_2);
+    r = (x - (float) k * PI_2_HI) - (float) k * PI_2_LO;
+    r2 = r * r;
+
+    s = r + r * r2 * (-1.0f/6.0f + r2 * (1.0f/120.0f + r2 * (-1.0f/5040.0f +
+        r2 * (1.0f/362880.0f))));
+
+    c = 1.0f + r2 * (-1.0f/2.0f + r2 * (1.0f/24.0f + r2 * (-1.0f/720.0f +
+        r2 * (1.0f/40320.0f))));
+
+    quadrant = ((uint16_t) k + quadrant_offset) & 0x3;
+
+    y = (quadrant & 0x1) ? c : s;
+
+    return (quadrant & 0x2) ? -y : y;
+}
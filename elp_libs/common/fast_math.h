@@ -0,0 +1,53 @@
+/******************************************************************************
+ * Copyright (C) 2026 by LNLS - Brazilian Synchrotron Light Laboratory
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. LNLS and
+ * the Brazilian Center for Research in Energy and Materials (CNPEM) are not
+ * liable for any misuse of this material.
+ *
+ *****************************************************************************/
+
+/**
+ * @file fast_math.h
+ * @brief Fast math functions.
+ *
+ * Single-precision approximations of transcendental functions, with bounded
+ * error and constant execution time (no data-dependent loops), to be used
+ * instead of RTS library in time-critical code. All functions are placed in
+ * ramfuncs section.
+ *
+ * Maximum errors below were measured against double precision libm, over the
+ * specified domains (4e6 points each, with integer initial estimates for
+ * fast_sqrtf() and fast_recipf(), which are worse than FPU ones):
+ *
+ *  function        domain                  max error
+ *  fast_sinf()     |x| <= 2*pi             1.0e-7 (absolute)
+ *                  |x| <= 1e4              1.8e-7 (absolute)
+ *  fast_cosf()     |x| <= 2*pi             1.1e-7 (absolute)
+ *                  |x| <= 1e4              1.8e-7 (absolute)
+ *  fast_expf()     -87 <= x <= 88          1.0e-7 (relative)
+ *  fast_atanf()    |x| <= 1e3              1.9e-7 (absolute)
+ *  fast_sqrtf()    1e-30 <= x <= 1e30      1.9e-7 (relative)
+ *  fast_recipf()   1e-30 <= |x| <= 1e30    1.5e-7 (relative)
+ *
+ * Arguments of fast_expf() are saturated to its domain. fast_sqrtf() returns
+ * 0.0 for x <= 0.0, and fast_recipf() doesn't handle x = 0.0.
+ *
+ * @date 18/10/2026
+ *
+ */
+
+#ifndef FAST_MATH_H_
+#define FAST_MATH_H_
+
+#include <stdint.h>
+
+extern float fast_sinf(float x);
+extern float fast_cosf(float x);
+extern float fast_expf(float x);
+extern float fast_atanf(float x);
+extern float fast_sqrtf(float x);
+extern float fast_recipf(float x);
+
+#endif /* FAST_MATH_H_ */
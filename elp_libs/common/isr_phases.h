@@ -0,0 +1,82 @@
+/******************************************************************************
+ * Copyright (C) 2026 by LNLS - Brazilian Synchrotron Light Laboratory
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. LNLS and
+ * the Brazilian Center for Research in Energy and Materials (CNPEM) are not
+ * liable for any misuse of this material.
+ *
+ *****************************************************************************/
+
+/**
+ * @file isr_phases.h
+ * @brief Control ISR phases
+ *
+ * Control ISR's are split in two phases:
+ *
+ *      - Critical phase: from sampling to actuator update (usually, PWM duty
+ *        cycles), including measurements, reference, control law and
+ *        actuation. Nothing else should be executed here, since any extra
+ *        instruction adds to loop delay.
+ *
+ *      - Deferred phase: after actuator update, with housekeeping tasks, such
+ *        as scopes, IPC telemetry, interlocks time-base and monitoring filters
+ *        not used by control law.
+ *
+ * END_ISR_CRITICAL_PHASE() opens a block which is closed by
+ * END_ISR_DEFERRED_PHASE(), and declares isr_deferred_phase within it. Macros
+ * of deferred-only tasks use ISR_DEFERRED_PHASE_ONLY, so they don't compile
+ * if placed in critical phase.
+ *
+ * Both macros also record ISR profile, with elapsed time given by a time-base
+ * counter selected by each power supply model. It's usually the counter of
+ * the ePWM module which triggered the ISR (see GET_PWM_ISR_MODULE), so
+ * critical phase latency is measured from the triggering event (in TBCLK
+ * cycles). Elapsed time must be below counter period, otherwise it wraps
+ * around and profile is not valid.
+ *
+ * @date 18/10/2026
+ *
+ */
+
+#ifndef ISR_PHASES_H_
+#define ISR_PHASES_H_
+
+#include <stdint.h>
+
+#define END_ISR_CRITICAL_PHASE(profile, elapsed)                        \
+    {                                                                   \
+        const uint16_t isr_deferred_phase = 1;                          \
+        (profile).latency_critical = (elapsed);                         \
+        if((profile).latency_critical > (profile).latency_critical_max) \
+        {                                                               \
+            (profile).latency_critical_max = (profile).latency_critical;\
+        }
+
+#define END_ISR_DEFERRED_PHASE(profile, elapsed)                        \
+        (profile).time_isr = (elapsed);                                 \
+        if((profile).time_isr > (profile).time_isr_max)                 \
+        {                                                               \
+            (profile).time_isr_max = (profile).time_isr;                \
+        }                                                               \
+    }
+
+#define ISR_DEFERRED_PHASE_ONLY     (void) isr_deferred_phase
+
+#define RESET_ISR_PROFILE(profile)  (profile).latency_critical = 0;     \
+                                    (profile).latency_critical_max = 0; \
+                                    (profile).time_isr = 0;             \
+                                    (profile).time_isr_max = 0
+
+/**
+ * Control ISR profile, in cycles of its trigger time-base
+ */
+typedef volatile struct
+{
+    uint16_t    latency_critical;
+    uint16_t    latency_critical_max;
+    uint16_t    time_isr;
+    uint16_t    time_isr_max;
+} isr_profile_t;
+
+#endif /* ISR_PHASES_H_ */
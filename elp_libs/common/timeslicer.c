@@ -28,6 +28,7 @@ void init_timeslicer(timeslicer_t *p_ts, float freq_base)
     p_ts->freq_base = freq_base;
     p_ts->freq_sampling = freq_base;
     p_ts->freq_ratio = 1;
+    p_ts->freq_ratio_next = 1;
     p_ts->counter = 1;
 }
 
@@ -43,9 +44,47 @@ void cfg_timeslicer(timeslicer_t *p_ts, float freq_sampling)
      */
     p_ts->freq_sampling = p_ts->freq_base / ((float) p_ts->freq_ratio);
 
+    p_ts->freq_ratio_next = p_ts->freq_ratio;
     p_ts->counter = p_ts->freq_ratio;
 }
 
+/**
+ * Reconfigure sampling frequency of running time slicer. Differently from
+ * cfg_timeslicer(), counter is not modified, and new decimation ratio is only
+ * applied by END_TIMESLICER, at the end of current period.
+ *
+ * Achieved sampling frequency, after rounding decimation ratio, is updated on
+ * freq_sampling. DSP modules designed for previous frequency must be
+ * reconfigured separately (see cfg_timeslicer_update()), or time slicers
+ * feeding them are locked (see lock_timeslicer()).
+ *
+ * @param p_ts pointer to time slicer
+ * @param freq_sampling desired sampling frequency [Hz], within
+ *                      [freq_base/65535, freq_base]
+ * @return 1 if successful, 0 if frequency is out of range
+ */
+uint16_t update_timeslicer(timeslicer_t *p_ts, float freq_sampling)
+{
+    float ratio;
+
+    if( !(freq_sampling > 0.0) )
+    {
+        return 0;
+    }
+
+    ratio = roundf(p_ts->freq_base / freq_sampling);
+
+    if( (ratio < 1.0) || (ratio > 65535.0) )
+    {
+        return 0;
+    }
+
+    p_ts->freq_ratio_next = (uint16_t) ratio;
+    p_ts->freq_sampling = p_ts->freq_base / ratio;
+
+    return 1;
+}
+
 void reset_timeslicer(timeslicer_t *p_ts)
 {
     p_ts->counter = p_ts->freq_ratio;
@@ -28,8 +28,14 @@
 
 #define NUM_MAX_TIMESLICERS     4
 
+/**
+ * New decimation ratio set by update_timeslicer() is applied at the end of
+ * task execution, so current period is always completed and the task keeps
+ * its phase.
+ */
 #define RUN_TIMESLICER(timeslicer)  if(timeslicer.counter++ == timeslicer.freq_ratio){
-#define END_TIMESLICER(timeslicer)  timeslicer.counter = 1;}
+#define END_TIMESLICER(timeslicer)  timeslicer.counter = 1;  \
+                                    timeslicer.freq_ratio = timeslicer.freq_ratio_next;}
 
 #define RESET_TIMESLICER(timeslicer)    timeslicer.counter = timeslicer.ratio
 
@@ -38,11 +44,13 @@ typedef volatile struct
     float     freq_base;
     float     freq_sampling;
     uint16_t  freq_ratio;
+    uint16_t  freq_ratio_next;
     uint16_t  counter;
 } timeslicer_t;
 
 extern void init_timeslicer(timeslicer_t *p_ts, float freq_base);
 extern void cfg_timeslicer(timeslicer_t *p_ts, float freq_sampling);
+extern uint16_t update_timeslicer(timeslicer_t *p_ts, float freq_sampling);
 extern void reset_timeslicer(timeslicer_t *p_ts);
 
 #endif /* TIMESLICER_H_ */
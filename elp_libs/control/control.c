@@ -29,6 +29,16 @@
 volatile control_framework_t g_controller_ctom;
 volatile control_framework_t g_controller_mtoc;
 
+/**
+ * Bit mask of time slicers locked by lock_timeslicer()
+ */
+static uint16_t timeslicers_locked;
+
+/**
+ * Callbacks registered by cfg_timeslicer_update() for each time slicer
+ */
+static void (*p_update_timeslicer[NUM_MAX_TIMESLICERS])(float freq_sampling);
+
 void init_control_framework(volatile control_framework_t *p_controller)
 {
     uint16_t i;
@@ -42,6 +52,15 @@ void init_control_framework(volatile control_framework_t *p_controller)
     {
         p_controller->output_signals[i].f = 0.0;
     }
+
+    RESET_ISR_PROFILE(p_controller->isr_profile);
+
+    timeslicers_locked = 0;
+
+    for(i = 0; i < NUM_MAX_TIMESLICERS; i++)
+    {
+        p_update_timeslicer[i] = 0;
+    }
 }
 
 void set_dsp_coeffs(dsp_class_t dsp_class, uint16_t id)
@@ -107,9 +126,98 @@ void set_dsp_coeffs(dsp_class_t dsp_class, uint16_t id)
             break;
         }
 
+        case DSP_Redundancy:
+        {
+            cfg_dsp_redundancy( &(g_controller_ctom.dsp_modules.dsp_redundancy[id]),
+                                g_controller_mtoc.dsp_modules.dsp_redundancy[id].coeffs.f[0],
+                                g_controller_mtoc.dsp_modules.dsp_redundancy[id].coeffs.f[1],
+                                g_controller_mtoc.dsp_modules.dsp_redundancy[id].coeffs.f[2],
+                                g_controller_mtoc.dsp_modules.dsp_redundancy[id].coeffs.f[3],
+                                g_controller_mtoc.dsp_modules.dsp_redundancy[id].coeffs.f[4] );
+            break;
+        }
+
+        case DSP_Share:
+        {
+            cfg_dsp_share( &(g_controller_ctom.dsp_modules.dsp_share[id]),
+                           g_controller_mtoc.dsp_modules.dsp_share[id].coeffs.f[0],
+                           g_controller_mtoc.dsp_modules.dsp_share[id].coeffs.f[1],
+                           g_controller_mtoc.dsp_modules.dsp_share[id].coeffs.f[2],
+                           g_controller_mtoc.dsp_modules.dsp_share[id].coeffs.f[3] );
+            break;
+        }
+
         default:
         {
             break;
         }
     }
 }
+
+/**
+ * Lock sampling frequency of specified time slicer. It must be called by power
+ * supply models for time slicers which feed DSP modules whose coefficients
+ * can't be re-derived from a new sampling frequency (e.g. notch and resonant
+ * filters configured by ARM with discrete coefficients). Otherwise, see
+ * cfg_timeslicer_update().
+ *
+ * @param id time slicer ID
+ */
+void lock_timeslicer(uint16_t id)
+{
+    if(id < NUM_MAX_TIMESLICERS)
+    {
+        timeslicers_locked |= 1 << id;
+    }
+}
+
+/**
+ * Register callback to be called by set_timeslicer() with achieved sampling
+ * frequency of specified time slicer, so power supply models re-derive
+ * coefficients of DSP modules it feeds (e.g. cfg_dsp_pi_freq()).
+ *
+ * @param id time slicer ID
+ * @param p_update pointer to callback
+ */
+void cfg_timeslicer_update(uint16_t id, void (*p_update)(float freq_sampling))
+{
+    if(id < NUM_MAX_TIMESLICERS)
+    {
+        p_update_timeslicer[id] = p_update;
+    }
+}
+
+/**
+ * Reconfigure sampling frequency of specified time slicer, from value written
+ * by ARM on g_controller_mtoc. Achieved frequency is reported on
+ * g_controller_ctom, and DSP coefficients are re-derived by callback registered
+ * with cfg_timeslicer_update(). Locked time slicers are rejected.
+ *
+ * It must be called with interrupts disabled. New coefficients are applied
+ * right away, while new decimation ratio is applied at the end of current
+ * period, so the next sample may still run at previous ratio.
+ *
+ * @param id time slicer ID
+ * @return 1 if successful, 0 if ID or frequency is invalid, or if time slicer
+ *         is locked
+ */
+uint16_t set_timeslicer(uint16_t id)
+{
+    if( (id >= NUM_MAX_TIMESLICERS) || (timeslicers_locked & (1 << id)) )
+    {
+        return 0;
+    }
+
+    if(!update_timeslicer(&g_controller_ctom.timeslicer[id],
+                          g_controller_mtoc.timeslicer[id].freq_sampling))
+    {
+        return 0;
+    }
+
+    if(p_update_timeslicer[id] != 0)
+    {
+        p_update_timeslicer[id](g_controller_ctom.timeslicer[id].freq_sampling);
+    }
+
+    return 1;
+}
@@ -25,6 +25,7 @@
 #include <stdint.h>
 #include "dsp/dsp.h"
 #include "common/timeslicer.h"
+#include "common/isr_phases.h"
 
 /* Library-wide limits */
 
@@ -39,6 +40,8 @@
 #define NUM_MAX_DSP_IIR_3P3Z        4
 #define NUM_MAX_DSP_VDCLINK_FF      2
 #define NUM_MAX_DSP_VECT_PRODUCT    2
+#define NUM_MAX_DSP_REDUNDANCY      1
+#define NUM_MAX_DSP_SHARE           1
 
 #define NUM_MAX_TIMESLICERS         4
 
@@ -55,6 +58,8 @@ typedef volatile struct
     dsp_iir_3p3z_t      dsp_iir_3p3z[NUM_MAX_DSP_IIR_3P3Z];
     dsp_vdclink_ff_t    dsp_ff[NUM_MAX_DSP_VDCLINK_FF];
     dsp_vect_product_t  dsp_vect_product[NUM_MAX_DSP_VECT_PRODUCT];
+    dsp_redundancy_t    dsp_redundancy[NUM_MAX_DSP_REDUNDANCY];
+    dsp_share_t         dsp_share[NUM_MAX_DSP_SHARE];
 } dsp_modules_t;
 
 
@@ -65,6 +70,7 @@ typedef volatile struct
  *      - Set of net signals for internal DSP modules interconnection
  *      - Set of output signals for duty cycles, for example.
  *      - Set of DSP modules
+ *      - Profile of control ISR
  */
 typedef volatile struct
 {
@@ -82,6 +88,7 @@ typedef volatile struct
 
     dsp_modules_t   dsp_modules;
     timeslicer_t    timeslicer[NUM_MAX_TIMESLICERS];
+    isr_profile_t   isr_profile;
 } control_framework_t;
 
 
@@ -91,6 +98,10 @@ extern volatile control_framework_t g_controller_mtoc;
 extern void init_control_framework(volatile control_framework_t *p_controller);
 
 extern void set_dsp_coeffs(dsp_class_t dsp_class, uint16_t id);
+extern void lock_timeslicer(uint16_t id);
+extern void cfg_timeslicer_update(uint16_t id,
+                                  void (*p_update)(float freq_sampling));
+extern uint16_t set_timeslicer(uint16_t id);
 
 
 #endif /* CONTROL_H_ */
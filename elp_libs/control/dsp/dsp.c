@@ -28,8 +28,15 @@
 
 #include <stdint.h>
 #include <math.h>
+#include "common/fast_math.h"
 #include "dsp.h"
 
+#ifdef DSP_USE_FAST_MATH
+#define DSP_COS(x)      fast_cosf(x)
+#else
+#define DSP_COS(x)      cos(x)
+#endif
+
 #pragma CODE_SECTION(run_dsp_error, "ramfuncs");
 #pragma CODE_SECTION(run_dsp_srlim, "ramfuncs");
 #pragma CODE_SECTION(run_dsp_lpf, "ramfuncs");
@@ -38,6 +45,31 @@
 #pragma CODE_SECTION(run_dsp_iir_3p3z, "ramfuncs");
 #pragma CODE_SECTION(run_dsp_vdclink_ff, "ramfuncs");
 #pragma CODE_SECTION(run_dsp_vect_product, "ramfuncs");
+#pragma CODE_SECTION(set_dsp_redundancy_fault, "ramfuncs");
+#pragma CODE_SECTION(run_dsp_redundancy, "ramfuncs");
+#pragma CODE_SECTION(exclude_dsp_redundancy_inputs, "ramfuncs");
+#pragma CODE_SECTION(run_dsp_share, "ramfuncs");
+#pragma CODE_SECTION(run_dsp_iir_2p2z_compensated, "ramfuncs");
+#pragma CODE_SECTION(run_dsp_iir_3p3z_compensated, "ramfuncs");
+
+/// Increment of noise counter for each implausible step
+#define REDUNDANCY_NOISE_WEIGHT     4
+
+/**
+ * Error-free addition (Knuth's TwoSum): s + e is exactly equal to a + b, for
+ * any magnitudes of a and b. Arguments must be local variables, since they are
+ * evaluated more than once. It relies on IEEE rounding of each operation, so
+ * this file must be built with --fp_reassoc=off (see file options of dsp.c in
+ * project settings), otherwise compiler is allowed to simplify e to zero.
+ */
+#define TWO_SUM(s, e, a, b)     s = a + b;                  \
+                                e = s - a;                  \
+                                e = (a - (s - e)) + (b - e);
+
+static void exclude_dsp_redundancy_inputs(dsp_redundancy_t *p_red,
+                                          uint16_t excluded);
+static void run_dsp_iir_2p2z_compensated(dsp_iir_2p2z_t *p_iir);
+static void run_dsp_iir_3p3z_compensated(dsp_iir_3p3z_t *p_iir);
 
 /**
  * Initialization of error signal entity.
@@ -106,6 +138,18 @@ void cfg_dsp_srlim(dsp_srlim_t *p_srlim, float max_slewrate)
     p_srlim->delta_max = max_slewrate / p_srlim->freq_sampling;
 }
 
+/**
+ * Change sampling frequency of slew-rate limiter, keeping its slew-rate.
+ *
+ * @param p_srlim
+ * @param freq_sampling         [Hz]
+ */
+void cfg_dsp_srlim_freq(dsp_srlim_t *p_srlim, float freq_sampling)
+{
+    p_srlim->freq_sampling = freq_sampling;
+    cfg_dsp_srlim(p_srlim, p_srlim->coeffs.s.max_slewrate);
+}
+
 /**
  * Bypass or not the specified slew-rate limiter.
  *
@@ -234,6 +278,8 @@ void init_dsp_pi(dsp_pi_t *p_pi, float kp, float ki, float freq_sampling,
     p_pi->freq_sampling = freq_sampling;
     p_pi->u_prop = 0.0;
     p_pi->u_int = 0.0;
+    p_pi->u_int_lo = 0.0;
+    p_pi->integrator = STANDARD_INTEGRATOR;
     p_pi->in = in;
     p_pi->out = out;
     *(p_pi->out) = 0.0;
@@ -249,6 +295,35 @@ void cfg_dsp_pi(dsp_pi_t *p_pi, float kp, float ki, float u_max, float u_min)
     p_pi->coeffs.s.u_min = u_min;
 }
 
+/**
+ * Change sampling frequency of PI controller, keeping its continuous integral
+ * gain. Integrator state is kept.
+ *
+ * @param p_pi
+ * @param freq_sampling         [Hz]
+ */
+void cfg_dsp_pi_freq(dsp_pi_t *p_pi, float freq_sampling)
+{
+    p_pi->coeffs.s.ki *= p_pi->freq_sampling / freq_sampling;
+    p_pi->freq_sampling = freq_sampling;
+}
+
+/**
+ * Select integrator of PI controller. The compensated integrator carries the
+ * rounding error of each accumulation on u_int_lo, so increments smaller than
+ * the float resolution of u_int (large operating points, small ki or high
+ * sampling frequencies) are not lost. It costs 6 extra FPU additions and one
+ * store/load per sample, and is disabled by default.
+ *
+ * @param p_pi
+ * @param integrator STANDARD_INTEGRATOR or COMPENSATED_INTEGRATOR
+ */
+void cfg_dsp_pi_integrator(dsp_pi_t *p_pi, uint16_t integrator)
+{
+    p_pi->u_int_lo = 0.0;
+    p_pi->integrator = integrator;
+}
+
 /**
  * Reset PI controller.
  *
@@ -258,6 +333,7 @@ void reset_dsp_pi(dsp_pi_t *p_pi)
 {
     p_pi->u_prop = 0.0;
     p_pi->u_int = 0.0;
+    p_pi->u_int_lo = 0.0;
     *(p_pi->out) = 0.0;
 }
 
@@ -270,14 +346,34 @@ void run_dsp_pi(dsp_pi_t *p_pi)
 {
     float dyn_max;
     float dyn_min;
+    float u_int, inc, s, e;
 
     p_pi->u_prop = *(p_pi->in) * p_pi->coeffs.s.kp;
 
     dyn_max = (p_pi->coeffs.s.u_max - p_pi->u_prop);
     dyn_min = (p_pi->coeffs.s.u_min - p_pi->u_prop);
 
-    p_pi->u_int = p_pi->u_int + *(p_pi->in) * p_pi->coeffs.s.ki;
-    SATURATE(p_pi->u_int, dyn_max, dyn_min);
+    if(p_pi->integrator == COMPENSATED_INTEGRATOR)
+    {
+        u_int = p_pi->u_int;
+        inc = *(p_pi->in) * p_pi->coeffs.s.ki + p_pi->u_int_lo;
+        TWO_SUM(s, e, u_int, inc);
+        u_int = s;
+
+        if( (u_int > dyn_max) || (u_int < dyn_min) )
+        {
+            SATURATE(u_int, dyn_max, dyn_min);
+            e = 0.0;
+        }
+
+        p_pi->u_int = u_int;
+        p_pi->u_int_lo = e;
+    }
+    else
+    {
+        p_pi->u_int = p_pi->u_int + *(p_pi->in) * p_pi->coeffs.s.ki;
+        SATURATE(p_pi->u_int, dyn_max, dyn_min);
+    }
 
     *(p_pi->out) = p_pi->u_int + p_pi->u_prop;
 }
@@ -303,6 +399,9 @@ void init_dsp_iir_2p2z(dsp_iir_2p2z_t *p_iir, float b0, float b1, float b2,
 {
     p_iir->w1 = 0.0;
     p_iir->w2 = 0.0;
+    p_iir->w1_lo = 0.0;
+    p_iir->w2_lo = 0.0;
+    p_iir->integrator = STANDARD_INTEGRATOR;
     p_iir->in = in;
     p_iir->out = out;
     *(p_iir->out) = 0.0;
@@ -341,7 +440,7 @@ void init_dsp_notch_2p2z(dsp_iir_2p2z_t *p_iir, float alpha, float freq_cut,
                          float freq_sampling, float u_max, float u_min,
                          volatile float *in, volatile float *out)
 {
-    float beta = cos(2.0 * 3.141592653589793 * (freq_cut/freq_sampling));
+    float beta = DSP_COS(2.0 * 3.141592653589793 * (freq_cut/freq_sampling));
 
     SATURATE(alpha, 0.99999, 0.0);
 
@@ -354,11 +453,33 @@ void init_dsp_notch_2p2z(dsp_iir_2p2z_t *p_iir, float alpha, float freq_cut,
     p_iir->coeffs.s.u_min = u_min;
     p_iir->w1 = 0.0;
     p_iir->w2 = 0.0;
+    p_iir->w1_lo = 0.0;
+    p_iir->w2_lo = 0.0;
+    p_iir->integrator = STANDARD_INTEGRATOR;
     p_iir->in = in;
     p_iir->out = out;
     *(p_iir->out) = 0.0;
 }
 
+/**
+ * Select integrator of 2nd-order digital IIR filter. The compensated
+ * integrator keeps each state as a hi/lo pair and carries the rounding error
+ * of state additions, which matters for filters with poles at or close to
+ * z = 1 (e.g., PI-like controllers). Rounding of products is not compensated,
+ * so it is exact for poles given by powers of two (e.g., a1 = -1). It costs 20
+ * extra FPU operations and 3 store/loads per sample, and is disabled by
+ * default.
+ *
+ * @param p_iir
+ * @param integrator STANDARD_INTEGRATOR or COMPENSATED_INTEGRATOR
+ */
+void cfg_dsp_iir_2p2z_integrator(dsp_iir_2p2z_t *p_iir, uint16_t integrator)
+{
+    p_iir->w1_lo = 0.0;
+    p_iir->w2_lo = 0.0;
+    p_iir->integrator = integrator;
+}
+
 /**
  * Reset 2nd-order digital IIR filter.
  *
@@ -368,6 +489,8 @@ void reset_dsp_iir_2p2z(dsp_iir_2p2z_t *p_iir)
 {
     p_iir->w1 = 0.0;
     p_iir->w2 = 0.0;
+    p_iir->w1_lo = 0.0;
+    p_iir->w2_lo = 0.0;
     *(p_iir->out) = 0.0;
 }
 
@@ -380,6 +503,12 @@ void run_dsp_iir_2p2z(dsp_iir_2p2z_t *p_iir)
 {
     float w0, yacc;
 
+    if(p_iir->integrator == COMPENSATED_INTEGRATOR)
+    {
+        run_dsp_iir_2p2z_compensated(p_iir);
+        return;
+    }
+
     yacc = *(p_iir->in) * p_iir->coeffs.s.b0;
     yacc += p_iir->w1;
 
@@ -421,6 +550,10 @@ void init_dsp_iir_3p3z(dsp_iir_3p3z_t *p_iir, float b0, float b1, float b2,
     p_iir->w1 = 0.0;
     p_iir->w2 = 0.0;
     p_iir->w3 = 0.0;
+    p_iir->w1_lo = 0.0;
+    p_iir->w2_lo = 0.0;
+    p_iir->w3_lo = 0.0;
+    p_iir->integrator = STANDARD_INTEGRATOR;
     p_iir->in = in;
     p_iir->out = out;
     *(p_iir->out) = 0.0;
@@ -443,6 +576,22 @@ void cfg_dsp_iir_3p3z(dsp_iir_3p3z_t *p_iir, float b0, float b1, float b2,
     p_iir->coeffs.s.u_min = u_min;
 }
 
+/**
+ * Select integrator of 3rd-order digital IIR filter. Same as
+ * ```cfg_dsp_iir_2p2z_integrator()```, with 28 extra FPU operations and 4
+ * store/loads per sample.
+ *
+ * @param p_iir
+ * @param integrator STANDARD_INTEGRATOR or COMPENSATED_INTEGRATOR
+ */
+void cfg_dsp_iir_3p3z_integrator(dsp_iir_3p3z_t *p_iir, uint16_t integrator)
+{
+    p_iir->w1_lo = 0.0;
+    p_iir->w2_lo = 0.0;
+    p_iir->w3_lo = 0.0;
+    p_iir->integrator = integrator;
+}
+
 /**
  * Reset 3rd-order digital IIR filter.
  *
@@ -453,6 +602,9 @@ void reset_dsp_iir_3p3z(dsp_iir_3p3z_t *p_iir)
     p_iir->w1 = 0.0;
     p_iir->w2 = 0.0;
     p_iir->w3 = 0.0;
+    p_iir->w1_lo = 0.0;
+    p_iir->w2_lo = 0.0;
+    p_iir->w3_lo = 0.0;
     *(p_iir->out) = 0.0;
 }
 
@@ -465,6 +617,12 @@ void run_dsp_iir_3p3z(dsp_iir_3p3z_t *p_iir)
 {
     float w0, yacc;
 
+    if(p_iir->integrator == COMPENSATED_INTEGRATOR)
+    {
+        run_dsp_iir_3p3z_compensated(p_iir);
+        return;
+    }
+
     yacc = *(p_iir->in) * p_iir->coeffs.s.b0;
     yacc += p_iir->w1;
 
@@ -534,7 +692,12 @@ void run_dsp_vdclink_ff(dsp_vdclink_ff_t *p_ff)
     }
     else
     {
+#ifdef DSP_USE_FAST_MATH
+        *(p_ff->out) = *(p_ff->in) * p_ff->coeffs.s.vdc_nom *
+                       fast_recipf(*(p_ff->vdc_meas));
+#else
         *(p_ff->out) = *(p_ff->in) * p_ff->coeffs.s.vdc_nom / *(p_ff->vdc_meas);
+#endif
     }
 }
 
@@ -603,3 +766,640 @@ void run_dsp_vect_product(dsp_vect_product_t *p_vect_product)
         }
     }
 }
+
+/**
+ * Initialization of redundant sensors voting block. Output is the mean of
+ * non-excluded inputs, and diff is the spread between them. Each input is
+ * checked for:
+ *
+ *      - Frozen value for longer than stuck_time, while other healthy inputs
+ *        are changing
+ *      - Steps larger than max_step between consecutive samples, accumulated
+ *        on a leaky counter which trips above noise_tolerance
+ *      - Disagreement with most of the other healthy inputs by more than
+ *        max_diff (only for 3 or more inputs, since with 2 inputs it's not
+ *        possible to tell which one is wrong)
+ *
+ * Faults from external sources, like sensor status pins, are reported with
+ * set_dsp_redundancy_fault(). A faulty input is excluded as long as at least
+ * one healthy input remains, and the output is transferred to the remaining
+ * inputs with slew-rate limited by max_slewrate_transfer, avoiding steps on
+ * the feedback signal. Faults are latched until reset_dsp_redundancy().
+ *
+ * @param p_red
+ * @param num_inputs            [1 to NUM_MAX_REDUNDANT_INPUTS]
+ * @param max_diff              [units]
+ * @param max_step              [units]
+ * @param stuck_time            [s]
+ * @param noise_tolerance       [num of implausible steps]
+ * @param max_slewrate_transfer [units/s]
+ * @param freq_sampling         [Hz]
+ * @param in                    array of pointers to inputs
+ * @param out
+ * @param diff
+ */
+void init_dsp_redundancy(dsp_redundancy_t *p_red, uint16_t num_inputs,
+                         float max_diff, float max_step, float stuck_time,
+                         float noise_tolerance, float max_slewrate_transfer,
+                         float freq_sampling, volatile float **in,
+                         volatile float *out, volatile float *diff)
+{
+    uint16_t i;
+
+    SATURATE(num_inputs, NUM_MAX_REDUNDANT_INPUTS, 1);
+
+    p_red->num_inputs = num_inputs;
+    p_red->freq_sampling = freq_sampling;
+
+    for(i = 0; i < num_inputs; i++)
+    {
+        p_red->in[i] = in[i];
+    }
+
+    p_red->out = out;
+    p_red->diff = diff;
+    *(p_red->out) = 0.0;
+    *(p_red->diff) = 0.0;
+
+    cfg_dsp_redundancy(p_red, max_diff, max_step, stuck_time, noise_tolerance,
+                       max_slewrate_transfer);
+    reset_dsp_redundancy(p_red);
+}
+
+void cfg_dsp_redundancy(dsp_redundancy_t *p_red, float max_diff,
+                        float max_step, float stuck_time, float noise_tolerance,
+                        float max_slewrate_transfer)
+{
+    float count;
+
+    p_red->coeffs.s.max_diff = max_diff;
+    p_red->coeffs.s.max_step = max_step;
+    p_red->coeffs.s.stuck_time = stuck_time;
+    p_red->coeffs.s.noise_tolerance = noise_tolerance;
+    p_red->coeffs.s.max_slewrate_transfer = max_slewrate_transfer;
+
+    count = stuck_time * p_red->freq_sampling;
+    SATURATE(count, 65535.0, 0.0);
+    p_red->max_count_stuck = (uint16_t) count;
+
+    count = noise_tolerance * REDUNDANCY_NOISE_WEIGHT;
+    SATURATE(count, 65535.0 - REDUNDANCY_NOISE_WEIGHT, 0.0);
+    p_red->max_count_noise = (uint16_t) count;
+
+    if(max_slewrate_transfer > 0.0)
+    {
+        p_red->delta_transfer = max_slewrate_transfer / p_red->freq_sampling;
+    }
+    else
+    {
+        p_red->delta_transfer = 0.0;
+        p_red->offset_transfer = 0.0;
+    }
+}
+
+/**
+ * Reset redundant sensors voting block. All faults are cleared and excluded
+ * inputs are brought back to voting.
+ *
+ * @param p_red
+ */
+void reset_dsp_redundancy(dsp_redundancy_t *p_red)
+{
+    uint16_t i;
+
+    for(i = 0; i < p_red->num_inputs; i++)
+    {
+        p_red->counter_stuck[i] = 0;
+        p_red->counter_noise[i] = 0;
+        p_red->in_old[i] = *(p_red->in[i]);
+    }
+
+    p_red->fault = 0;
+    exclude_dsp_redundancy_inputs(p_red, 0);
+}
+
+/**
+ * Report fault on specified input, detected by an external source. If there
+ * are remaining healthy inputs, it is excluded immediately. Caller must
+ * ensure this is not preempted by run_dsp_redundancy().
+ *
+ * @param p_red
+ * @param id
+ */
+void set_dsp_redundancy_fault(dsp_redundancy_t *p_red, uint16_t id)
+{
+    uint16_t all_inputs;
+
+    all_inputs = (1 << p_red->num_inputs) - 1;
+
+    p_red->fault |= (1 << id) & all_inputs;
+
+    if( (p_red->fault != p_red->excluded) && (p_red->fault != all_inputs) )
+    {
+        exclude_dsp_redundancy_inputs(p_red, p_red->fault);
+    }
+}
+
+/**
+ * Run redundant sensors voting block.
+ *
+ * @param p_red
+ */
+void run_dsp_redundancy(dsp_redundancy_t *p_red)
+{
+    uint16_t i, j, bit, all_inputs, num_moving, num_valid, num_disagree;
+    uint16_t new_fault;
+    float in, delta, sum, in_max, in_min;
+
+    num_moving = 0;
+
+    /// Checks based on each input history
+    for(i = 0; i < p_red->num_inputs; i++)
+    {
+        bit = 1 << i;
+        in = *(p_red->in[i]);
+        delta = fabs(in - p_red->in_old[i]);
+        p_red->in_old[i] = in;
+
+        if(delta == 0.0)
+        {
+            if(p_red->counter_stuck[i] < p_red->max_count_stuck)
+            {
+                p_red->counter_stuck[i]++;
+            }
+        }
+        else
+        {
+            p_red->counter_stuck[i] = 0;
+
+            if(!(p_red->fault & bit))
+            {
+                num_moving++;
+            }
+        }
+
+        if(p_red->coeffs.s.max_step > 0.0)
+        {
+            if(delta > p_red->coeffs.s.max_step)
+            {
+                p_red->counter_noise[i] += REDUNDANCY_NOISE_WEIGHT;
+
+                if(p_red->counter_noise[i] > p_red->max_count_noise)
+                {
+                    p_red->counter_noise[i] = p_red->max_count_noise;
+                    p_red->fault |= bit;
+                }
+            }
+            else if(p_red->counter_noise[i])
+            {
+                p_red->counter_noise[i]--;
+            }
+        }
+    }
+
+    /// Frozen inputs are only attributed if another healthy input is changing
+    if(p_red->max_count_stuck && num_moving)
+    {
+        for(i = 0; i < p_red->num_inputs; i++)
+        {
+            if(p_red->counter_stuck[i] >= p_red->max_count_stuck)
+            {
+                p_red->fault |= (1 << i);
+            }
+        }
+    }
+
+    /// Cross-comparison: input disagreeing with most of the others is faulty
+    if( (p_red->num_inputs > 2) && (p_red->coeffs.s.max_diff > 0.0) )
+    {
+        new_fault = 0;
+
+        for(i = 0; i < p_red->num_inputs; i++)
+        {
+            if(p_red->fault & (1 << i))
+            {
+                continue;
+            }
+
+            num_valid = 0;
+            num_disagree = 0;
+
+            for(j = 0; j < p_red->num_inputs; j++)
+            {
+                if( (j != i) && !(p_red->fault & (1 << j)) )
+                {
+                    num_valid++;
+
+                    if(fabs(p_red->in_old[i] - p_red->in_old[j]) >
+                       p_red->coeffs.s.max_diff)
+                    {
+                        num_disagree++;
+                    }
+                }
+            }
+
+            if(2*num_disagree > num_valid)
+            {
+                new_fault |= (1 << i);
+            }
+        }
+
+        p_red->fault |= new_fault;
+    }
+
+    /// Exclude faulty inputs, unless there's no healthy one left
+    all_inputs = (1 << p_red->num_inputs) - 1;
+
+    if( (p_red->fault != p_red->excluded) && (p_red->fault != all_inputs) )
+    {
+        exclude_dsp_redundancy_inputs(p_red, p_red->fault);
+    }
+
+    /// Vote with remaining inputs
+    sum = 0.0;
+    in_max = 0.0;
+    in_min = 0.0;
+    num_valid = 0;
+
+    for(i = 0; i < p_red->num_inputs; i++)
+    {
+        if(!(p_red->excluded & (1 << i)))
+        {
+            in = p_red->in_old[i];
+            sum += in;
+
+            if( (num_valid == 0) || (in > in_max) )
+            {
+                in_max = in;
+            }
+
+            if( (num_valid == 0) || (in < in_min) )
+            {
+                in_min = in;
+            }
+
+            num_valid++;
+        }
+    }
+
+    delta = p_red->offset_transfer;
+    SATURATE(delta, p_red->delta_transfer, -p_red->delta_transfer);
+    p_red->offset_transfer -= delta;
+
+    *(p_red->out) = sum * p_red->gain_mean + p_red->offset_transfer;
+    *(p_red->diff) = in_max - in_min;
+}
+
+/**
+ * Update set of excluded inputs. Current output is kept by an offset, which is
+ * removed by run_dsp_redundancy() with limited slew-rate.
+ *
+ * @param p_red
+ * @param excluded
+ */
+static void exclude_dsp_redundancy_inputs(dsp_redundancy_t *p_red,
+                                          uint16_t excluded)
+{
+    uint16_t i, num_valid;
+    float sum;
+
+    p_red->excluded = excluded;
+
+    sum = 0.0;
+    num_valid = 0;
+
+    for(i = 0; i < p_red->num_inputs; i++)
+    {
+        if(!(excluded & (1 << i)))
+        {
+            sum += p_red->in_old[i];
+            num_valid++;
+        }
+    }
+
+    p_red->gain_mean = 1.0 / (float) num_valid;
+
+    if(p_red->delta_transfer > 0.0)
+    {
+        p_red->offset_transfer = *(p_red->out) - sum * p_red->gain_mean;
+    }
+    else
+    {
+        p_red->offset_transfer = 0.0;
+    }
+}
+
+/**
+ * Run 2nd-order digital IIR filter with compensated states. Each state is kept
+ * as a hi/lo pair, and rounding errors from additions of hi parts are carried
+ * on lo parts, together with the small terms of the recursion.
+ *
+ * @param p_iir
+ */
+static void run_dsp_iir_2p2z_compensated(dsp_iir_2p2z_t *p_iir)
+{
+    float x, yacc, y_lo, w, p, t, s, e;
+
+    x = *(p_iir->in);
+
+    /// yacc = b0*x + w1
+    w = p_iir->w1;
+    t = x * p_iir->coeffs.s.b0 + p_iir->w1_lo;
+    TWO_SUM(s, y_lo, w, t);
+    yacc = s;
+
+    if( (yacc > p_iir->coeffs.s.u_max) || (yacc < p_iir->coeffs.s.u_min) )
+    {
+        SATURATE(yacc, p_iir->coeffs.s.u_max, p_iir->coeffs.s.u_min);
+        y_lo = 0.0;
+    }
+
+    /// w1 = b1*x + w2 - a1*yacc
+    w = p_iir->w2;
+    p = -yacc * p_iir->coeffs.s.a1;
+    TWO_SUM(s, e, w, p);
+    w = s;
+    t = x * p_iir->coeffs.s.b1 - y_lo * p_iir->coeffs.s.a1 + p_iir->w2_lo + e;
+    TWO_SUM(s, e, w, t);
+    p_iir->w1 = s;
+    p_iir->w1_lo = e;
+
+    /// w2 = b2*x - a2*yacc
+    p = -yacc * p_iir->coeffs.s.a2;
+    t = x * p_iir->coeffs.s.b2 - y_lo * p_iir->coeffs.s.a2;
+    TWO_SUM(s, e, p, t);
+    p_iir->w2 = s;
+    p_iir->w2_lo = e;
+
+    *(p_iir->out) = yacc;
+}
+
+/**
+ * Run 3rd-order digital IIR filter with compensated states. See
+ * ```run_dsp_iir_2p2z_compensated()```.
+ *
+ * @param p_iir
+ */
+static void run_dsp_iir_3p3z_compensated(dsp_iir_3p3z_t *p_iir)
+{
+    float x, yacc, y_lo, w, p, t, s, e;
+
+    x = *(p_iir->in);
+
+    /// yacc = b0*x + w1
+    w = p_iir->w1;
+    t = x * p_iir->coeffs.s.b0 + p_iir->w1_lo;
+    TWO_SUM(s, y_lo, w, t);
+    yacc = s;
+
+    if( (yacc > p_iir->coeffs.s.u_max) || (yacc < p_iir->coeffs.s.u_min) )
+    {
+        SATURATE(yacc, p_iir->coeffs.s.u_max, p_iir->coeffs.s.u_min);
+        y_lo = 0.0;
+    }
+
+    /// w1 = b1*x + w2 - a1*yacc
+    w = p_iir->w2;
+    p = -yacc * p_iir->coeffs.s.a1;
+    TWO_SUM(s, e, w, p);
+    w = s;
+    t = x * p_iir->coeffs.s.b1 - y_lo * p_iir->coeffs.s.a1 + p_iir->w2_lo + e;
+    TWO_SUM(s, e, w, t);
+    p_iir->w1 = s;
+    p_iir->w1_lo = e;
+
+    /// w2 = b2*x + w3 - a2*yacc
+    w = p_iir->w3;
+    p = -yacc * p_iir->coeffs.s.a2;
+    TWO_SUM(s, e, w, p);
+    w = s;
+    t = x * p_iir->coeffs.s.b2 - y_lo * p_iir->coeffs.s.a2 + p_iir->w3_lo + e;
+    TWO_SUM(s, e, w, t);
+    p_iir->w2 = s;
+    p_iir->w2_lo = e;
+
+    /// w3 = b3*x - a3*yacc
+    p = -yacc * p_iir->coeffs.s.a3;
+    t = x * p_iir->coeffs.s.b3 - y_lo * p_iir->coeffs.s.a3;
+    TWO_SUM(s, e, p, t);
+    p_iir->w3 = s;
+    p_iir->w3_lo = e;
+
+    *(p_iir->out) = yacc;
+}
+
+/**
+ * Initialization of current share controller bank. It runs one PI controller
+ * for each of num_inputs currents, which are split in groups of group_size
+ * consecutive inputs (e.g. IGBTs from the same module) that must share current
+ * equally. Error of each input is taken against a reference built from the
+ * other inputs of its group:
+ *
+ *      - DSP_Share_Average: mean of the other inputs
+ *      - DSP_Share_Daisy_Chain: previous input, wrapping around the group
+ *
+ * For groups of two inputs, both modes are the same as a PI controller fed
+ * with the difference between currents. Outputs from each group are forced to
+ * sum to zero, so corrections don't change mean duty cycle, and are scaled
+ * down together when any of them exceeds limits.
+ *
+ * @param p_share
+ * @param num_inputs    [2 to NUM_MAX_SHARE_INPUTS], multiple of group_size
+ * @param group_size    [2 to num_inputs]
+ * @param mode
+ * @param kp
+ * @param ki
+ * @param freq_sampling [Hz]
+ * @param u_max         [>= 0.0]
+ * @param u_min         [<= 0.0]
+ * @param in            array of pointers to inputs
+ * @param out           array of pointers to outputs
+ */
+void init_dsp_share(dsp_share_t *p_share, uint16_t num_inputs,
+                    uint16_t group_size, dsp_share_mode_t mode,
+                    float kp, float ki, float freq_sampling,
+                    float u_max, float u_min, volatile float **in,
+                    volatile float **out)
+{
+    uint16_t i;
+
+    SATURATE(num_inputs, NUM_MAX_SHARE_INPUTS, 2);
+    SATURATE(group_size, num_inputs, 2);
+
+    /// Inputs from an incomplete last group are ignored
+    num_inputs -= num_inputs % group_size;
+
+    p_share->num_inputs = num_inputs;
+    p_share->group_size = group_size;
+    p_share->gain_ref = 1.0 / (float) (group_size - 1);
+    p_share->gain_group = 1.0 / (float) group_size;
+    p_share->freq_sampling = freq_sampling;
+
+    for(i = 0; i < num_inputs; i++)
+    {
+        p_share->in[i] = in[i];
+        p_share->out[i] = out[i];
+    }
+
+    cfg_dsp_share_mode(p_share, mode);
+    cfg_dsp_share(p_share, kp, ki, u_max, u_min);
+    reset_dsp_share(p_share);
+}
+
+void cfg_dsp_share(dsp_share_t *p_share, float kp, float ki, float u_max,
+                   float u_min)
+{
+    p_share->coeffs.s.kp = kp;
+    p_share->coeffs.s.ki = ki / p_share->freq_sampling;
+    p_share->coeffs.s.u_max = (u_max > 0.0) ? u_max : 0.0;
+    p_share->coeffs.s.u_min = (u_min < 0.0) ? u_min : 0.0;
+}
+
+/**
+ * Change sampling frequency of current share controller bank, keeping its
+ * continuous integral gain. Integrators state is kept.
+ *
+ * @param p_share
+ * @param freq_sampling [Hz]
+ */
+void cfg_dsp_share_freq(dsp_share_t *p_share, float freq_sampling)
+{
+    p_share->coeffs.s.ki *= p_share->freq_sampling / freq_sampling;
+    p_share->freq_sampling = freq_sampling;
+}
+
+void cfg_dsp_share_mode(dsp_share_t *p_share, dsp_share_mode_t mode)
+{
+    p_share->mode = mode;
+}
+
+void reset_dsp_share(dsp_share_t *p_share)
+{
+    uint16_t i;
+
+    for(i = 0; i < p_share->num_inputs; i++)
+    {
+        p_share->error[i] = 0.0;
+        p_share->u_int[i] = 0.0;
+        p_share->u[i] = 0.0;
+        *(p_share->out[i]) = 0.0;
+    }
+}
+
+/**
+ * Run current share controller bank. Each group goes through errors
+ * calculation, PI controllers with the same anti-windup from run_dsp_pi(), and
+ * zero-sum enforcement. The last step only acts when outputs don't already sum
+ * to zero, which happens when individual controllers saturate on asymmetric
+ * limits. In this case, integrators are recalculated from scaled outputs.
+ *
+ * @param p_share
+ */
+void run_dsp_share(dsp_share_t *p_share)
+{
+    uint16_t i, j, first, end;
+    float in[NUM_MAX_SHARE_INPUTS];
+    float error, u_prop, dyn_max, dyn_min, sum, u_max, u_min, gain;
+
+    for(first = 0; first < p_share->num_inputs; first += p_share->group_size)
+    {
+        end = first + p_share->group_size;
+
+        /// Inputs are read once, so all errors use the same samples
+        for(i = first; i < end; i++)
+        {
+            in[i] = *(p_share->in[i]);
+        }
+
+        /// Errors against reference from the other inputs of the group
+        for(i = first; i < end; i++)
+        {
+            if(p_share->mode == DSP_Share_Daisy_Chain)
+            {
+                j = (i == first) ? (end - 1) : (i - 1);
+                error = in[j] - in[i];
+            }
+            else
+            {
+                error = 0.0;
+
+                for(j = first; j < end; j++)
+                {
+                    if(j != i)
+                    {
+                        error += in[j] - in[i];
+                    }
+                }
+
+                error *= p_share->gain_ref;
+            }
+
+            p_share->error[i] = error;
+        }
+
+        /// PI controllers
+        sum = 0.0;
+
+        for(i = first; i < end; i++)
+        {
+            u_prop = p_share->error[i] * p_share->coeffs.s.kp;
+
+            dyn_max = (p_share->coeffs.s.u_max - u_prop);
+            dyn_min = (p_share->coeffs.s.u_min - u_prop);
+
+            p_share->u_int[i] = p_share->u_int[i] +
+                                p_share->error[i] * p_share->coeffs.s.ki;
+            SATURATE(p_share->u_int[i], dyn_max, dyn_min);
+
+            p_share->u[i] = p_share->u_int[i] + u_prop;
+            sum += p_share->u[i];
+        }
+
+        /// Zero-sum enforcement, scaling whole group back into limits
+        if(sum != 0.0)
+        {
+            sum *= p_share->gain_group;
+            u_max = 0.0;
+            u_min = 0.0;
+
+            for(i = first; i < end; i++)
+            {
+                p_share->u[i] -= sum;
+
+                if(p_share->u[i] > u_max)
+                {
+                    u_max = p_share->u[i];
+                }
+
+                if(p_share->u[i] < u_min)
+                {
+                    u_min = p_share->u[i];
+                }
+            }
+
+            gain = 1.0;
+
+            if(u_max > p_share->coeffs.s.u_max)
+            {
+                gain = p_share->coeffs.s.u_max / u_max;
+            }
+
+            if(gain * u_min < p_share->coeffs.s.u_min)
+            {
+                gain = p_share->coeffs.s.u_min / u_min;
+            }
+
+            for(i = first; i < end; i++)
+            {
+                p_share->u[i] *= gain;
+                p_share->u_int[i] = p_share->u[i] -
+                                    p_share->error[i] * p_share->coeffs.s.kp;
+            }
+        }
+
+        for(i = first; i < end; i++)
+        {
+            *(p_share->out[i]) = p_share->u[i];
+        }
+    }
+}
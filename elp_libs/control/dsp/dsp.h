@@ -34,13 +34,35 @@
 #define SATURATE(var, max, min)     if(var > max) var = max;    \
                                     if(var < min) var = min;
 
+/**
+ * Uncomment to select fast math library (common/fast_math.h) instead of RTS
+ * library for DSP modules runtime and coefficients calculation. C28x FPU32 has
+ * no divide instruction, so RTS division is a software routine, while
+ * fast_recipf() uses EINVF32 estimate followed by Newton-Raphson iterations.
+ * See common/fast_math.h for error bounds.
+ */
+//#define DSP_USE_FAST_MATH
+
 #define USE_MODULE              0
 #define BYPASS_MODULE           1
 
+/**
+ * Integrator selection of PI and IIR modules. Compensated integrator state
+ * (u_int_lo, wN_lo) and selector fields were added to dsp_pi_t,
+ * dsp_iir_2p2z_t and dsp_iir_3p3z_t, which changes offsets of dsp_modules_t
+ * within g_controller_ctom and g_controller_mtoc. ARM firmware must be built
+ * with this header to access DSP coefficients and states.
+ */
+#define STANDARD_INTEGRATOR     0
+#define COMPENSATED_INTEGRATOR  1
+
 #define NUM_MAX_MATRIX_SIZE     12
 #define NUM_MAX_COEFFS_DSP      NUM_MAX_MATRIX_SIZE
 
-#define NUM_DSP_CLASSES         8
+#define NUM_DSP_CLASSES         10
+
+#define NUM_MAX_REDUNDANT_INPUTS    4
+#define NUM_MAX_SHARE_INPUTS        8
 
 #define NUM_COEFFS_DSP_SRLIM        1
 #define NUM_COEFFS_DSP_LPF          1
@@ -49,6 +71,8 @@
 #define NUM_COEFFS_DSP_IIR_3P3Z     16
 #define NUM_COEFFS_DSP_VDCLINK_FF   2
 #define NUM_COEFFS_DSP_MATRIX       (2 + NUM_MAX_MATRIX_SIZE*NUM_MAX_MATRIX_SIZE)
+#define NUM_COEFFS_DSP_REDUNDANCY   5
+#define NUM_COEFFS_DSP_SHARE        4
 
 typedef enum
 {
@@ -59,9 +83,17 @@ typedef enum
     DSP_IIR_2P2Z,
     DSP_IIR_3P3Z,
     DSP_VdcLink_FeedForward,
-    DSP_Vect_Product
+    DSP_Vect_Product,
+    DSP_Redundancy,
+    DSP_Share
 } dsp_class_t;
 
+typedef enum
+{
+    DSP_Share_Average,
+    DSP_Share_Daisy_Chain
+} dsp_share_mode_t;
+
 typedef volatile struct
 {
     dsp_class_t dsp_class;
@@ -129,6 +161,8 @@ typedef volatile struct
     float freq_sampling;
     float u_prop;
     float u_int;
+    float u_int_lo;
+    uint16_t integrator;
     volatile float *in;
     volatile float *out;
 } dsp_pi_t;
@@ -152,6 +186,9 @@ typedef volatile struct
 
     float w1;
     float w2;
+    float w1_lo;
+    float w2_lo;
+    uint16_t integrator;
     volatile float *in;
     volatile float *out;
 } dsp_iir_2p2z_t;
@@ -178,6 +215,10 @@ typedef volatile struct
     float w1;
     float w2;
     float w3;
+    float w1_lo;
+    float w2_lo;
+    float w3_lo;
+    uint16_t integrator;
     volatile float *in;
     volatile float *out;
 } dsp_iir_3p3z_t;
@@ -220,6 +261,75 @@ typedef volatile struct
     volatile float  *out;
 } dsp_vect_product_t;
 
+/**
+ * Redundant sensors voting block. Inputs are bits 0 to (num_inputs - 1) on
+ * fault and excluded bitmasks. A coefficient equal to zero disables the
+ * respective check.
+ */
+typedef volatile struct
+{
+    union
+    {
+        float f[NUM_COEFFS_DSP_REDUNDANCY];
+        struct
+        {
+            float max_diff;                 // [units]
+            float max_step;                 // [units/sample]
+            float stuck_time;               // [s]
+            float noise_tolerance;          // [num of implausible steps]
+            float max_slewrate_transfer;    // [units/s]
+        } s;
+    } coeffs;
+
+    float freq_sampling;
+    float delta_transfer;
+    float offset_transfer;
+    float gain_mean;
+    float in_old[NUM_MAX_REDUNDANT_INPUTS];
+    uint16_t num_inputs;
+    uint16_t max_count_stuck;
+    uint16_t max_count_noise;
+    uint16_t counter_stuck[NUM_MAX_REDUNDANT_INPUTS];
+    uint16_t counter_noise[NUM_MAX_REDUNDANT_INPUTS];
+    uint16_t fault;
+    uint16_t excluded;
+    volatile float *in[NUM_MAX_REDUNDANT_INPUTS];
+    volatile float *out;
+    volatile float *diff;
+} dsp_redundancy_t;
+
+/**
+ * Current share controller bank. Inputs are split in groups of group_size
+ * consecutive currents, which must be equal, and each input has its own PI
+ * controller. All controllers share coefficients and saturation limits.
+ */
+typedef volatile struct
+{
+    union
+    {
+        float f[NUM_COEFFS_DSP_SHARE];
+        struct
+        {
+            float kp;
+            float ki;
+            float u_max;                    // Must be >= 0.0
+            float u_min;                    // Must be <= 0.0
+        } s;
+    } coeffs;
+
+    float freq_sampling;
+    float gain_ref;
+    float gain_group;
+    float error[NUM_MAX_SHARE_INPUTS];
+    float u_int[NUM_MAX_SHARE_INPUTS];
+    float u[NUM_MAX_SHARE_INPUTS];
+    uint16_t num_inputs;
+    uint16_t group_size;
+    dsp_share_mode_t mode;
+    volatile float *in[NUM_MAX_SHARE_INPUTS];
+    volatile float *out[NUM_MAX_SHARE_INPUTS];
+} dsp_share_t;
+
 
 extern void init_dsp_error(dsp_error_t *p_error, volatile float *pos,
                              volatile float *neg, volatile float *error);
@@ -231,6 +341,7 @@ extern void init_dsp_srlim(dsp_srlim_t *p_srlim, float max_slewrate,
                              float freq_sampling, volatile float *in,
                              volatile float *out);
 extern void cfg_dsp_srlim(dsp_srlim_t *p_srlim, float max_slewrate);
+extern void cfg_dsp_srlim_freq(dsp_srlim_t *p_srlim, float freq_sampling);
 extern void bypass_dsp_srlim(dsp_srlim_t *p_srlim, uint16_t bypass);
 extern void reset_dsp_srlim(dsp_srlim_t *p_srlim);
 extern void run_dsp_srlim(dsp_srlim_t *p_srlim, uint16_t bypass);
@@ -248,6 +359,8 @@ extern void init_dsp_pi(dsp_pi_t *p_pi, float kp, float ki, float freq_sampling,
                         volatile float *out);
 extern void cfg_dsp_pi(dsp_pi_t *p_pi, float kp, float ki, float u_max,
                        float u_min);
+extern void cfg_dsp_pi_freq(dsp_pi_t *p_pi, float freq_sampling);
+extern void cfg_dsp_pi_integrator(dsp_pi_t *p_pi, uint16_t integrator);
 extern void reset_dsp_pi(dsp_pi_t *p_pi);
 extern void run_dsp_pi(dsp_pi_t *p_pi);
 
@@ -262,6 +375,8 @@ extern void init_dsp_notch_2p2z(dsp_iir_2p2z_t *p_iir, float alpha,
                                 volatile float *out);
 extern void cfg_dsp_iir_2p2z(dsp_iir_2p2z_t *p_iir, float b0, float b1, float b2,
                              float a1, float a2, float u_max, float u_min);
+extern void cfg_dsp_iir_2p2z_integrator(dsp_iir_2p2z_t *p_iir,
+                                       uint16_t integrator);
 extern void reset_dsp_iir_2p2z(dsp_iir_2p2z_t *p_iir);
 extern void run_dsp_iir_2p2z(dsp_iir_2p2z_t *p_iir);
 
@@ -273,6 +388,8 @@ extern void init_dsp_iir_3p3z(dsp_iir_3p3z_t *p_iir, float b0, float b1,
 extern void cfg_dsp_iir_3p3z(dsp_iir_3p3z_t *p_iir, float b0, float b1, float b2,
                              float b3, float a1, float a2, float a3, float u_max,
                              float u_min);
+extern void cfg_dsp_iir_3p3z_integrator(dsp_iir_3p3z_t *p_iir,
+                                       uint16_t integrator);
 extern void reset_dsp_iir_3p3z(dsp_iir_3p3z_t *p_iir);
 extern void run_dsp_iir_3p3z(dsp_iir_3p3z_t *p_iir);
 
@@ -293,4 +410,31 @@ extern void init_dsp_vect_product(dsp_vect_product_t *p_vect_product,
 extern void reset_dsp_vect_product(dsp_vect_product_t *p_vect_product);
 extern void run_dsp_vect_product(dsp_vect_product_t *p_vect_product);
 
+
+extern void init_dsp_redundancy(dsp_redundancy_t *p_red, uint16_t num_inputs,
+                                float max_diff, float max_step,
+                                float stuck_time, float noise_tolerance,
+                                float max_slewrate_transfer,
+                                float freq_sampling, volatile float **in,
+                                volatile float *out, volatile float *diff);
+extern void cfg_dsp_redundancy(dsp_redundancy_t *p_red, float max_diff,
+                               float max_step, float stuck_time,
+                               float noise_tolerance,
+                               float max_slewrate_transfer);
+extern void reset_dsp_redundancy(dsp_redundancy_t *p_red);
+extern void set_dsp_redundancy_fault(dsp_redundancy_t *p_red, uint16_t id);
+extern void run_dsp_redundancy(dsp_redundancy_t *p_red);
+
+extern void init_dsp_share(dsp_share_t *p_share, uint16_t num_inputs,
+                           uint16_t group_size, dsp_share_mode_t mode,
+                           float kp, float ki, float freq_sampling,
+                           float u_max, float u_min, volatile float **in,
+                           volatile float **out);
+extern void cfg_dsp_share(dsp_share_t *p_share, float kp, float ki,
+                          float u_max, float u_min);
+extern void cfg_dsp_share_freq(dsp_share_t *p_share, float freq_sampling);
+extern void cfg_dsp_share_mode(dsp_share_t *p_share, dsp_share_mode_t mode);
+extern void reset_dsp_share(dsp_share_t *p_share);
+extern void run_dsp_share(dsp_share_t *p_share);
+
 #endif /* DSP_H_ */
@@ -27,6 +27,14 @@
 #include "control/control.h"
 #include "ipc/ipc.h"
 
+/**
+ * Whether sync pulse ISR is being serviced for XINT2 vector, instead of
+ * MTOCIPC_INT2, given by address of PIE vector fetched by CPU. It must be read
+ * before re-enabling interrupts.
+ */
+#define IS_SYNC_PULSE_XINT2     (PieCtrlRegs.PIECTRL.bit.PIEVECT ==          \
+                                 (((uint16_t) &PieVectTable.XINT2) >> 1))
+
 #pragma DATA_SECTION(g_buf_samples_ctom,"SHARERAMS67")
 volatile float g_buf_samples_ctom[SIZE_BUF_SAMPLES_CTOM];
 
@@ -35,9 +43,43 @@ volatile float g_buf_samples_ctom[SIZE_BUF_SAMPLES_CTOM];
 volatile ipc_ctom_t g_ipc_ctom;
 volatile ipc_mtoc_t g_ipc_mtoc;
 
+#pragma DATA_SECTION(g_ipc_latency,"SHARERAMS1_1");
+ipc_latency_t g_ipc_latency;
+
 volatile uint32_t counter_sync_period = MIN_NUM_ISR_CONTROLLER_SYNC;
 
+/**
+ * Deferred work queue. It's written by IPC low priority ISR (head) and read by
+ * background executor (tail), so each index has a single writer.
+ */
+typedef volatile struct
+{
+    uint32_t    msg_mtoc;
+    uint32_t    timestamp;
+    uint16_t    msg_id;
+} ipc_deferred_work_t;
+
+static ipc_deferred_work_t ipc_deferred_queue[SIZE_IPC_DEFERRED_QUEUE];
+static volatile uint16_t ipc_deferred_head = 0;
+static volatile uint16_t ipc_deferred_tail = 0;
+
+/**
+ * Set while a message taken from deferred work queue is executed, so setpoint
+ * lane messages received meanwhile are queued behind it, keeping their order
+ */
+static volatile uint16_t ipc_deferred_busy = 0;
+
+static ipc_deferred_work_t ipc_deferred_done;
+static uint16_t ipc_deferred_done_pending = 0;
+
+/**
+ * ARM timestamps of messages processed but not yet applied by isr_controller
+ */
+static uint32_t ipc_latency_timestamp[NUM_IPC_LATENCY_MSG];
+
 #pragma CODE_SECTION(isr_ipc_sync_pulse,"ramfuncs");
+#pragma CODE_SECTION(run_ipc_latency,"ramfuncs");
+#pragma CODE_SECTION(start_siggen_ahead,"ramfuncs");
 
 /**
  * Interrupt service routine for handling Low Priority MtoC IPC messages
@@ -49,6 +91,16 @@ interrupt void isr_ipc_lowpriority_msg(void);
  */
 interrupt void isr_ipc_sync_pulse(void);
 
+static uint16_t is_ipc_msg_setpoint(uint16_t msg);
+static error_mtoc_t run_ipc_msg(uint16_t msg, uint16_t msg_id);
+static void hold_ipc_interlocks(void);
+static void release_ipc_interlocks(void);
+static void cfg_siggen_deferred(uint16_t id);
+static void reset_ipc_latency_stats(uint16_t msg);
+static void post_ipc_deferred_work(uint16_t msg_id);
+static void post_ipc_latency(uint16_t msg, uint32_t timestamp);
+static void start_siggen_ahead(uint16_t id);
+
 /**
  * Initialization of interprocessor communication (IPC)
  *
@@ -66,10 +118,13 @@ void init_ipc(void)
     g_ipc_ctom.msg_mtoc = 0;
     g_ipc_ctom.msg_id = 0;
     g_ipc_ctom.error_mtoc = No_Error_MtoC;
+    g_ipc_ctom.msg_mtoc_done = 0;
     g_ipc_ctom.counter_set_slowref =  0;
     g_ipc_ctom.counter_sync_pulse =  0;
     g_ipc_ctom.period_sync_pulse =  0;
 
+    reset_ipc_latency();
+
     EALLOW;
 
     /**
@@ -180,298 +235,772 @@ void send_ipc_lowpriority_msg(uint16_t msg_id, ipc_ctom_lowpriority_msg_t msg)
 }
 
 /**
- * Interrupt Service Routine for IPC MtoC Low Priority Messages.
+ * Mark a processed MtoC message to have its latency accounted on next
+ * isr_controller. It must be called with interrupts disabled.
+ *
+ * @param msg MtoC low priority message, or IPC_LATENCY_SYNC_SETPOINT
+ * @param timestamp ARM timestamp of message
  */
-interrupt void isr_ipc_lowpriority_msg(void)
+static void post_ipc_latency(uint16_t msg, uint32_t timestamp)
+{
+    if(msg < NUM_IPC_LATENCY_MSG)
+    {
+        ipc_latency_timestamp[msg] = timestamp;
+        g_ipc_latency.pending |= ((uint32_t) 1) << msg;
+    }
+}
+
+/**
+ * Complete reference calculated ahead (see LATCH_PS_REFERENCE) for siggen
+ * started by a sync pulse. It was calculated while siggen was disabled, with
+ * its parameters already updated, so only the first siggen sample is missing.
+ * Siggen output is ps_reference, which is preserved.
+ *
+ * @param id ps module id
+ */
+static void start_siggen_ahead(uint16_t id)
 {
-    static uint16_t i, msg_id;
+    float reference;
 
-    g_ipc_ctom.msg_mtoc = CtoMIpcRegs.MTOCIPCSTS.all;
-    CtoMIpcRegs.MTOCIPCACK.all = g_ipc_ctom.msg_mtoc;
+    if(g_ps_reference_ctrl[id].reference_ahead)
+    {
+        reference = g_ipc_ctom.ps_module[id].ps_reference;
+        g_ipc_ctom.ps_module[id].ps_reference =
+                                    g_ps_reference_ctrl[id].ps_reference_next;
 
-    msg_id = g_ipc_mtoc.msg_id;
+        SIGGEN_CTOM[id].p_run_siggen(&SIGGEN_CTOM[id]);
+
+        g_ps_reference_ctrl[id].ps_reference_next =
+                                    g_ipc_ctom.ps_module[id].ps_reference;
+        g_ipc_ctom.ps_module[id].ps_reference = reference;
+    }
+}
+
+/**
+ * Account latency of all pending MtoC messages. It must be called from
+ * isr_controller, after new references have been applied, through
+ * RUN_IPC_LATENCY macro.
+ */
+void run_ipc_latency(void)
+{
+    uint16_t i, bin;
+    uint32_t now, pending, latency;
+
+    now = IPC_TIMESTAMP;
+    pending = g_ipc_latency.pending;
+    g_ipc_latency.pending = 0;
 
-    if(g_ipc_ctom.ps_module[msg_id].ps_status.bit.active)
+    for(i = 0; pending != 0; i++, pending >>= 1)
     {
-        switch(GET_IPC_MTOC_LOWPRIORITY_MSG)
+        if(pending & 0x00000001)
         {
-            case Turn_On:
-            {
-                /**
-                 * TODO: where should disable siggen + reset wfmref be?
-                 */
-                g_ipc_ctom.ps_module[msg_id].turn_on(msg_id);
-                break;
-            }
+            latency = now - ipc_latency_timestamp[i];
+
+            g_ipc_latency.stats[i].counter++;
+            g_ipc_latency.stats[i].sum += latency;
 
-            case Turn_Off:
+            if(latency < g_ipc_latency.stats[i].min)
             {
-                /**
-                 * TODO: where should disable siggen + reset wfmref be?
-                 */
-                g_ipc_ctom.ps_module[msg_id].turn_off(msg_id);
-                break;
+                g_ipc_latency.stats[i].min = latency;
             }
 
-            case Open_Loop:
+            if(latency > g_ipc_latency.stats[i].max)
             {
-                open_loop(&g_ipc_ctom.ps_module[msg_id]);
-                break;
+                g_ipc_latency.stats[i].max = latency;
             }
 
-            case Close_Loop:
+            latency >>= IPC_LATENCY_HIST_SHIFT;
+
+            for(bin = 0; (latency != 0) && (bin < NUM_IPC_LATENCY_HIST_BINS - 1); bin++)
             {
-                close_loop(&g_ipc_ctom.ps_module[msg_id]);
-                break;
+                latency >>= 1;
             }
 
-            case Operating_Mode:
+            g_ipc_latency.stats[i].hist[bin]++;
+        }
+    }
+}
+
+/**
+ * Reset latency statistics of all MtoC messages. Mean latency may be obtained
+ * from sum/counter.
+ */
+void reset_ipc_latency(void)
+{
+    uint16_t i;
+
+    for(i = 0; i < NUM_IPC_LATENCY_MSG; i++)
+    {
+        reset_ipc_latency_stats(i);
+    }
+}
+
+/**
+ * Reset latency statistics of specified MtoC message, and discard its pending
+ * measurement.
+ *
+ * @param msg MtoC low priority message, or IPC_LATENCY_SYNC_SETPOINT
+ */
+static void reset_ipc_latency_stats(uint16_t msg)
+{
+    uint16_t j;
+
+    g_ipc_latency.pending &= ~(((uint32_t) 1) << msg);
+
+    g_ipc_latency.stats[msg].counter = 0;
+    g_ipc_latency.stats[msg].min = 0xFFFFFFFF;
+    g_ipc_latency.stats[msg].max = 0;
+    g_ipc_latency.stats[msg].sum = 0;
+
+    for(j = 0; j < NUM_IPC_LATENCY_HIST_BINS; j++)
+    {
+        g_ipc_latency.stats[msg].hist[j] = 0;
+    }
+}
+
+/**
+ * Check whether a MtoC low priority message may be executed directly by
+ * isr_ipc_lowpriority_msg(). Only setpoint, operation mode and acknowledge
+ * messages are allowed, since they have short and bounded execution time. Any
+ * other message received on setpoint lane is posted on deferred work queue.
+ *
+ * @param msg MtoC low priority message
+ * @return 1 if message belongs to setpoint lane, 0 otherwise
+ */
+static uint16_t is_ipc_msg_setpoint(uint16_t msg)
+{
+    switch( (ipc_mtoc_lowpriority_msg_t) msg )
+    {
+        case Open_Loop:
+        case Close_Loop:
+        case Operating_Mode:
+        case Set_SlowRef:
+        case Set_SlowRef_All_PS:
+        case Set_SigGen:
+        case Enable_SigGen:
+        case Disable_SigGen:
+        case CtoM_Message_Error:
+        {
+            return 1;
+        }
+
+        default:
+        {
+            return 0;
+        }
+    }
+}
+
+/**
+ * Execute specified MtoC low priority message, regardless of which lane it was
+ * received from.
+ *
+ * Setpoint messages (see is_ipc_msg_setpoint()) are executed as a whole by
+ * isr_ipc_lowpriority_msg(), or with interrupts disabled by
+ * run_ipc_deferred_work(). Any other message is only executed from background
+ * loop, with interrupts enabled, so it must protect data shared with ISR's by
+ * itself. Heavy calculations are done before a short critical section, which
+ * only commits their results.
+ *
+ * @param msg MtoC low priority message
+ * @param msg_id ID of power supply module addressed by message
+ * @return error to be reported to ARM, or No_Error_MtoC
+ */
+static error_mtoc_t run_ipc_msg(uint16_t msg, uint16_t msg_id)
+{
+    uint16_t i;
+    error_mtoc_t error = No_Error_MtoC;
+
+    switch( (ipc_mtoc_lowpriority_msg_t) msg )
+    {
+        case Turn_On:
+        {
+            /**
+             * TODO: where should disable siggen + reset wfmref be?
+             */
+            hold_ipc_interlocks();
+            g_ipc_ctom.ps_module[msg_id].turn_on(msg_id);
+            release_ipc_interlocks();
+            break;
+        }
+
+        case Turn_Off:
+        {
+            /**
+             * TODO: where should disable siggen + reset wfmref be?
+             */
+            hold_ipc_interlocks();
+            g_ipc_ctom.ps_module[msg_id].turn_off(msg_id);
+            release_ipc_interlocks();
+            break;
+        }
+
+        case Open_Loop:
+        {
+            open_loop(&g_ipc_ctom.ps_module[msg_id]);
+            break;
+        }
+
+        case Close_Loop:
+        {
+            close_loop(&g_ipc_ctom.ps_module[msg_id]);
+            break;
+        }
+
+        case Operating_Mode:
+        {
+            /**
+             * Check whether power supply is on and in case of WfmRef, check
+             * whether it's at the end of the waveform to avoid
+             * discontinuities
+             */
+            if( (g_ipc_ctom.ps_module[msg_id].ps_status.bit.state >= SlowRef) &&
+                (WFMREF_CTOM[msg_id].wfmref_data.p_buf_idx >=
+                 WFMREF_CTOM[msg_id].wfmref_data.p_buf_end) )
             {
-                /**
-                 * Check whether power supply is on and in case of WfmRef, check
-                 * whether it's at the end of the waveform to avoid
-                 * discontinuities
-                 */
-                if( (g_ipc_ctom.ps_module[msg_id].ps_status.bit.state >= SlowRef) &&
-                    (WFMREF_CTOM[msg_id].wfmref_data[WFMREF_CTOM[msg_id].wfmref_selected].p_buf_idx >=
-                     WFMREF_CTOM[msg_id].wfmref_data[WFMREF_CTOM[msg_id].wfmref_selected].p_buf_end) )
+                switch(g_ipc_mtoc.ps_module[msg_id].ps_status.bit.state)
                 {
-                    switch(g_ipc_mtoc.ps_module[msg_id].ps_status.bit.state)
+                    case SlowRef:
+                    case SlowRefSync:
                     {
-                        case SlowRef:
-                        case SlowRefSync:
-                        {
-                            g_ipc_ctom.ps_module[msg_id].ps_setpoint =
-                                      g_ipc_ctom.ps_module[msg_id].ps_reference;
-                        }
-
-                        case Cycle:
-                        {
-                            disable_siggen(&SIGGEN_CTOM[msg_id]);
-                        }
+                        g_ipc_ctom.ps_module[msg_id].ps_setpoint =
+                                  g_ipc_ctom.ps_module[msg_id].ps_reference;
+                    }
 
-                        case RmpWfm:
-                        case MigWfm:
-                        {
-                            if( g_ipc_ctom.ps_module[msg_id].ps_status.bit.state != RmpWfm  &&
-                                g_ipc_ctom.ps_module[msg_id].ps_status.bit.state != MigWfm )
-                            {
-                                update_wfmref(&WFMREF_CTOM[msg_id],&WFMREF_MTOC[msg_id]);
-                                reset_wfmref(&WFMREF_CTOM[msg_id]);
-                            }
-                            break;
-                        }
+                    case Cycle:
+                    {
+                        disable_siggen(&SIGGEN_CTOM[msg_id]);
+                    }
 
-                        default:
+                    case RmpWfm:
+                    case MigWfm:
+                    {
+                        if( g_ipc_ctom.ps_module[msg_id].ps_status.bit.state != RmpWfm  &&
+                            g_ipc_ctom.ps_module[msg_id].ps_status.bit.state != MigWfm )
                         {
-                            break;
+                            reset_wfmref(&WFMREF_CTOM[msg_id]);
                         }
+                        break;
                     }
 
-                    cfg_ps_operation_mode(&g_ipc_ctom.ps_module[msg_id],
-                                          g_ipc_mtoc.ps_module[msg_id].ps_status.bit.state);
+                    default:
+                    {
+                        break;
+                    }
                 }
 
-                break;
+                cfg_ps_operation_mode(&g_ipc_ctom.ps_module[msg_id],
+                                      g_ipc_mtoc.ps_module[msg_id].ps_status.bit.state);
             }
 
-            case Reset_Interlocks:
-            {
-                g_ipc_ctom.ps_module[msg_id].reset_interlocks(msg_id);
-                break;
-            }
+            break;
+        }
 
-            case Unlock_UDC:
-            {
-                unlock_ps_module(&g_ipc_ctom.ps_module[msg_id]);
-                break;
-            }
+        case Reset_Interlocks:
+        {
+            hold_ipc_interlocks();
+            g_ipc_ctom.ps_module[msg_id].reset_interlocks(msg_id);
+            release_ipc_interlocks();
+            break;
+        }
 
-            case Lock_UDC:
-            {
-                lock_ps_module(&g_ipc_ctom.ps_module[msg_id]);
-                break;
-            }
+        case Unlock_UDC:
+        {
+            DINT;
+            unlock_ps_module(&g_ipc_ctom.ps_module[msg_id]);
+            EINT;
+            break;
+        }
 
-            case Cfg_Source_Scope:
-            {
-                cfg_source_scope(&SCOPE_CTOM[msg_id],
-                                 SCOPE_MTOC[msg_id].p_source);
-                break;
-            }
+        case Lock_UDC:
+        {
+            DINT;
+            lock_ps_module(&g_ipc_ctom.ps_module[msg_id]);
+            EINT;
+            break;
+        }
 
-            case Cfg_Freq_Scope:
-            {
-                cfg_freq_scope(&SCOPE_CTOM[msg_id],
-                               SCOPE_MTOC[msg_id].timeslicer.freq_sampling);
-                break;
-            }
+        case Cfg_Source_Scope:
+        {
+            DINT;
 
-            case Cfg_Duration_Scope:
+            if(!cfg_source_scope(&SCOPE_CTOM[msg_id],
+                                 SCOPE_MTOC[msg_id].source_id))
             {
-                cfg_duration_scope(&SCOPE_CTOM[msg_id],
-                                   SCOPE_MTOC[msg_id].duration);
-                break;
+                error = Invalid_Argument;
             }
 
+            EINT;
+            break;
+        }
 
-            case Enable_Scope:
-            {
-                enable_scope(&SCOPE_CTOM[msg_id]);
-                break;
-            }
 
-            case Disable_Scope:
-            {
-                disable_scope(&SCOPE_CTOM[msg_id]);
-                break;
-            }
+        case Cfg_Freq_Scope:
+        {
+            DINT;
+            cfg_freq_scope(&SCOPE_CTOM[msg_id],
+                           SCOPE_MTOC[msg_id].timeslicer.freq_sampling);
+            EINT;
+            break;
+        }
 
-            case Reset_Scope:
-            {
-                reset_scope(&SCOPE_CTOM[msg_id]);
-                break;
-            }
+        case Cfg_Duration_Scope:
+        {
+            DINT;
+            cfg_duration_scope(&SCOPE_CTOM[msg_id],
+                               SCOPE_MTOC[msg_id].duration);
+            EINT;
+            break;
+        }
 
-            case Set_SlowRef:
-            {
-                SET_DEBUG_GPIO1;
+        case Enable_Scope:
+        {
+            DINT;
+            enable_scope(&SCOPE_CTOM[msg_id]);
+            EINT;
+            break;
+        }
 
-                if(g_ipc_ctom.ps_module[msg_id].ps_status.bit.state == SlowRef)
-                {
-                    g_ipc_ctom.ps_module[msg_id].ps_setpoint =
-                    g_ipc_mtoc.ps_module[msg_id].ps_setpoint;
-                }
+        case Disable_Scope:
+        {
+            DINT;
+            disable_scope(&SCOPE_CTOM[msg_id]);
+            EINT;
+            break;
+        }
 
-                else if(g_ipc_ctom.ps_module[msg_id].ps_status.bit.state != SlowRefSync)
-                {
-                    g_ipc_ctom.error_mtoc = Invalid_OpMode;
-                    send_ipc_lowpriority_msg(msg_id, MtoC_Message_Error);
-                }
+        case Reset_Scope:
+        {
+            reset_scope(&SCOPE_CTOM[msg_id]);
+            break;
+        }
 
-                g_ipc_ctom.counter_set_slowref++;
+        case Set_SlowRef:
+        {
+            SET_DEBUG_GPIO1;
 
-                break;
+            if(g_ipc_ctom.ps_module[msg_id].ps_status.bit.state == SlowRef)
+            {
+                g_ipc_ctom.ps_module[msg_id].ps_setpoint =
+                g_ipc_mtoc.ps_module[msg_id].ps_setpoint;
             }
 
-            case Set_SlowRef_All_PS:
+            else if(g_ipc_ctom.ps_module[msg_id].ps_status.bit.state != SlowRefSync)
             {
-                SET_DEBUG_GPIO1;
+                error = Invalid_OpMode;
+            }
+
+            g_ipc_ctom.counter_set_slowref++;
+
+            break;
+        }
 
-                for(i = 0; i < NUM_MAX_PS_MODULES; i++)
+        case Set_SlowRef_All_PS:
+        {
+            SET_DEBUG_GPIO1;
+
+            for(i = 0; i < NUM_MAX_PS_MODULES; i++)
+            {
+                if(g_ipc_ctom.ps_module[i].ps_status.bit.active)
                 {
-                    if(g_ipc_ctom.ps_module[i].ps_status.bit.active)
+                    if(g_ipc_ctom.ps_module[i].ps_status.bit.state == SlowRef)
                     {
-                        if(g_ipc_ctom.ps_module[i].ps_status.bit.state == SlowRef)
-                        {
-                            g_ipc_ctom.ps_module[i].ps_setpoint =
-                            g_ipc_mtoc.ps_module[i].ps_setpoint;
-                        }
-                        else if(g_ipc_ctom.ps_module[i].ps_status.bit.state != SlowRefSync)
-                        {
-                            g_ipc_ctom.error_mtoc = Invalid_OpMode;
-                            send_ipc_lowpriority_msg(msg_id, MtoC_Message_Error);
-                        }
+                        g_ipc_ctom.ps_module[i].ps_setpoint =
+                        g_ipc_mtoc.ps_module[i].ps_setpoint;
+                    }
+                    else if(g_ipc_ctom.ps_module[i].ps_status.bit.state != SlowRefSync)
+                    {
+                        error = Invalid_OpMode;
                     }
                 }
+            }
 
-                g_ipc_ctom.counter_set_slowref++;
+            g_ipc_ctom.counter_set_slowref++;
 
-                break;
-            }
+            break;
+        }
 
-            case Cfg_WfmRef:
-            {
-                cfg_wfmref(&WFMREF_CTOM[msg_id],&WFMREF_MTOC[msg_id]);
-                break;
-            }
+        case Cfg_WfmRef:
+        {
+            cfg_wfmref(&WFMREF_CTOM[msg_id],&WFMREF_MTOC[msg_id]);
+            break;
+        }
 
-            case Update_WfmRef:
+        case Update_WfmRef:
+        {
+            if(!update_wfmref(&WFMREF_CTOM[msg_id],&WFMREF_MTOC[msg_id]))
             {
-                update_wfmref(&WFMREF_CTOM[msg_id],&WFMREF_MTOC[msg_id]);
-                break;
+                error = Invalid_Argument;
             }
+            break;
+        }
 
-            case Reset_WfmRef:
-            {
-                reset_wfmref(&WFMREF_CTOM[msg_id]);
-                break;
-            }
+        case Reset_WfmRef:
+        {
+            DINT;
+            reset_wfmref(&WFMREF_CTOM[msg_id]);
+            EINT;
+            break;
+        }
 
-            case Cfg_SigGen:
-            {
-                cfg_siggen(&SIGGEN_CTOM[msg_id],
-                           SIGGEN_MTOC[msg_id].type,
-                           SIGGEN_MTOC[msg_id].num_cycles,
-                           SIGGEN_MTOC[msg_id].freq,
-                           SIGGEN_MTOC[msg_id].amplitude,
-                           SIGGEN_MTOC[msg_id].offset,
-                           SIGGEN_MTOC[msg_id].aux_param);
-                break;
-            }
+        case Cfg_SigGen:
+        {
+            cfg_siggen_deferred(msg_id);
+            break;
+        }
 
-            case Set_SigGen:
-            {
-                set_siggen_freq(&SIGGEN_CTOM[msg_id], SIGGEN_MTOC[msg_id].freq);
-                break;
-            }
+        case Set_SigGen:
+        {
+            set_siggen_freq(&SIGGEN_CTOM[msg_id], SIGGEN_MTOC[msg_id].freq);
+            break;
+        }
 
-            case Enable_SigGen:
-            {
-                enable_siggen(&SIGGEN_CTOM[msg_id]);
-                break;
-            }
+        case Enable_SigGen:
+        {
+            enable_siggen(&SIGGEN_CTOM[msg_id]);
+            break;
+        }
 
-            case Disable_SigGen:
-            {
-                disable_siggen(&SIGGEN_CTOM[msg_id]);
-                break;
-            }
+        case Disable_SigGen:
+        {
+            disable_siggen(&SIGGEN_CTOM[msg_id]);
+            break;
+        }
 
-            case Reset_Counters:
-            {
-                g_ipc_ctom.counter_set_slowref =  0;
-                g_ipc_ctom.counter_sync_pulse =  0;
-                break;
-            }
+        case Reset_Counters:
+        {
+            DINT;
+            g_ipc_ctom.counter_set_slowref =  0;
+            g_ipc_ctom.counter_sync_pulse =  0;
+            EINT;
+            break;
+        }
 
-            case Set_Param:
-            {
-                break;
-            }
+        case Set_Param:
+        {
+            break;
+        }
 
-            case Set_DSP_Coeffs:
-            {
-                set_dsp_coeffs(g_ipc_mtoc.dsp_module.dsp_class,
-                               g_ipc_mtoc.dsp_module.id);
-                break;
-            }
+        case Set_DSP_Coeffs:
+        {
+            DINT;
+            set_dsp_coeffs(g_ipc_mtoc.dsp_module.dsp_class,
+                           g_ipc_mtoc.dsp_module.id);
+            EINT;
+            break;
+        }
 
-            case Set_Command_Interface:
-            {
-                g_ipc_ctom.ps_module[msg_id].ps_status.bit.interface =
-                        g_ipc_mtoc.ps_module[msg_id].ps_status.bit.interface;
-                break;
-            }
+        case Cfg_TimeSlicer:
+        {
+            DINT;
 
-            case CtoM_Message_Error:
+            if(!set_timeslicer(g_ipc_mtoc.timeslicer_id))
             {
-                /**
-                 * TODO: take action when receiving error
-                 */
-                break;
+                error = Invalid_Argument;
             }
 
-            default:
+            EINT;
+            break;
+        }
+
+        case Set_Command_Interface:
+        {
+            DINT;
+            g_ipc_ctom.ps_module[msg_id].ps_status.bit.interface =
+                    g_ipc_mtoc.ps_module[msg_id].ps_status.bit.interface;
+            EINT;
+            break;
+        }
+
+        case Reset_IPC_Latency:
+        {
+            /// Statistics are written by isr_controller, so each message is
+            /// reset on its own critical section
+            for(i = 0; i < NUM_IPC_LATENCY_MSG; i++)
             {
-                /**
-                 * TODO: check
-                 */
-                g_ipc_ctom.error_mtoc = IPC_LowPriority_Full;
-                send_ipc_lowpriority_msg(msg_id, MtoC_Message_Error);
-                break;
+                DINT;
+                reset_ipc_latency_stats(i);
+                EINT;
             }
+            break;
+        }
+
+        case CtoM_Message_Error:
+        {
+            /**
+             * TODO: take action when receiving error
+             */
+            break;
+        }
+
+        default:
+        {
+            /**
+             * TODO: check
+             */
+            error = IPC_LowPriority_Full;
+            break;
+        }
+    }
+
+    return error;
+}
+
+/**
+ * Hold MtoC interlock requests (MTOCIPC_INT3 and MTOCIPC_INT4) while a power
+ * supply callback runs from background loop. These callbacks (turn_on(),
+ * turn_off() and reset_interlocks()) may wait for contactors, so control ISR
+ * must be allowed to preempt them, but they must not interleave with
+ * interlocks set by ARM, which turn power supply off and change its state.
+ * Requests received meanwhile are kept pending on PIE, and serviced by
+ * release_ipc_interlocks().
+ *
+ * PIEIER bits are cleared with the safe procedure described in section
+ * 1.5.4.3.2 from F28M36 Technical Reference Manual (SPRUHE8E).
+ */
+static void hold_ipc_interlocks(void)
+{
+    DINT;
+
+    PieCtrlRegs.PIEIER11.bit.INTx3 = 0;
+    PieCtrlRegs.PIEIER11.bit.INTx4 = 0;
+
+    __asm(" NOP");
+    __asm(" NOP");
+    __asm(" NOP");
+    __asm(" NOP");
+    __asm(" NOP");
+
+    IFR &= ~M_INT11;
+    PieCtrlRegs.PIEACK.all |= M_INT11;
+
+    EINT;
+}
+
+/**
+ * Release MtoC interlock requests held by hold_ipc_interlocks().
+ */
+static void release_ipc_interlocks(void)
+{
+    DINT;
+    PieCtrlRegs.PIEIER11.bit.INTx3 = 1;
+    PieCtrlRegs.PIEIER11.bit.INTx4 = 1;
+    EINT;
+}
+
+/**
+ * Configure signal generator with parameters from ARM, from background loop.
+ * Signal coefficients are calculated on a local copy, with interrupts enabled,
+ * and copied back at once. As required by cfg_siggen(), configuration is
+ * ignored if siggen is enabled, which is checked again at copy, since it may be
+ * enabled by sync pulses or by setpoint lane meanwhile.
+ *
+ * @param id ps module id
+ */
+static void cfg_siggen_deferred(uint16_t id)
+{
+    siggen_t siggen;
+
+    DINT;
+    siggen = SIGGEN_CTOM[id];
+    EINT;
+
+    if(siggen.enable)
+    {
+        return;
+    }
+
+    cfg_siggen(&siggen, SIGGEN_MTOC[id].type, SIGGEN_MTOC[id].num_cycles,
+               SIGGEN_MTOC[id].freq, SIGGEN_MTOC[id].amplitude,
+               SIGGEN_MTOC[id].offset, SIGGEN_MTOC[id].aux_param);
+
+    DINT;
+
+    if(SIGGEN_CTOM[id].enable == 0)
+    {
+        SIGGEN_CTOM[id] = siggen;
+    }
+
+    EINT;
+}
+
+/**
+ * Post current MtoC low priority message on deferred work queue, to be executed
+ * by run_ipc_deferred_work(). If queue is full, message is discarded and an
+ * error is reported to ARM.
+ *
+ * @param msg_id ID of power supply module addressed by message
+ */
+static void post_ipc_deferred_work(uint16_t msg_id)
+{
+    uint16_t head;
+
+    head = ipc_deferred_head;
+
+    if( ((head + 1) & MASK_IPC_DEFERRED_QUEUE) == ipc_deferred_tail )
+    {
+        g_ipc_ctom.error_mtoc = IPC_LowPriority_Full;
+        send_ipc_lowpriority_msg(msg_id, MtoC_Message_Error);
+    }
+    else
+    {
+        ipc_deferred_queue[head].msg_mtoc = g_ipc_ctom.msg_mtoc;
+        ipc_deferred_queue[head].timestamp = g_ipc_mtoc.timestamp_msg;
+        ipc_deferred_queue[head].msg_id = msg_id;
+        ipc_deferred_head = (head + 1) & MASK_IPC_DEFERRED_QUEUE;
+    }
+}
+
+/**
+ * Executor of deferred MtoC low priority messages and of configuration lane
+ * messages. It must be called from the background loop of power supply
+ * modules, so it may be preempted by control and interlock ISRs. Setpoint
+ * messages received through configuration lane are executed with interrupts
+ * disabled, as they would be by isr_ipc_lowpriority_msg(). Any other message
+ * runs with interrupts enabled, and only disables them while committing its
+ * results (see run_ipc_msg()).
+ *
+ * Each call either executes one message, or sends MtoC_Message_Done for the
+ * last executed one, carrying its power supply ID (msg_id) and original
+ * message word (msg_mtoc_done). Completion is retried on following calls while
+ * CtoM IPC channel is busy, and next message is only executed after it's sent.
+ * Deferred messages are executed before configuration lane ones.
+ */
+void run_ipc_deferred_work(void)
+{
+    uint16_t tail, msg, msg_id;
+    uint32_t msg_mtoc, timestamp;
+    error_mtoc_t error;
+
+    if(ipc_deferred_done_pending)
+    {
+        DINT;
+
+        if(CtoMIpcRegs.CTOMIPCFLG.all == 0x00000000)
+        {
+            g_ipc_ctom.msg_mtoc_done = ipc_deferred_done.msg_mtoc;
+            send_ipc_lowpriority_msg(ipc_deferred_done.msg_id,
+                                     MtoC_Message_Done);
+            ipc_deferred_done_pending = 0;
+        }
+
+        EINT;
+        return;
+    }
+
+    tail = ipc_deferred_tail;
+
+    if(tail != ipc_deferred_head)
+    {
+        msg_mtoc = ipc_deferred_queue[tail].msg_mtoc;
+        msg_id = ipc_deferred_queue[tail].msg_id;
+        timestamp = ipc_deferred_queue[tail].timestamp;
+
+        ipc_deferred_busy = 1;
+        ipc_deferred_tail = (tail + 1) & MASK_IPC_DEFERRED_QUEUE;
+    }
+    else if(CtoMIpcRegs.MTOCIPCSTS.all & IPC_MTOC_CFG_MSG)
+    {
+        msg_mtoc = g_ipc_mtoc.msg_cfg;
+        msg_id = g_ipc_mtoc.msg_id_cfg;
+        timestamp = g_ipc_mtoc.timestamp_cfg;
+
+        CtoMIpcRegs.MTOCIPCACK.all = IPC_MTOC_CFG_MSG;
+
+        if( (msg_id >= NUM_MAX_PS_MODULES) ||
+            (g_ipc_ctom.ps_module[msg_id].ps_status.bit.active == 0) )
+        {
+            DINT;
+            g_ipc_ctom.error_mtoc = Invalid_Argument;
+            send_ipc_lowpriority_msg(msg_id, MtoC_Message_Error);
+            EINT;
+            return;
+        }
+    }
+    else
+    {
+        return;
+    }
+
+    msg = (uint16_t) ((msg_mtoc >> 4) & 0x0000FFFF);
+
+    if(is_ipc_msg_setpoint(msg))
+    {
+        DINT;
+        error = run_ipc_msg(msg, msg_id);
+    }
+    else
+    {
+        error = run_ipc_msg(msg, msg_id);
+        DINT;
+    }
+
+    if(error != No_Error_MtoC)
+    {
+        g_ipc_ctom.error_mtoc = error;
+        send_ipc_lowpriority_msg(msg_id, MtoC_Message_Error);
+    }
+
+    post_ipc_latency(msg, timestamp);
+
+    ipc_deferred_busy = 0;
+
+    EINT;
+
+    ipc_deferred_done.msg_mtoc = msg_mtoc;
+    ipc_deferred_done.msg_id = msg_id;
+    ipc_deferred_done_pending = 1;
+}
+
+/**
+ * Interrupt Service Routine for IPC MtoC Low Priority Messages, which
+ * implements the setpoint lane. Configuration lane flag is left for
+ * run_ipc_deferred_work().
+ *
+ * Only setpoint, operation mode and acknowledge messages are executed here.
+ * Any other message is validated and posted on deferred work queue, so this
+ * ISR has bounded execution time even when ARM sends slow state changes (e.g.
+ * Turn_On, which waits for relays) or configuration messages through this
+ * lane. Messages addressed to inactive power supplies are rejected with
+ * Invalid_Argument.
+ *
+ * Setpoint lane messages are executed in the order they are received: while
+ * deferred work is queued or running, bounded messages are queued as well, and
+ * acknowledged with MtoC_Message_Done.
+ */
+interrupt void isr_ipc_lowpriority_msg(void)
+{
+    static uint16_t msg, msg_id;
+    static error_mtoc_t error;
+
+    g_ipc_ctom.msg_mtoc = CtoMIpcRegs.MTOCIPCSTS.all & ~IPC_MTOC_CFG_MSG;
+    CtoMIpcRegs.MTOCIPCACK.all = g_ipc_ctom.msg_mtoc;
+
+    msg = (uint16_t) GET_IPC_MTOC_LOWPRIORITY_MSG;
+    msg_id = g_ipc_mtoc.msg_id;
+
+    if( (msg_id >= NUM_MAX_PS_MODULES) ||
+        (g_ipc_ctom.ps_module[msg_id].ps_status.bit.active == 0) )
+    {
+        g_ipc_ctom.error_mtoc = Invalid_Argument;
+        send_ipc_lowpriority_msg(msg_id, MtoC_Message_Error);
+    }
+    else if( is_ipc_msg_setpoint(msg) &&
+             (ipc_deferred_head == ipc_deferred_tail) && !ipc_deferred_busy )
+    {
+        error = run_ipc_msg(msg, msg_id);
+
+        if(error != No_Error_MtoC)
+        {
+            g_ipc_ctom.error_mtoc = error;
+            send_ipc_lowpriority_msg(msg_id, MtoC_Message_Error);
         }
+
+        post_ipc_latency(msg, g_ipc_mtoc.timestamp_msg);
+    }
+    else
+    {
+        post_ipc_deferred_work(msg_id);
     }
 
     PieCtrlRegs.PIEACK.all |= M_INT11;
@@ -480,6 +1009,9 @@ interrupt void isr_ipc_lowpriority_msg(void)
 interrupt void isr_ipc_sync_pulse(void)
 {
     uint16_t i;
+    sync_source_t sync_source;
+
+    sync_source = IS_SYNC_PULSE_XINT2 ? SyncPulse_XINT2 : SyncPulse_IPC;
 
     SET_DEBUG_GPIO0;
     //SET_DEBUG_GPIO1;
@@ -492,22 +1024,31 @@ interrupt void isr_ipc_sync_pulse(void)
             {
                 case SlowRefSync:
                 {
+                    INVALIDATE_PS_REFERENCE_AHEAD(&g_ipc_ctom.ps_module[i]);
                     g_ipc_ctom.ps_module[i].ps_setpoint =
                     g_ipc_mtoc.ps_module[i].ps_setpoint;
+                    post_ipc_latency(IPC_LATENCY_SYNC_SETPOINT,
+                                     g_ipc_mtoc.timestamp_setpoint);
                     break;
                 }
 
 
                 case Cycle:
                 {
-                    enable_siggen(&SIGGEN_CTOM[i]);
+                    if(SIGGEN_CTOM[i].enable == 0)
+                    {
+                        enable_siggen(&SIGGEN_CTOM[i]);
+                        start_siggen_ahead(i);
+                    }
                     break;
                 }
 
                 case RmpWfm:
                 case MigWfm:
                 {
-                    sync_wfmref(&WFMREF_CTOM[i], &WFMREF_MTOC[i]);
+                    INVALIDATE_PS_REFERENCE_AHEAD(&g_ipc_ctom.ps_module[i]);
+                    sync_wfmref(&WFMREF_CTOM[i], &WFMREF_MTOC[i],
+                                sync_source);
                     break;
                 }
 
@@ -521,6 +1062,11 @@ interrupt void isr_ipc_sync_pulse(void)
 
     g_ipc_ctom.counter_sync_pulse++;
 
+    for(i = 0; i < NUM_MAX_SCOPES; i++)
+    {
+        sync_scope(&SCOPE_CTOM[i], g_ipc_ctom.counter_sync_pulse);
+    }
+
     if(SCOPE_CTOM[0].buffer.status == Idle)
     {
         SCOPE_CTOM[0].buffer.status = Postmortem;
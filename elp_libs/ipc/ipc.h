@@ -46,6 +46,32 @@
 #define SIZE_BUF_SAMPLES_CTOM   4096
 #define SIZE_BUF_SAMPLES_MTOC   4096
 
+/**
+ * Deferred IPC work defines. Queue size must be a power of 2.
+ */
+#define SIZE_IPC_DEFERRED_QUEUE     8
+#define MASK_IPC_DEFERRED_QUEUE     (SIZE_IPC_DEFERRED_QUEUE - 1)
+
+/**
+ * Command latency defines. Latency is measured in ticks of the IPC free-running
+ * counter, which is shared by both cores, from the timestamp written by ARM
+ * along with a MtoC message until the first isr_controller executed after C28
+ * has processed it. Statistics are indexed by MtoC low priority message, and
+ * index 0 (unused by messages) holds setpoint updates applied by sync pulses.
+ *
+ * Histogram bin 0 counts latencies below 2^IPC_LATENCY_HIST_SHIFT ticks, and
+ * each following bin doubles its upper limit. Last bin has no upper limit.
+ */
+#define IPC_TIMESTAMP                   CtoMIpcRegs.MIPCCOUNTERL
+
+#define NUM_IPC_LATENCY_MSG             32
+#define NUM_IPC_LATENCY_HIST_BINS       8
+#define IPC_LATENCY_HIST_SHIFT          7
+#define IPC_LATENCY_SYNC_SETPOINT       0
+
+#define RUN_IPC_LATENCY     ISR_DEFERRED_PHASE_ONLY;    \
+                            if(g_ipc_latency.pending){ run_ipc_latency(); }
+
 #define SIGGEN_CTOM     g_ipc_ctom.siggen
 #define SIGGEN_MTOC     g_ipc_mtoc.siggen
 
@@ -64,44 +90,77 @@
 #define SYNC_PULSE                  0x00000002  // IPC2
 #define HARD_INTERLOCK              0x00000004  // IPC3
 #define SOFT_INTERLOCK              0x00000008  // IPC4
+#define IPC_MTOC_CFG_MSG            0x80000000  // IPC32
 
+/**
+ * MtoC low priority messages are assigned to one of two lanes:
+ *
+ *  - Setpoint lane (S): signaled by IPC_MTOC_LOWPRIORITY_MSG flag, with message
+ *    code on IPC flags and ID on g_ipc_mtoc.msg_id, and handled by
+ *    isr_ipc_lowpriority_msg() with bounded execution time. Turn_On and
+ *    Turn_Off (which wait for relays) and messages not marked as S are
+ *    accepted on this lane, but they're queued and executed from background
+ *    loop, and acknowledged with MtoC_Message_Done. Messages on this lane are
+ *    always executed in the order they are received, so e.g. Operating_Mode
+ *    followed by Set_SlowRef doesn't need to wait for MtoC_Message_Done.
+ *
+ *  - Configuration lane (C): signaled by IPC_MTOC_CFG_MSG flag, which doesn't
+ *    generate interrupts, with message word (same format as MTOCIPCSTS) on
+ *    g_ipc_mtoc.msg_cfg and ID on g_ipc_mtoc.msg_id_cfg. It's polled and
+ *    handled by run_ipc_deferred_work() from background loop, and each message
+ *    is acknowledged with MtoC_Message_Done.
+ *
+ * Background messages run with interrupts enabled, so control ISR isn't held
+ * while they execute: results are calculated first and committed on a short
+ * critical section. Turn_On, Turn_Off and Reset_Interlocks hold interlock
+ * requests from ARM until they return.
+ *
+ * Both lanes are independent, so ARM may have one message pending on each of
+ * them, but there's no ordering between lanes: ARM must wait for
+ * MtoC_Message_Done before relying on a configuration lane message from the
+ * setpoint lane. Messages received on the other lane are still handled.
+ * Messages addressed to an inactive power supply are rejected with
+ * Invalid_Argument.
+ */
 typedef enum
 {
-    Turn_On = 1,
-    Turn_Off,
-    Open_Loop,
-    Close_Loop,
-    Operating_Mode,
-    Reset_Interlocks,
-    Unlock_UDC,
-    Lock_UDC,
-    Cfg_Source_Scope,
-    Cfg_Freq_Scope,
-    Cfg_Duration_Scope,
-    Enable_Scope,
-    Disable_Scope,
-    Reset_Scope,
-    Set_SlowRef,
-    Set_SlowRef_All_PS,
-    Cfg_WfmRef,
-    Update_WfmRef,
-    Reset_WfmRef,
-    Cfg_SigGen,
-    Set_SigGen,
-    Enable_SigGen,
-    Disable_SigGen,
-    Reset_Counters,
-    Set_Param,
-    Set_DSP_Coeffs,
-    Cfg_TimeSlicer,
-    Set_Command_Interface,
-    CtoM_Message_Error
+    Turn_On = 1,                // S
+    Turn_Off,                   // S
+    Open_Loop,                  // S
+    Close_Loop,                 // S
+    Operating_Mode,             // S
+    Reset_Interlocks,           // C
+    Unlock_UDC,                 // C
+    Lock_UDC,                   // C
+    Cfg_Source_Scope,           // C
+    Cfg_Freq_Scope,             // C
+    Cfg_Duration_Scope,         // C
+    Enable_Scope,               // C
+    Disable_Scope,              // C
+    Reset_Scope,                // C
+    Set_SlowRef,                // S
+    Set_SlowRef_All_PS,         // S
+    Cfg_WfmRef,                 // C
+    Update_WfmRef,              // C
+    Reset_WfmRef,               // C
+    Cfg_SigGen,                 // C
+    Set_SigGen,                 // S
+    Enable_SigGen,              // S
+    Disable_SigGen,             // S
+    Reset_Counters,             // C
+    Set_Param,                  // C
+    Set_DSP_Coeffs,             // C
+    Cfg_TimeSlicer,             // C
+    Set_Command_Interface,      // C
+    Reset_IPC_Latency,          // C
+    CtoM_Message_Error          // S
 } ipc_mtoc_lowpriority_msg_t;
 
 typedef enum
 {   Enable_HRADC_Boards,
     Disable_HRADC_Boards,
-    MtoC_Message_Error
+    MtoC_Message_Error,
+    MtoC_Message_Done
 } ipc_ctom_lowpriority_msg_t;
 
 #define GET_IPC_MTOC_LOWPRIORITY_MSG  (ipc_mtoc_lowpriority_msg_t) (g_ipc_ctom.msg_mtoc >> 4 ) & 0x0000FFFF
@@ -133,6 +192,7 @@ typedef struct
     uint32_t        msg_mtoc;
     uint16_t        msg_id;
     error_mtoc_t    error_mtoc;
+    uint32_t        msg_mtoc_done;
     uint32_t        counter_set_slowref;
     uint32_t        counter_sync_pulse;
     uint32_t        period_sync_pulse;
@@ -147,6 +207,11 @@ typedef struct
     uint32_t                msg_ctom;
     uint16_t                msg_id;
     error_ctom_t            error_ctom;
+    uint32_t                timestamp_msg;
+    uint32_t                timestamp_setpoint;
+    uint32_t                msg_cfg;
+    uint16_t                msg_id_cfg;
+    uint32_t                timestamp_cfg;
     uint32_t                ps_name[SIZE_PS_NAME];
     ps_model_t              ps_model;
     uint16_t                num_ps_modules;
@@ -155,6 +220,7 @@ typedef struct
     wfmref_t                wfmref[NUM_MAX_PS_MODULES];
     scope_t                 scope[NUM_MAX_SCOPES];
     dsp_module_t            dsp_module;
+    uint16_t                timeslicer_id;
     //param_control_t         control;
     //param_pwm_t             pwm;
     //param_hradc_t           hradc;
@@ -163,17 +229,37 @@ typedef struct
     //param_interlocks_t      interlocks;
 } ipc_mtoc_t;
 
+typedef volatile struct
+{
+    uint32_t    counter;
+    uint32_t    min;
+    uint32_t    max;
+    uint64_t    sum;
+    uint32_t    hist[NUM_IPC_LATENCY_HIST_BINS];
+} ipc_latency_stats_t;
+
+typedef volatile struct
+{
+    uint32_t            pending;
+    ipc_latency_stats_t stats[NUM_IPC_LATENCY_MSG];
+} ipc_latency_t;
+
 extern volatile float g_buf_samples_ctom[SIZE_BUF_SAMPLES_CTOM];
 extern volatile float g_buf_samples_mtoc[SIZE_BUF_SAMPLES_MTOC];
 
 extern volatile ipc_ctom_t g_ipc_ctom;
 extern volatile ipc_mtoc_t g_ipc_mtoc;
 
+extern ipc_latency_t g_ipc_latency;
+
 extern volatile uint32_t counter_sync_period;
 
 extern void init_ipc(void);
 extern void send_ipc_msg(uint16_t msg_id, uint32_t msg);
 extern void send_ipc_lowpriority_msg(uint16_t msg_id,
                                      ipc_ctom_lowpriority_msg_t msg);
+extern void run_ipc_deferred_work(void);
+extern void run_ipc_latency(void);
+extern void reset_ipc_latency(void);
 
 #endif /* IPC_H_ */
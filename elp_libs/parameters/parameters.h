@@ -45,7 +45,7 @@
 #define NUM_MAX_HARD_INTERLOCKS     32
 #define NUM_MAX_SOFT_INTERLOCKS     32
 
-#define NUM_PARAMETERS          54
+#define NUM_PARAMETERS          55
 #define NUM_MAX_PARAMETERS      64
 #define NUM_MAX_FLOATS          200
 
@@ -151,6 +151,11 @@
 #define SCOPE_FREQ_SAMPLING_PARAM   g_param_bank.scope.freq_sampling
 #define SCOPE_SOURCE_PARAM          g_param_bank.scope.p_source
 
+/**
+ * DC-Link parameters
+ */
+#define DCLINK_DIGITAL_POT_STEP     g_param_bank.dclink.digital_pot_step
+
 typedef enum
 {
     PS_Name,
@@ -217,7 +222,9 @@ typedef enum
     Soft_Interlocks_Reset_Time,
 
     Scope_Sampling_Frequency,
-    Scope_Source
+    Scope_Source,
+
+    DCLink_Digital_Pot_Step
 } param_id_t;
 
 typedef enum
@@ -332,6 +339,11 @@ typedef struct
     float   *p_source[NUM_MAX_SCOPES];
 } param_scope_t;
 
+typedef struct
+{
+    float   digital_pot_step;
+} param_dclink_t;
+
 typedef struct
 {
     param_t                 param_info[NUM_MAX_PARAMETERS];
@@ -347,6 +359,7 @@ typedef struct
     param_analog_vars_t     analog_vars;
     param_interlocks_t      interlocks;
     param_scope_t           scope;
+    param_dclink_t          dclink;
 } param_bank_t;
 
 //extern volatile param_t g_parameters[NUM_MAX_PARAMETERS];
@@ -56,6 +56,7 @@
 #include "ipc/ipc.h"
 #include "parameters/parameters.h"
 #include "pwm/pwm.h"
+#include "signals/signals.h"
 #include "wfmref/wfmref.h"
 
 #include "fac_2p4s_dcdc.h"
@@ -160,6 +161,12 @@
 #define IIR_2P2Z_REFERENCE_FEEDFORWARD          &g_controller_ctom.dsp_modules.dsp_iir_2p2z[0]
 #define IIR_2P2Z_REFERENCE_FEEDFORWARD_COEFFS   g_controller_mtoc.dsp_modules.dsp_iir_2p2z[0].coeffs.s
 
+/// Load current DCCTs voting
+#define REDUNDANCY_I_LOAD                   &g_controller_ctom.dsp_modules.dsp_redundancy[0]
+#define REDUNDANCY_I_LOAD_COEFFS            g_controller_mtoc.dsp_modules.dsp_redundancy[0].coeffs.s
+#define DCCTS_FAULT                         g_controller_ctom.dsp_modules.dsp_redundancy[0].fault
+#define DCCTS_EXCLUDED                      g_controller_ctom.dsp_modules.dsp_redundancy[0].excluded
+
 /// Arms current share controller
 #define ERROR_I_SHARE                   &g_controller_ctom.dsp_modules.dsp_error[1]
 
@@ -194,6 +201,22 @@
 /// Scope
 #define SCOPE                           SCOPE_CTOM[0]
 
+/**
+ * Uncomment to calculate references one sample ahead, on deferred phase of
+ * control ISR, removing reference generators from critical phase.
+ */
+//#define USE_PIPELINED_REFERENCE
+
+/**
+ * Uncomment to use compensated integrator on load current PI controller. See
+ * cfg_dsp_pi_integrator().
+ */
+//#define USE_COMPENSATED_INTEGRATOR
+
+/// Control ISR profile, measured by counter of ePWM module which triggered it
+#define ISR_PROFILE                     g_controller_ctom.isr_profile
+#define ISR_ELAPSED_CYCLES              GET_PWM_ELAPSED_CYCLES(p_pwm_isr)
+
 /**
  * Digital I/O's status
  */
@@ -260,7 +283,9 @@ typedef enum
 
 typedef enum
 {
-    High_Sync_Input_Frequency = 0x00000001
+    High_Sync_Input_Frequency = 0x00000001,
+    DCCT_1_Excluded = 0x00000002,
+    DCCT_2_Excluded = 0x00000004
 } alarms_t;
 
 #define NUM_HARD_INTERLOCKS     IIB_Mod_8_Itlk + 1
@@ -270,13 +295,18 @@ typedef enum
  *  Private variables
  */
 static uint16_t decimation_factor;
-static float decimation_coeff;
+
+static volatile float *p_i_load_dccts[2] = {&I_LOAD_1, &I_LOAD_2};
+static ps_reference_gen_t reference_gens[NUM_PS_STATES];
 
 /**
  * Private functions
  */
 #pragma CODE_SECTION(isr_init_controller, "ramfuncs");
 #pragma CODE_SECTION(isr_controller, "ramfuncs");
+#pragma CODE_SECTION(run_reference_srlim, "ramfuncs");
+#pragma CODE_SECTION(run_reference_cycle, "ramfuncs");
+#pragma CODE_SECTION(run_reference_wfmref, "ramfuncs");
 #pragma CODE_SECTION(turn_off, "ramfuncs");
 
 static void init_peripherals_drivers(void);
@@ -289,6 +319,10 @@ static void disable_controller();
 static interrupt void isr_init_controller(void);
 static interrupt void isr_controller(void);
 
+static void run_reference_srlim(volatile void *p_srlim);
+static void run_reference_cycle(volatile void *p_siggen);
+static void run_reference_wfmref(volatile void *p_wfmref);
+
 static void init_interruptions(void);
 static void term_interruptions(void);
 
@@ -297,6 +331,7 @@ static void turn_off(uint16_t dummy);
 
 static void reset_interlocks(uint16_t dummy);
 static inline void check_interlocks(void);
+static void set_dcct_fault(uint16_t id, soft_interlocks_t itlk);
 static inline void check_capbank_undervoltage(void);
 static inline void check_capbank_overvoltage(void);
 
@@ -330,6 +365,7 @@ void main_fac_2p4s_dcdc(void)
     while(1)
     {
         check_interlocks();
+        run_ipc_deferred_work();
     }
 
     turn_off(0);
@@ -343,18 +379,23 @@ void main_fac_2p4s_dcdc(void)
 static void init_peripherals_drivers(void)
 {
     uint16_t i;
+    tDMA_Plan dma_plan;
 
     /// Initialization of HRADC boards
     stop_DMA();
 
-    decimation_factor = (uint16_t) roundf(HRADC_FREQ_SAMP / ISR_CONTROL_FREQ);
-    decimation_coeff = 1.0 / (float) decimation_factor;
+    HRADCs_Info.DMA_PlanStatus = Plan_DMA_McBSP_nBuffers(&dma_plan, NUM_HRADC_BOARDS,
+                                                         HRADC_SPI_CLK,
+                                                         HRADC_FREQ_SAMP,
+                                                         ISR_CONTROL_FREQ);
+
+    decimation_factor = dma_plan.size_buffers;
 
 
     HRADCs_Info.enable_Sampling = 0;
     HRADCs_Info.n_HRADC_boards = NUM_HRADC_BOARDS;
 
-    Init_DMA_McBSP_nBuffers(NUM_HRADC_BOARDS, decimation_factor, HRADC_SPI_CLK);
+    Init_DMA_McBSP_nBuffers(&dma_plan);
 
     Init_SPIMaster_McBSP(HRADC_SPI_CLK);
     Init_SPIMaster_Gpio();
@@ -372,6 +413,8 @@ static void init_peripherals_drivers(void)
                            HRADC_HEATER_ENABLE[i], HRADC_MONITOR_ENABLE[i]);
     }
 
+    register_hradc_signals(NUM_HRADC_BOARDS);
+
     Config_HRADC_SoC(HRADC_FREQ_SAMP);
 
     /**
@@ -485,8 +528,8 @@ static void init_controller(void)
     init_ipc();
 
     init_wfmref(&WFMREF, WFMREF_SELECTED_PARAM[0], WFMREF_SYNC_MODE_PARAM[0],
-                ISR_CONTROL_FREQ, WFMREF_FREQUENCY_PARAM[0], WFMREF_GAIN_PARAM[0],
-                WFMREF_OFFSET_PARAM[0], &g_wfmref_data.data, SIZE_WFMREF,
+                ISR_CONTROL_FREQ, WFMREF_FREQUENCY_PARAM[0],
+                WFMREF_GAIN_PARAM[0], WFMREF_OFFSET_PARAM[0],
                 &I_LOAD_REFERENCE);
 
     /***********************************************/
@@ -539,6 +582,24 @@ static void init_controller(void)
     init_dsp_srlim(SRLIM_I_LOAD_REFERENCE, MAX_SLEWRATE_SLOWREF, ISR_CONTROL_FREQ,
                    &I_LOAD_SETPOINT, &I_LOAD_REFERENCE);
 
+    /**
+     *        name:     REDUNDANCY_I_LOAD
+     * description:     Load current DCCTs voting and failover
+     *  dsp module:     DSP_Redundancy
+     *          in:     I_LOAD_1, I_LOAD_2
+     *         out:     I_LOAD_MEAN
+     *        diff:     I_LOAD_DIFF
+     */
+
+    init_dsp_redundancy(REDUNDANCY_I_LOAD, NUM_DCCTs ? 2 : 1,
+                        REDUNDANCY_I_LOAD_COEFFS.max_diff,
+                        REDUNDANCY_I_LOAD_COEFFS.max_step,
+                        REDUNDANCY_I_LOAD_COEFFS.stuck_time,
+                        REDUNDANCY_I_LOAD_COEFFS.noise_tolerance,
+                        REDUNDANCY_I_LOAD_COEFFS.max_slewrate_transfer,
+                        ISR_CONTROL_FREQ, p_i_load_dccts, &I_LOAD_MEAN,
+                        &I_LOAD_DIFF);
+
     /**
      *        name:     ERROR_I_LOAD
      * description:     Load current reference error
@@ -561,6 +622,10 @@ static void init_controller(void)
     init_dsp_pi(PI_CONTROLLER_I_LOAD, KP_I_LOAD, KI_I_LOAD, ISR_CONTROL_FREQ,
                 PWM_MAX_DUTY, PWM_MIN_DUTY, &I_LOAD_ERROR, &DUTY_I_LOAD_PI);
 
+    #ifdef USE_COMPENSATED_INTEGRATOR
+    cfg_dsp_pi_integrator(PI_CONTROLLER_I_LOAD, COMPENSATED_INTEGRATOR);
+    #endif
+
     /**
      *        name:     IIR_2P2Z_REFERENCE_FEEDFORWARD
      * description:     Load current IIR 2P2Z controller
@@ -659,6 +724,59 @@ static void init_controller(void)
                         &V_CAPBANK_ARM_2_FILTERED, &IN_FF_V_CAPBANK_ARM_2,
                         &DUTY_CYCLE_MOD_5);
 
+    /********************************************/
+    /** INITIALIZATION OF REFERENCE GENERATORS **/
+    /********************************************/
+
+    init_ps_reference(&g_ipc_ctom.ps_module[0], reference_gens);
+
+    cfg_ps_reference(&g_ipc_ctom.ps_module[0], SlowRef,
+                     &run_reference_srlim, SRLIM_I_LOAD_REFERENCE);
+    cfg_ps_reference(&g_ipc_ctom.ps_module[0], SlowRefSync,
+                     &run_reference_srlim, SRLIM_I_LOAD_REFERENCE);
+    cfg_ps_reference(&g_ipc_ctom.ps_module[0], Cycle,
+                     &run_reference_cycle, &SIGGEN);
+    cfg_ps_reference(&g_ipc_ctom.ps_module[0], RmpWfm,
+                     &run_reference_wfmref, &WFMREF);
+    cfg_ps_reference(&g_ipc_ctom.ps_module[0], MigWfm,
+                     &run_reference_wfmref, &WFMREF);
+
+    /****************************************/
+    /** INITIALIZATION OF SIGNALS REGISTRY **/
+    /****************************************/
+
+    init_signals();
+
+    REGISTER_SIGNAL(I_LOAD_SETPOINT, is_float, Unit_Ampere);
+    REGISTER_SIGNAL(I_LOAD_REFERENCE, is_float, Unit_Ampere);
+    REGISTER_SIGNAL(I_LOAD_1, is_float, Unit_Ampere);
+    REGISTER_SIGNAL(I_LOAD_2, is_float, Unit_Ampere);
+    REGISTER_SIGNAL(I_ARM_1, is_float, Unit_Ampere);
+    REGISTER_SIGNAL(I_ARM_2, is_float, Unit_Ampere);
+    REGISTER_SIGNAL(I_LOAD_MEAN, is_float, Unit_Ampere);
+    REGISTER_SIGNAL(I_LOAD_ERROR, is_float, Unit_Ampere);
+    REGISTER_SIGNAL(DUTY_I_LOAD_PI, is_float, Unit_Duty);
+    REGISTER_SIGNAL(I_ARMS_DIFF, is_float, Unit_Ampere);
+    REGISTER_SIGNAL(DUTY_DIFF, is_float, Unit_Duty);
+    REGISTER_SIGNAL(I_LOAD_DIFF, is_float, Unit_Ampere);
+    REGISTER_SIGNAL(DUTY_REF_FF, is_float, Unit_Duty);
+    REGISTER_SIGNAL(V_CAPBANK_ARM_1_FILTERED, is_float, Unit_Volt);
+    REGISTER_SIGNAL(V_CAPBANK_ARM_2_FILTERED, is_float, Unit_Volt);
+    REGISTER_SIGNAL(IN_FF_V_CAPBANK_ARM_1, is_float, Unit_Duty);
+    REGISTER_SIGNAL(IN_FF_V_CAPBANK_ARM_2, is_float, Unit_Duty);
+    REGISTER_SIGNAL(WFMREF_IDX, is_float, Unit_None);
+    REGISTER_SIGNAL(DUTY_CYCLE_MOD_1, is_float, Unit_Duty);
+    REGISTER_SIGNAL(DUTY_CYCLE_MOD_2, is_float, Unit_Duty);
+    REGISTER_SIGNAL(DUTY_CYCLE_MOD_3, is_float, Unit_Duty);
+    REGISTER_SIGNAL(DUTY_CYCLE_MOD_4, is_float, Unit_Duty);
+    REGISTER_SIGNAL(DUTY_CYCLE_MOD_5, is_float, Unit_Duty);
+    REGISTER_SIGNAL(DUTY_CYCLE_MOD_6, is_float, Unit_Duty);
+    REGISTER_SIGNAL(DUTY_CYCLE_MOD_7, is_float, Unit_Duty);
+    REGISTER_SIGNAL(DUTY_CYCLE_MOD_8, is_float, Unit_Duty);
+
+    REGISTER_DSP_PI_INTEGRATOR(PI_CONTROLLER_I_LOAD, Unit_Duty);
+    REGISTER_DSP_PI_INTEGRATOR(PI_CONTROLLER_I_SHARE, Unit_Duty);
+
     /******************************/
     /** INITIALIZATION OF SCOPES **/
     /******************************/
@@ -716,6 +834,38 @@ static void reset_controller(void)
     reset_wfmref(&WFMREF);
 }
 
+/**
+ * Reference generator for SlowRef and SlowRefSync operation modes.
+ *
+ * @param p_srlim pointer to reference slew-rate limiter
+ */
+static void run_reference_srlim(volatile void *p_srlim)
+{
+    run_dsp_srlim((dsp_srlim_t *) p_srlim, USE_MODULE);
+}
+
+/**
+ * Reference generator for Cycle operation mode.
+ *
+ * @param p_siggen pointer to signal generator
+ */
+static void run_reference_cycle(volatile void *p_siggen)
+{
+    run_dsp_srlim(SRLIM_SIGGEN_AMP, USE_MODULE);
+    run_dsp_srlim(SRLIM_SIGGEN_OFFSET, USE_MODULE);
+    ((siggen_t *) p_siggen)->p_run_siggen((siggen_t *) p_siggen);
+}
+
+/**
+ * Reference generator for RmpWfm and MigWfm operation modes.
+ *
+ * @param p_wfmref pointer to waveform reference
+ */
+static void run_reference_wfmref(volatile void *p_wfmref)
+{
+    run_wfmref((wfmref_t *) p_wfmref);
+}
+
 /**
  * Initialization of interruptions.
  */
@@ -815,44 +965,16 @@ static interrupt void isr_init_controller(void)
 static interrupt void isr_controller(void)
 {
     static float temp[4];
-    static uint16_t i;
+    volatile struct EPWM_REGS *p_pwm_isr;
+
+    p_pwm_isr = GET_PWM_ISR_MODULE;
 
     //CLEAR_DEBUG_GPIO1;
     //SET_DEBUG_GPIO0;
     SET_DEBUG_GPIO1;
 
-    temp[0] = 0.0;
-    temp[1] = 0.0;
-    temp[2] = 0.0;
-    temp[3] = 0.0;
-
     /// Get HRADC samples
-    for(i = 0; i < decimation_factor; i++)
-    {
-        temp[0] += (float) *(HRADCs_Info.HRADC_boards[0].SamplesBuffer++);
-        temp[1] += (float) *(HRADCs_Info.HRADC_boards[1].SamplesBuffer++);
-        temp[2] += (float) *(HRADCs_Info.HRADC_boards[2].SamplesBuffer++);
-        temp[3] += (float) *(HRADCs_Info.HRADC_boards[3].SamplesBuffer++);
-    }
-
-    //CLEAR_DEBUG_GPIO1;
-
-    HRADCs_Info.HRADC_boards[0].SamplesBuffer = buffers_HRADC[0];
-    HRADCs_Info.HRADC_boards[1].SamplesBuffer = buffers_HRADC[1];
-    HRADCs_Info.HRADC_boards[2].SamplesBuffer = buffers_HRADC[2];
-    HRADCs_Info.HRADC_boards[3].SamplesBuffer = buffers_HRADC[3];
-
-    temp[0] *= HRADCs_Info.HRADC_boards[0].gain * decimation_coeff;
-    temp[0] += HRADCs_Info.HRADC_boards[0].offset;
-
-    temp[1] *= HRADCs_Info.HRADC_boards[1].gain * decimation_coeff;
-    temp[1] += HRADCs_Info.HRADC_boards[1].offset;
-
-    temp[2] *= HRADCs_Info.HRADC_boards[2].gain * decimation_coeff;
-    temp[2] += HRADCs_Info.HRADC_boards[2].offset;
-
-    temp[3] *= HRADCs_Info.HRADC_boards[3].gain * decimation_coeff;
-    temp[3] += HRADCs_Info.HRADC_boards[3].offset;
+    Read_HRADC_Samples(temp);
 
     if(NUM_DCCTs)
     {
@@ -861,19 +983,25 @@ static interrupt void isr_controller(void)
         I_ARM_1 = temp[2];
         I_ARM_2 = temp[3];
 
-        I_LOAD_MEAN = 0.5*(I_LOAD_1 + I_LOAD_2);
-        I_LOAD_DIFF = I_LOAD_1 - I_LOAD_2;
+        if(!PIN_STATUS_DCCT_2_STATUS)
+        {
+            set_dsp_redundancy_fault(REDUNDANCY_I_LOAD, 1);
+        }
     }
     else
     {
         I_LOAD_1 = temp[0];
         I_ARM_1 = temp[1];
         I_ARM_2 = temp[2];
+    }
 
-        I_LOAD_MEAN = I_LOAD_1;
-        I_LOAD_DIFF = 0;
+    if(!PIN_STATUS_DCCT_1_STATUS)
+    {
+        set_dsp_redundancy_fault(REDUNDANCY_I_LOAD, 0);
     }
 
+    run_dsp_redundancy(REDUNDANCY_I_LOAD);
+
     run_dsp_iir_2p2z(IIR_2P2Z_LPF_V_CAPBANK_ARM_1);
     run_dsp_iir_2p2z(IIR_2P2Z_LPF_V_CAPBANK_ARM_2);
 
@@ -881,32 +1009,11 @@ static interrupt void isr_controller(void)
     if(g_ipc_ctom.ps_module[0].ps_status.bit.state > Interlock)
     {
         /// Calculate reference according to operation mode
-        switch(g_ipc_ctom.ps_module[0].ps_status.bit.state)
-        {
-            case SlowRef:
-            case SlowRefSync:
-            {
-                run_dsp_srlim(SRLIM_I_LOAD_REFERENCE, USE_MODULE);
-                break;
-            }
-            case Cycle:
-            {
-                run_dsp_srlim(SRLIM_SIGGEN_AMP, USE_MODULE);
-                run_dsp_srlim(SRLIM_SIGGEN_OFFSET, USE_MODULE);
-                SIGGEN.p_run_siggen(&SIGGEN);
-                break;
-            }
-            case RmpWfm:
-            case MigWfm:
-            {
-                run_wfmref(&WFMREF);
-                break;
-            }
-            default:
-            {
-                break;
-            }
-        }
+        #ifdef USE_PIPELINED_REFERENCE
+        LATCH_PS_REFERENCE(&g_ipc_ctom.ps_module[0]);
+        #else
+        RUN_PS_REFERENCE(&g_ipc_ctom.ps_module[0]);
+        #endif
 
         /// Open-loop
         if(g_ipc_ctom.ps_module[0].ps_status.bit.openloop)
@@ -971,8 +1078,19 @@ static interrupt void isr_controller(void)
         set_pwm_duty_hbridge_chB(PWM_MODULATOR_Q1_MOD_4_8, DUTY_CYCLE_MOD_8);
     }
 
-    WFMREF_IDX = (float) (WFMREF.wfmref_data[WFMREF.wfmref_selected].p_buf_idx -
-                          WFMREF.wfmref_data[WFMREF.wfmref_selected].p_buf_start);
+    /*********************************************/
+    END_ISR_CRITICAL_PHASE(ISR_PROFILE, ISR_ELAPSED_CYCLES)
+    /*********************************************/
+
+    HRADCs_Info.HRADC_boards[0].SamplesBuffer = buffers_HRADC[0];
+    HRADCs_Info.HRADC_boards[1].SamplesBuffer = buffers_HRADC[1];
+    HRADCs_Info.HRADC_boards[2].SamplesBuffer = buffers_HRADC[2];
+    HRADCs_Info.HRADC_boards[3].SamplesBuffer = buffers_HRADC[3];
+
+    WFMREF_IDX = (float) (WFMREF.wfmref_data.p_buf_idx -
+                          WFMREF.wfmref_data.p_buf_start);
+
+    RUN_IPC_LATENCY;
 
     RUN_SCOPE(SCOPE);
     //CLEAR_DEBUG_GPIO1;
@@ -1009,6 +1127,18 @@ static interrupt void isr_controller(void)
     /// Re-enable XINT2 (external interrupt 2) interrupt used for sync pulses
     PieCtrlRegs.PIEIER1.bit.INTx5 = 1;
 
+    #ifdef USE_PIPELINED_REFERENCE
+    /// Calculate reference for next ISR
+    if(g_ipc_ctom.ps_module[0].ps_status.bit.state > Interlock)
+    {
+        run_ps_reference_ahead(&g_ipc_ctom.ps_module[0]);
+    }
+    #endif
+
+    /*********************************************/
+    END_ISR_DEFERRED_PHASE(ISR_PROFILE, ISR_ELAPSED_CYCLES)
+    /*********************************************/
+
     /// Clear interrupt flags for PWM interrupts
     PWM_MODULATOR_Q1_MOD_1_5->ETCLR.bit.INT = 1;
     PWM_MODULATOR_Q2_MOD_1_5->ETCLR.bit.INT = 1;
@@ -1025,6 +1155,11 @@ static interrupt void isr_controller(void)
  */
 static void enable_controller()
 {
+    if(!DMA_PLAN_IS_VALID(HRADCs_Info.DMA_PlanStatus))
+    {
+        return;
+    }
+
     stop_DMA();
     DELAY_US(5);
     start_DMA();
@@ -1057,7 +1192,7 @@ static void turn_on(uint16_t dummy)
     if(g_ipc_ctom.ps_module[0].ps_status.bit.state <= Initializing)
     #endif
     {
-        g_ipc_ctom.ps_module[0].ps_status.bit.state = Initializing;
+        cfg_ps_operation_mode(&g_ipc_ctom.ps_module[0], Initializing);
 
         if(PIN_STATUS_COMPLEMENTARY_PS_INTERLOCK)
         {
@@ -1077,7 +1212,7 @@ static void turn_on(uint16_t dummy)
             {
             #endif
 
-                g_ipc_ctom.ps_module[0].ps_status.bit.state = SlowRef;
+                cfg_ps_operation_mode(&g_ipc_ctom.ps_module[0], SlowRef);
 
                 enable_pwm_output(0);
                 enable_pwm_output(1);
@@ -1130,6 +1265,8 @@ static void reset_interlocks(uint16_t dummy)
     g_ipc_ctom.ps_module[0].ps_soft_interlock = 0;
     g_ipc_ctom.ps_module[0].ps_alarms = 0;
 
+    reset_dsp_redundancy(REDUNDANCY_I_LOAD);
+
     if(g_ipc_ctom.ps_module[0].ps_status.bit.state < Initializing)
     {
         g_ipc_ctom.ps_module[0].ps_status.bit.state = Off;
@@ -1174,28 +1311,18 @@ static inline void check_interlocks(void)
         set_soft_interlock(0, Arms_High_Difference);
     }
 
-    if(!PIN_STATUS_DCCT_1_STATUS)
-    {
-        set_soft_interlock(0, DCCT_1_Fault);
-    }
-
-    if( NUM_DCCTs && !PIN_STATUS_DCCT_2_STATUS )
-    {
-        set_soft_interlock(0, DCCT_2_Fault);
-    }
-
     if(PIN_STATUS_DCCT_1_ACTIVE)
     {
         if(fabs(I_LOAD_1) < MIN_I_ACTIVE_DCCT)
         {
-            set_soft_interlock(0, Load_Feedback_1_Fault);
+            set_dcct_fault(0, Load_Feedback_1_Fault);
         }
     }
     else
     {
         if(fabs(I_LOAD_1) > MAX_I_IDLE_DCCT)
         {
-            set_soft_interlock(0, Load_Feedback_1_Fault);
+            set_dcct_fault(0, Load_Feedback_1_Fault);
         }
     }
 
@@ -1205,18 +1332,40 @@ static inline void check_interlocks(void)
         {
             if(fabs(I_LOAD_2) < MIN_I_ACTIVE_DCCT)
             {
-                set_soft_interlock(0, Load_Feedback_2_Fault);
+                set_dcct_fault(1, Load_Feedback_2_Fault);
             }
         }
         else
         {
             if(fabs(I_LOAD_2) > MAX_I_IDLE_DCCT)
             {
-                set_soft_interlock(0, Load_Feedback_2_Fault);
+                set_dcct_fault(1, Load_Feedback_2_Fault);
             }
         }
     }
 
+    /**
+     * DCCT faults are detected on control ISR. Excluded DCCTs are logged as
+     * alarms, while faults that couldn't be isolated trip the power supply.
+     */
+    if(DCCTS_EXCLUDED & 0x0001)
+    {
+        g_ipc_ctom.ps_module[0].ps_alarms |= DCCT_1_Excluded;
+    }
+    else if(DCCTS_FAULT & 0x0001)
+    {
+        set_soft_interlock(0, DCCT_1_Fault);
+    }
+
+    if(DCCTS_EXCLUDED & 0x0002)
+    {
+        g_ipc_ctom.ps_module[0].ps_alarms |= DCCT_2_Excluded;
+    }
+    else if(DCCTS_FAULT & 0x0002)
+    {
+        set_soft_interlock(0, DCCT_2_Fault);
+    }
+
     check_capbank_overvoltage();
 
     DINT;
@@ -1256,6 +1405,25 @@ static inline void check_interlocks(void)
     }
 }
 
+/**
+ * Report fault on specified DCCT, detected on background loop. If it can't be
+ * excluded from load current measurement, set specified soft interlock.
+ *
+ * @param id DCCT index
+ * @param itlk soft interlock related to this fault
+ */
+static void set_dcct_fault(uint16_t id, soft_interlocks_t itlk)
+{
+    DINT;
+    set_dsp_redundancy_fault(REDUNDANCY_I_LOAD, id);
+    EINT;
+
+    if(!(DCCTS_EXCLUDED & (1 << id)))
+    {
+        set_soft_interlock(0, itlk);
+    }
+}
+
 static inline void check_capbank_undervoltage(void)
 {
     if(V_CAPBANK_MOD_1 < MIN_V_CAPBANK)
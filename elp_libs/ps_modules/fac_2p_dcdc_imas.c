@@ -9,7 +9,7 @@
  *****************************************************************************/
 
 /**
- * @file fac_2p_dcdc_imas.h
+ * @file fac_2p_dcdc_imas.c
  * @brief FAC-2P DC/DC Stage module for IMAS
  * 
  * Module for control of two DC/DC modules of FAC power supplies used by IMAS
@@ -46,6 +46,7 @@
 #include "ipc/ipc.h"
 #include "parameters/parameters.h"
 #include "pwm/pwm.h"
+#include "signals/signals.h"
 
 #include "fac_2p_dcdc_imas.h"
 
@@ -65,6 +66,9 @@
 #define MAX_V_CAPBANK               ANALOG_VARS_MAX[1]
 #define MIN_V_CAPBANK               ANALOG_VARS_MIN[1]
 
+/// Capacitor bank voltages are only used after LPF's, including by interlocks,
+/// so they use a lower ratio
+#define HRADC_OVERSAMPLING_V_CAPBANK        1
 
 #define MAX_I_ARM                   ANALOG_VARS_MAX[2]
 #define MAX_I_ARMS_DIFF             ANALOG_VARS_MAX[3]
@@ -168,6 +172,22 @@
 
 #define SCOPE                           SCOPE_CTOM[0]
 
+/**
+ * Uncomment to calculate references one sample ahead, on deferred phase of
+ * control ISR, removing reference generators from critical phase.
+ */
+//#define USE_PIPELINED_REFERENCE
+
+/**
+ * Uncomment to use compensated integrator on load current PI controller. See
+ * cfg_dsp_pi_integrator().
+ */
+//#define USE_COMPENSATED_INTEGRATOR
+
+/// Control ISR profile, measured by counter of ePWM module which triggered it
+#define ISR_PROFILE                     g_controller_ctom.isr_profile
+#define ISR_ELAPSED_CYCLES              GET_PWM_ELAPSED_CYCLES(p_pwm_isr)
+
 /**
  * Digital I/O's status
  */
@@ -192,6 +212,11 @@ typedef enum
     ACDC_Interlock
 } hard_interlocks_t;
 
+typedef enum
+{
+    High_Sync_Input_Frequency = 0x00000001
+} alarms_t;
+
 #define NUM_HARD_INTERLOCKS     ACDC_Interlock + 1
 #define NUM_SOFT_INTERLOCKS     0
 
@@ -199,13 +224,16 @@ typedef enum
  *  Private variables
  */
 static uint16_t decimation_factor;
-static float decimation_coeff;
+static ps_reference_gen_t reference_gens[NUM_PS_STATES];
 
 /**
  * Private functions
  */
 #pragma CODE_SECTION(isr_init_controller, "ramfuncs");
 #pragma CODE_SECTION(isr_controller, "ramfuncs");
+#pragma CODE_SECTION(run_reference_srlim, "ramfuncs");
+#pragma CODE_SECTION(run_reference_cycle, "ramfuncs");
+#pragma CODE_SECTION(run_reference_wfmref, "ramfuncs");
 #pragma CODE_SECTION(turn_off, "ramfuncs");
 
 static void init_peripherals_drivers(void);
@@ -213,11 +241,16 @@ static void term_peripherals_drivers(void);
 
 static void init_controller(void);
 static void reset_controller(void);
+static void update_i_share_controller(float freq_sampling);
 static void enable_controller();
 static void disable_controller();
 static interrupt void isr_init_controller(void);
 static interrupt void isr_controller(void);
 
+static void run_reference_srlim(volatile void *p_srlim);
+static void run_reference_cycle(volatile void *p_siggen);
+static void run_reference_wfmref(volatile void *p_wfmref);
+
 static void init_interruptions(void);
 static void term_interruptions(void);
 
@@ -244,6 +277,7 @@ void main_fac_2p_dcdc_imas(void)
     while(1)
     {
         check_interlocks();
+        run_ipc_deferred_work();
     }
 
     turn_off(0);
@@ -257,6 +291,7 @@ void main_fac_2p_dcdc_imas(void)
 static void init_peripherals_drivers(void)
 {
     uint16_t i;
+    tDMA_Plan dma_plan;
 
     /// Clear DC/DC interlock signal
     PIN_CLEAR_DCDC_INTERLOCK;
@@ -264,13 +299,17 @@ static void init_peripherals_drivers(void)
     /// Initialization of HRADC boards
     stop_DMA();
 
-    decimation_factor = (uint16_t) roundf(HRADC_FREQ_SAMP / ISR_CONTROL_FREQ);
-    decimation_coeff = 1.0 / (float) decimation_factor;
+    HRADCs_Info.DMA_PlanStatus = Plan_DMA_McBSP_nBuffers(&dma_plan, NUM_HRADC_BOARDS,
+                                                         HRADC_SPI_CLK,
+                                                         HRADC_FREQ_SAMP,
+                                                         ISR_CONTROL_FREQ);
+
+    decimation_factor = dma_plan.size_buffers;
 
     HRADCs_Info.enable_Sampling = 0;
     HRADCs_Info.n_HRADC_boards = NUM_HRADC_BOARDS;
 
-    Init_DMA_McBSP_nBuffers(NUM_HRADC_BOARDS, decimation_factor, HRADC_SPI_CLK);
+    Init_DMA_McBSP_nBuffers(&dma_plan);
 
     Init_SPIMaster_McBSP(HRADC_SPI_CLK);
     Init_SPIMaster_Gpio();
@@ -288,6 +327,13 @@ static void init_peripherals_drivers(void)
                            HRADC_HEATER_ENABLE[i], HRADC_MONITOR_ENABLE[i]);
     }
 
+    Config_HRADC_Oversampling(&HRADCs_Info.HRADC_boards[1],
+                              HRADC_OVERSAMPLING_V_CAPBANK);
+    Config_HRADC_Oversampling(&HRADCs_Info.HRADC_boards[2],
+                              HRADC_OVERSAMPLING_V_CAPBANK);
+
+    register_hradc_signals(NUM_HRADC_BOARDS);
+
     Config_HRADC_SoC(HRADC_FREQ_SAMP);
 
     /**
@@ -370,8 +416,8 @@ static void init_controller(void)
     init_ipc();
 
     init_wfmref(&WFMREF, WFMREF_SELECTED_PARAM[0], WFMREF_SYNC_MODE_PARAM[0],
-                ISR_CONTROL_FREQ, WFMREF_FREQUENCY_PARAM[0], WFMREF_GAIN_PARAM[0],
-                WFMREF_OFFSET_PARAM[0], &g_wfmref_data.data, SIZE_WFMREF,
+                ISR_CONTROL_FREQ, WFMREF_FREQUENCY_PARAM[0],
+                WFMREF_GAIN_PARAM[0], WFMREF_OFFSET_PARAM[0],
                 &I_LOAD_REFERENCE);
 
     /***********************************************/
@@ -446,6 +492,10 @@ static void init_controller(void)
     init_dsp_pi(PI_CONTROLLER_I_LOAD, KP_I_LOAD, KI_I_LOAD, ISR_CONTROL_FREQ,
                 PWM_MAX_DUTY, PWM_MIN_DUTY, &I_LOAD_ERROR, &DUTY_I_LOAD_PI);
 
+    #ifdef USE_COMPENSATED_INTEGRATOR
+    cfg_dsp_pi_integrator(PI_CONTROLLER_I_LOAD, COMPENSATED_INTEGRATOR);
+    #endif
+
     /**
      *        name:     IIR_2P2Z_REFERENCE_FEEDFORWARD
      * description:     Load current reference feedforward IIR 2P2Z controller
@@ -565,6 +615,53 @@ static void init_controller(void)
      */
     init_timeslicer(&TIMESLICER_I_SHARE_CONTROLLER, ISR_CONTROL_FREQ);
     cfg_timeslicer(&TIMESLICER_I_SHARE_CONTROLLER, I_SHARE_CONTROLLER_FREQ_SAMP);
+    cfg_timeslicer_update(TIMESLICER_I_SHARE_CONTROLLER_IDX,
+                          &update_i_share_controller);
+
+    /********************************************/
+    /** INITIALIZATION OF REFERENCE GENERATORS **/
+    /********************************************/
+
+    init_ps_reference(&g_ipc_ctom.ps_module[0], reference_gens);
+
+    cfg_ps_reference(&g_ipc_ctom.ps_module[0], SlowRef,
+                     &run_reference_srlim, SRLIM_I_LOAD_REFERENCE);
+    cfg_ps_reference(&g_ipc_ctom.ps_module[0], SlowRefSync,
+                     &run_reference_srlim, SRLIM_I_LOAD_REFERENCE);
+    cfg_ps_reference(&g_ipc_ctom.ps_module[0], Cycle,
+                     &run_reference_cycle, &SIGGEN);
+    cfg_ps_reference(&g_ipc_ctom.ps_module[0], RmpWfm,
+                     &run_reference_wfmref, &WFMREF);
+    cfg_ps_reference(&g_ipc_ctom.ps_module[0], MigWfm,
+                     &run_reference_wfmref, &WFMREF);
+
+    /****************************************/
+    /** INITIALIZATION OF SIGNALS REGISTRY **/
+    /****************************************/
+
+    init_signals();
+
+    REGISTER_SIGNAL(I_LOAD_SETPOINT, is_float, Unit_Ampere);
+    REGISTER_SIGNAL(I_LOAD_REFERENCE, is_float, Unit_Ampere);
+    REGISTER_SIGNAL(I_LOAD, is_float, Unit_Ampere);
+    REGISTER_SIGNAL(V_CAPBANK_MOD_1, is_float, Unit_Volt);
+    REGISTER_SIGNAL(V_CAPBANK_MOD_2, is_float, Unit_Volt);
+    REGISTER_SIGNAL(I_LOAD_ERROR, is_float, Unit_Ampere);
+    REGISTER_SIGNAL(DUTY_I_LOAD_PI, is_float, Unit_Duty);
+    REGISTER_SIGNAL(DUTY_REF_FF, is_float, Unit_Duty);
+    REGISTER_SIGNAL(DUTY_MEAN, is_float, Unit_Duty);
+    REGISTER_SIGNAL(I_ARMS_DIFF, is_float, Unit_Ampere);
+    REGISTER_SIGNAL(DUTY_ARMS_DIFF, is_float, Unit_Duty);
+    REGISTER_SIGNAL(V_CAPBANK_MOD_1_FILTERED, is_float, Unit_Volt);
+    REGISTER_SIGNAL(V_CAPBANK_MOD_2_FILTERED, is_float, Unit_Volt);
+    REGISTER_SIGNAL(IN_FF_V_CAPBANK_MOD_1, is_float, Unit_Duty);
+    REGISTER_SIGNAL(IN_FF_V_CAPBANK_MOD_2, is_float, Unit_Duty);
+    REGISTER_SIGNAL(WFMREF_IDX, is_float, Unit_None);
+    REGISTER_SIGNAL(DUTY_CYCLE_MOD_1, is_float, Unit_Duty);
+    REGISTER_SIGNAL(DUTY_CYCLE_MOD_2, is_float, Unit_Duty);
+
+    REGISTER_DSP_PI_INTEGRATOR(PI_CONTROLLER_I_LOAD, Unit_Duty);
+    REGISTER_DSP_PI_INTEGRATOR(PI_CONTROLLER_I_ARMS_SHARE, Unit_Duty);
 
     /******************************/
     /** INITIALIZATION OF SCOPES **/
@@ -601,8 +698,8 @@ static void reset_controller(void)
     reset_dsp_error(ERROR_I_ARMS_SHARE);
     reset_dsp_pi(PI_CONTROLLER_I_ARMS_SHARE);
 
-    reset_dsp_iir_2p2z(IIR_2P2Z_LPF_V_CAPBANK_MOD_1);
-    reset_dsp_iir_2p2z(IIR_2P2Z_LPF_V_CAPBANK_MOD_2);
+    /// V_CAPBANK LPF's are kept running, so interlocks don't see a false
+    /// undervoltage right after turn off
 
     reset_dsp_vdclink_ff(FF_V_CAPBANK_MOD_1);
     reset_dsp_vdclink_ff(FF_V_CAPBANK_MOD_2);
@@ -614,6 +711,49 @@ static void reset_controller(void)
     reset_wfmref(&WFMREF);
 }
 
+/**
+ * Re-derive current share controller coefficients from new sampling frequency
+ * of its time slicer, set by ARM through Cfg_TimeSlicer.
+ *
+ * @param freq_sampling new sampling frequency [Hz]
+ */
+static void update_i_share_controller(float freq_sampling)
+{
+    cfg_dsp_pi_freq(PI_CONTROLLER_I_ARMS_SHARE, freq_sampling);
+}
+
+/**
+ * Reference generator for SlowRef and SlowRefSync operation modes.
+ *
+ * @param p_srlim pointer to reference slew-rate limiter
+ */
+static void run_reference_srlim(volatile void *p_srlim)
+{
+    run_dsp_srlim((dsp_srlim_t *) p_srlim, USE_MODULE);
+}
+
+/**
+ * Reference generator for Cycle operation mode.
+ *
+ * @param p_siggen pointer to signal generator
+ */
+static void run_reference_cycle(volatile void *p_siggen)
+{
+    run_dsp_srlim(SRLIM_SIGGEN_AMP, USE_MODULE);
+    run_dsp_srlim(SRLIM_SIGGEN_OFFSET, USE_MODULE);
+    ((siggen_t *) p_siggen)->p_run_siggen((siggen_t *) p_siggen);
+}
+
+/**
+ * Reference generator for RmpWfm and MigWfm operation modes.
+ *
+ * @param p_wfmref pointer to waveform reference
+ */
+static void run_reference_wfmref(volatile void *p_wfmref)
+{
+    run_wfmref((wfmref_t *) p_wfmref);
+}
+
 /**
  * Initialization of interruptions.
  */
@@ -692,6 +832,17 @@ static interrupt void isr_init_controller(void)
     //PWM_MODULATOR_MOD_2_NEG->ETSEL.bit.INTSEL = ET_CTR_ZERO;
     //PWM_MODULATOR_MOD_2_NEG->ETCLR.bit.INT = 1;
 
+    /**
+     *  Enable XINT2 (external interrupt 2) interrupt used for sync pulses for
+     *  the first time
+     *
+     *  TODO: include here mechanism described in section 1.5.4.3 from F28M36
+     *  Technical Reference Manual (SPRUHE8E) to clear flag before enabling, to
+     *  avoid false alarms that may occur when sync pulses are received during
+     *  firmware initialization.
+     */
+    PieCtrlRegs.PIEIER1.bit.INTx5 = 1;
+
     PieCtrlRegs.PIEACK.all |= M_INT3;
 }
 
@@ -701,47 +852,20 @@ static interrupt void isr_init_controller(void)
 static interrupt void isr_controller(void)
 {
     static float temp[4];
-    static uint16_t i;
+    volatile struct EPWM_REGS *p_pwm_isr;
+
+    p_pwm_isr = GET_PWM_ISR_MODULE;
 
     //CLEAR_DEBUG_GPIO1;
     //SET_DEBUG_GPIO0;
     SET_DEBUG_GPIO1;
 
-    temp[0] = 0.0;
-    temp[1] = 0.0;
-    temp[2] = 0.0;
-    temp[3] = 0.0;
-
     /// Get HRADC samples
-    for(i = 0; i < decimation_factor; i++)
-    {
-        temp[0] += (float) *(HRADCs_Info.HRADC_boards[0].SamplesBuffer++);
-        temp[1] += (float) *(HRADCs_Info.HRADC_boards[1].SamplesBuffer++);
-        temp[2] += (float) *(HRADCs_Info.HRADC_boards[2].SamplesBuffer++);
-        temp[3] += (float) *(HRADCs_Info.HRADC_boards[3].SamplesBuffer++);
-    }
-
-    //CLEAR_DEBUG_GPIO1;
-
-    HRADCs_Info.HRADC_boards[0].SamplesBuffer = buffers_HRADC[0];
-    HRADCs_Info.HRADC_boards[1].SamplesBuffer = buffers_HRADC[1];
-    HRADCs_Info.HRADC_boards[2].SamplesBuffer = buffers_HRADC[2];
-    HRADCs_Info.HRADC_boards[3].SamplesBuffer = buffers_HRADC[3];
+    Read_HRADC_Samples(temp);
 
-    temp[0] *= HRADCs_Info.HRADC_boards[0].gain * decimation_coeff;
-    temp[0] += HRADCs_Info.HRADC_boards[0].offset;
     temp[0] *= I_LOAD_CAL_GAIN;
     temp[0] += I_LOAD_CAL_OFFSET;
 
-    temp[1] *= HRADCs_Info.HRADC_boards[1].gain * decimation_coeff;
-    temp[1] += HRADCs_Info.HRADC_boards[1].offset;
-
-    temp[2] *= HRADCs_Info.HRADC_boards[2].gain * decimation_coeff;
-    temp[2] += HRADCs_Info.HRADC_boards[2].offset;
-
-    temp[3] *= HRADCs_Info.HRADC_boards[3].gain * decimation_coeff;
-    temp[3] += HRADCs_Info.HRADC_boards[3].offset;
-
     I_LOAD = temp[0];
     V_CAPBANK_MOD_1 = temp[1];
     V_CAPBANK_MOD_2 = temp[2];
@@ -753,32 +877,11 @@ static interrupt void isr_controller(void)
     if(g_ipc_ctom.ps_module[0].ps_status.bit.state > Interlock)
     {
         /// Calculate reference according to operation mode
-        switch(g_ipc_ctom.ps_module[0].ps_status.bit.state)
-        {
-            case SlowRef:
-            case SlowRefSync:
-            {
-                run_dsp_srlim(SRLIM_I_LOAD_REFERENCE, USE_MODULE);
-                break;
-            }
-            case Cycle:
-            {
-                run_dsp_srlim(SRLIM_SIGGEN_AMP, USE_MODULE);
-                run_dsp_srlim(SRLIM_SIGGEN_OFFSET, USE_MODULE);
-                SIGGEN.p_run_siggen(&SIGGEN);
-                break;
-            }
-            case RmpWfm:
-            case MigWfm:
-            {
-                run_wfmref(&WFMREF);
-                break;
-            }
-            default:
-            {
-                break;
-            }
-        }
+        #ifdef USE_PIPELINED_REFERENCE
+        LATCH_PS_REFERENCE(&g_ipc_ctom.ps_module[0]);
+        #else
+        RUN_PS_REFERENCE(&g_ipc_ctom.ps_module[0]);
+        #endif
 
         /// Open-loop
         if(g_ipc_ctom.ps_module[0].ps_status.bit.openloop)
@@ -835,13 +938,66 @@ static interrupt void isr_controller(void)
         set_pwm_duty_hbridge(PWM_MODULATOR_MOD_2, DUTY_CYCLE_MOD_2);
     }
 
-    WFMREF_IDX = (float) (WFMREF.wfmref_data[WFMREF.wfmref_selected].p_buf_idx -
-                          WFMREF.wfmref_data[WFMREF.wfmref_selected].p_buf_start);
+    /*********************************************/
+    END_ISR_CRITICAL_PHASE(ISR_PROFILE, ISR_ELAPSED_CYCLES)
+    /*********************************************/
+
+    HRADCs_Info.HRADC_boards[0].SamplesBuffer = buffers_HRADC[0];
+    HRADCs_Info.HRADC_boards[1].SamplesBuffer = buffers_HRADC[1];
+    HRADCs_Info.HRADC_boards[2].SamplesBuffer = buffers_HRADC[2];
+    HRADCs_Info.HRADC_boards[3].SamplesBuffer = buffers_HRADC[3];
+
+    WFMREF_IDX = (float) (WFMREF.wfmref_data.p_buf_idx -
+                          WFMREF.wfmref_data.p_buf_start);
+
+    RUN_IPC_LATENCY;
 
     RUN_SCOPE(SCOPE);
 
     SET_INTERLOCKS_TIMEBASE_FLAG(0);
 
+    /**
+     * Re-enable external interrupt 2 (XINT2) interrupts to allow sync pulses to
+     * be handled once per isr_controller
+     */
+    if(PieCtrlRegs.PIEIER1.bit.INTx5 == 0)
+    {
+        /// Set alarm if counter is below limit when receiving new sync pulse
+        if(counter_sync_period < MIN_NUM_ISR_CONTROLLER_SYNC)
+        {
+            g_ipc_ctom.ps_module[0].ps_alarms = High_Sync_Input_Frequency;
+        }
+
+        /// Store counter value on BSMP variable
+        g_ipc_ctom.period_sync_pulse = counter_sync_period;
+        counter_sync_period = 0;
+    }
+
+    counter_sync_period++;
+
+    /**
+     * Reset counter to threshold to avoid false alarms during its overflow
+     */
+    if(counter_sync_period == MAX_NUM_ISR_CONTROLLER_SYNC)
+    {
+        counter_sync_period = MIN_NUM_ISR_CONTROLLER_SYNC;
+    }
+
+    /// Re-enable XINT2 (external interrupt 2) interrupt used for sync pulses
+    PieCtrlRegs.PIEIER1.bit.INTx5 = 1;
+
+    #ifdef USE_PIPELINED_REFERENCE
+    /// Calculate reference for next ISR
+    if(g_ipc_ctom.ps_module[0].ps_status.bit.state > Interlock)
+    {
+        run_ps_reference_ahead(&g_ipc_ctom.ps_module[0]);
+    }
+    #endif
+
+    /*********************************************/
+    END_ISR_DEFERRED_PHASE(ISR_PROFILE, ISR_ELAPSED_CYCLES)
+    /*********************************************/
+
     PWM_MODULATOR_MOD_1->ETCLR.bit.INT = 1;
     PWM_MODULATOR_MOD_1_NEG->ETCLR.bit.INT = 1;
 
@@ -855,6 +1011,11 @@ static interrupt void isr_controller(void)
  */
 static void enable_controller()
 {
+    if(!DMA_PLAN_IS_VALID(HRADCs_Info.DMA_PlanStatus))
+    {
+        return;
+    }
+
     stop_DMA();
     DELAY_US(5);
     start_DMA();
@@ -881,14 +1042,14 @@ static void disable_controller()
  */
 static void turn_on(uint16_t dummy)
 {
-    if(V_CAPBANK_MOD_1 < MIN_V_CAPBANK)
+    if(V_CAPBANK_MOD_1_FILTERED < MIN_V_CAPBANK)
     {
         PIN_SET_DCDC_INTERLOCK;
         BYPASS_HARD_INTERLOCK_DEBOUNCE(0, Module_1_CapBank_Undervoltage);
         set_hard_interlock(0, Module_1_CapBank_Undervoltage);
     }
 
-    if(V_CAPBANK_MOD_2 < MIN_V_CAPBANK)
+    if(V_CAPBANK_MOD_2_FILTERED < MIN_V_CAPBANK)
     {
         PIN_SET_DCDC_INTERLOCK;
         BYPASS_HARD_INTERLOCK_DEBOUNCE(0, Module_2_CapBank_Undervoltage);
@@ -904,7 +1065,7 @@ static void turn_on(uint16_t dummy)
         reset_controller();
 
         g_ipc_ctom.ps_module[0].ps_status.bit.openloop = OPEN_LOOP;
-        g_ipc_ctom.ps_module[0].ps_status.bit.state = SlowRef;
+        cfg_ps_operation_mode(&g_ipc_ctom.ps_module[0], SlowRef);
         enable_pwm_output(0);
         enable_pwm_output(1);
         enable_pwm_output(2);
@@ -941,6 +1102,7 @@ static void reset_interlocks(uint16_t dummy)
 {
     g_ipc_ctom.ps_module[0].ps_hard_interlock = 0;
     g_ipc_ctom.ps_module[0].ps_soft_interlock = 0;
+    g_ipc_ctom.ps_module[0].ps_alarms = 0;
 
     if(g_ipc_ctom.ps_module[0].ps_status.bit.state < Initializing)
     {
@@ -960,13 +1122,13 @@ static inline void check_interlocks(void)
         set_hard_interlock(0, Load_Overcurrent);
     }
 
-    if(V_CAPBANK_MOD_1 > MAX_V_CAPBANK)
+    if(V_CAPBANK_MOD_1_FILTERED > MAX_V_CAPBANK)
     {
         PIN_SET_DCDC_INTERLOCK;
         set_hard_interlock(0, Module_1_CapBank_Overvoltage);
     }
 
-    if(V_CAPBANK_MOD_2 > MAX_V_CAPBANK)
+    if(V_CAPBANK_MOD_2_FILTERED > MAX_V_CAPBANK)
     {
         PIN_SET_DCDC_INTERLOCK;
         set_hard_interlock(0, Module_2_CapBank_Overvoltage);
@@ -999,13 +1161,13 @@ static inline void check_interlocks(void)
 
     if(g_ipc_ctom.ps_module[0].ps_status.bit.state > Interlock)
     {
-        if(V_CAPBANK_MOD_1 < MIN_V_CAPBANK)
+        if(V_CAPBANK_MOD_1_FILTERED < MIN_V_CAPBANK)
         {
             PIN_SET_DCDC_INTERLOCK;
             set_hard_interlock(0, Module_1_CapBank_Undervoltage);
         }
 
-        if(V_CAPBANK_MOD_2 < MIN_V_CAPBANK)
+        if(V_CAPBANK_MOD_2_FILTERED < MIN_V_CAPBANK)
         {
             PIN_SET_DCDC_INTERLOCK;
             set_hard_interlock(0, Module_2_CapBank_Undervoltage);
@@ -32,6 +32,7 @@
 #include "ipc/ipc.h"
 #include "parameters/parameters.h"
 #include "pwm/pwm.h"
+#include "signals/signals.h"
 
 #include "fac_2s_acdc.h"
 
@@ -169,6 +170,10 @@
 #define SCOPE_MOD_A                 SCOPE_CTOM[0]
 #define SCOPE_MOD_B                 SCOPE_CTOM[1]
 
+/// Control ISR profile, measured by ePWM1 counter (HRADC sampling reference)
+#define ISR_PROFILE                 g_controller_ctom.isr_profile
+#define ISR_ELAPSED_CYCLES          GET_PWM_ELAPSED_CYCLES(PWM_MODULATOR_MOD_A)
+
 /// Notch filters alpha coefficient
 #define NF_ALPHA                    0.99
 
@@ -209,13 +214,14 @@ typedef enum
  *  Private variables
  */
 static float decimation_factor;
-static float decimation_coeff;
+static ps_reference_gen_t reference_gens[NUM_PS_STATES];
 
 /**
  * Private functions
  */
 #pragma CODE_SECTION(isr_init_controller, "ramfuncs");
 #pragma CODE_SECTION(isr_controller, "ramfuncs");
+#pragma CODE_SECTION(run_reference_srlim, "ramfuncs");
 #pragma CODE_SECTION(turn_off, "ramfuncs");
 
 static void init_peripherals_drivers(void);
@@ -230,6 +236,8 @@ static void disable_controller();
 static interrupt void isr_init_controller(void);
 static interrupt void isr_controller(void);
 
+static void run_reference_srlim(volatile void *p_srlim);
+
 static void init_interruptions(void);
 static void term_interruptions(void);
 
@@ -256,6 +264,7 @@ void main_fac_2s_acdc(void)
     while(1)
     {
         check_interlocks();
+        run_ipc_deferred_work();
     }
 
     turn_off(0);
@@ -269,18 +278,23 @@ void main_fac_2s_acdc(void)
 static void init_peripherals_drivers(void)
 {
     uint16_t i;
+    tDMA_Plan dma_plan;
 
     /// Initialization of HRADC boards
     stop_DMA();
 
-    decimation_factor = HRADC_FREQ_SAMP / ISR_CONTROL_FREQ;
-    decimation_coeff = 1.0 / decimation_factor;
+    HRADCs_Info.DMA_PlanStatus = Plan_DMA_McBSP_nBuffers(&dma_plan, NUM_HRADC_BOARDS,
+                                                         HRADC_SPI_CLK,
+                                                         HRADC_FREQ_SAMP,
+                                                         ISR_CONTROL_FREQ);
+
+    decimation_factor = dma_plan.size_buffers;
 
 
     HRADCs_Info.enable_Sampling = 0;
     HRADCs_Info.n_HRADC_boards = NUM_HRADC_BOARDS;
 
-    Init_DMA_McBSP_nBuffers(NUM_HRADC_BOARDS, decimation_factor, HRADC_SPI_CLK);
+    Init_DMA_McBSP_nBuffers(&dma_plan);
 
     Init_SPIMaster_McBSP(HRADC_SPI_CLK);
     Init_SPIMaster_Gpio();
@@ -298,6 +312,8 @@ static void init_peripherals_drivers(void)
                            HRADC_HEATER_ENABLE[i], HRADC_MONITOR_ENABLE[i]);
     }
 
+    register_hradc_signals(NUM_HRADC_BOARDS);
+
     Config_HRADC_SoC(HRADC_FREQ_SAMP);
 
     /// Initialization of PWM modules
@@ -395,6 +411,52 @@ static void init_controller(void)
      */
     init_timeslicer(&TIMESLICER_CONTROLLER, ISR_CONTROL_FREQ);
     cfg_timeslicer(&TIMESLICER_CONTROLLER, CONTROLLER_FREQ_SAMP);
+    lock_timeslicer(TIMESLICER_CONTROLLER_IDX);
+
+    /********************************************/
+    /** INITIALIZATION OF REFERENCE GENERATORS **/
+    /********************************************/
+
+    init_ps_reference(&g_ipc_ctom.ps_module[0], reference_gens);
+
+    cfg_ps_reference(&g_ipc_ctom.ps_module[0], SlowRef,
+                     &run_reference_srlim, SRLIM_V_CAPBANK_REFERENCE);
+    cfg_ps_reference(&g_ipc_ctom.ps_module[0], SlowRefSync,
+                     &run_reference_srlim, SRLIM_V_CAPBANK_REFERENCE);
+
+    /****************************************/
+    /** INITIALIZATION OF SIGNALS REGISTRY **/
+    /****************************************/
+
+    init_signals();
+
+    REGISTER_SIGNAL(V_CAPBANK_SETPOINT, is_float, Unit_Volt);
+    REGISTER_SIGNAL(V_CAPBANK_REFERENCE, is_float, Unit_Volt);
+    REGISTER_SIGNAL(V_CAPBANK_MOD_A, is_float, Unit_Volt);
+    REGISTER_SIGNAL(I_OUT_RECT_MOD_A, is_float, Unit_Ampere);
+    REGISTER_SIGNAL(V_CAPBANK_MOD_B, is_float, Unit_Volt);
+    REGISTER_SIGNAL(I_OUT_RECT_MOD_B, is_float, Unit_Ampere);
+    REGISTER_SIGNAL(V_CAPBANK_FILTERED_2HZ_MOD_A, is_float, Unit_Volt);
+    REGISTER_SIGNAL(V_CAPBANK_FILTERED_2Hz_4HZ_MOD_A, is_float, Unit_Volt);
+    REGISTER_SIGNAL(V_CAPBANK_ERROR_MOD_A, is_float, Unit_Volt);
+    REGISTER_SIGNAL(I_OUT_RECT_REF_MOD_A, is_float, Unit_Ampere);
+    REGISTER_SIGNAL(I_OUT_RECT_ERROR_MOD_A, is_float, Unit_Ampere);
+    REGISTER_SIGNAL(I_OUT_RECT_RESS_2HZ_MOD_A, is_float, Unit_Ampere);
+    REGISTER_SIGNAL(I_OUT_RECT_RESS_2HZ_4HZ_MOD_A, is_float, Unit_Ampere);
+    REGISTER_SIGNAL(V_CAPBANK_FILTERED_2HZ_MOD_B, is_float, Unit_Volt);
+    REGISTER_SIGNAL(V_CAPBANK_FILTERED_2Hz_4HZ_MOD_B, is_float, Unit_Volt);
+    REGISTER_SIGNAL(V_CAPBANK_ERROR_MOD_B, is_float, Unit_Volt);
+    REGISTER_SIGNAL(I_OUT_RECT_REF_MOD_B, is_float, Unit_Ampere);
+    REGISTER_SIGNAL(I_OUT_RECT_ERROR_MOD_B, is_float, Unit_Ampere);
+    REGISTER_SIGNAL(I_OUT_RECT_RESS_2HZ_MOD_B, is_float, Unit_Ampere);
+    REGISTER_SIGNAL(I_OUT_RECT_RESS_2HZ_4HZ_MOD_B, is_float, Unit_Ampere);
+    REGISTER_SIGNAL(DUTY_CYCLE_MOD_A, is_float, Unit_Duty);
+    REGISTER_SIGNAL(DUTY_CYCLE_MOD_B, is_float, Unit_Duty);
+
+    REGISTER_DSP_PI_INTEGRATOR(PI_CONTROLLER_V_CAPBANK_MOD_A, Unit_Ampere);
+    REGISTER_DSP_PI_INTEGRATOR(PI_CONTROLLER_I_OUT_RECT_MOD_A, Unit_Duty);
+    REGISTER_DSP_PI_INTEGRATOR(PI_CONTROLLER_V_CAPBANK_MOD_B, Unit_Ampere);
+    REGISTER_DSP_PI_INTEGRATOR(PI_CONTROLLER_I_OUT_RECT_MOD_B, Unit_Duty);
 
     /******************************/
     /** INITIALIZATION OF SCOPES **/
@@ -459,6 +521,11 @@ static void reset_controller(void)
  */
 static void enable_controller()
 {
+    if(!DMA_PLAN_IS_VALID(HRADCs_Info.DMA_PlanStatus))
+    {
+        return;
+    }
+
     stop_DMA();
     DELAY_US(5);
     start_DMA();
@@ -499,43 +566,12 @@ static interrupt void isr_init_controller(void)
 static interrupt void isr_controller(void)
 {
     static float temp[4];
-    static uint16_t i;
 
     //SET_DEBUG_GPIO0;
     SET_DEBUG_GPIO1;
 
-    temp[0] = 0.0;
-    temp[1] = 0.0;
-    temp[2] = 0.0;
-    temp[3] = 0.0;
-
     /// Get HRADC samples
-    for(i = 0; i < decimation_factor; i++)
-    {
-        temp[0] += (float) *(HRADCs_Info.HRADC_boards[0].SamplesBuffer++);
-        temp[1] += (float) *(HRADCs_Info.HRADC_boards[1].SamplesBuffer++);
-        temp[2] += (float) *(HRADCs_Info.HRADC_boards[2].SamplesBuffer++);
-        temp[3] += (float) *(HRADCs_Info.HRADC_boards[3].SamplesBuffer++);
-    }
-
-    //CLEAR_DEBUG_GPIO1;
-
-    HRADCs_Info.HRADC_boards[0].SamplesBuffer = buffers_HRADC[0];
-    HRADCs_Info.HRADC_boards[1].SamplesBuffer = buffers_HRADC[1];
-    HRADCs_Info.HRADC_boards[2].SamplesBuffer = buffers_HRADC[2];
-    HRADCs_Info.HRADC_boards[3].SamplesBuffer = buffers_HRADC[3];
-
-    temp[0] *= HRADCs_Info.HRADC_boards[0].gain * decimation_coeff;
-    temp[0] += HRADCs_Info.HRADC_boards[0].offset;
-
-    temp[1] *= HRADCs_Info.HRADC_boards[1].gain * decimation_coeff;
-    temp[1] += HRADCs_Info.HRADC_boards[1].offset;
-
-    temp[2] *= HRADCs_Info.HRADC_boards[2].gain * decimation_coeff;
-    temp[2] += HRADCs_Info.HRADC_boards[2].offset;
-
-    temp[3] *= HRADCs_Info.HRADC_boards[3].gain * decimation_coeff;
-    temp[3] += HRADCs_Info.HRADC_boards[3].offset;
+    Read_HRADC_Samples(temp);
 
     V_CAPBANK_MOD_A = temp[0];
     I_OUT_RECT_MOD_A = temp[1];
@@ -557,31 +593,7 @@ static interrupt void isr_controller(void)
         if(g_ipc_ctom.ps_module[0].ps_status.bit.state > Interlock)
         {
             /// Calculate reference according to operation mode
-            switch(g_ipc_ctom.ps_module[0].ps_status.bit.state)
-            {
-                case SlowRef:
-                case SlowRefSync:
-                {
-                    run_dsp_srlim(SRLIM_V_CAPBANK_REFERENCE, USE_MODULE);
-                    break;
-                }
-                case Cycle:
-                {
-                    break;
-                }
-                case RmpWfm:
-                {
-                    break;
-                }
-                case MigWfm:
-                {
-                    break;
-                }
-                default:
-                {
-                    break;
-                }
-            }
+            RUN_PS_REFERENCE(&g_ipc_ctom.ps_module[0]);
 
             /// Open-loop
             if(g_ipc_ctom.ps_module[0].ps_status.bit.openloop)
@@ -626,18 +638,43 @@ static interrupt void isr_controller(void)
     END_TIMESLICER(TIMESLICER_CONTROLLER)
     /*********************************************/
 
+    /*********************************************/
+    END_ISR_CRITICAL_PHASE(ISR_PROFILE, ISR_ELAPSED_CYCLES)
+    /*********************************************/
+
+    HRADCs_Info.HRADC_boards[0].SamplesBuffer = buffers_HRADC[0];
+    HRADCs_Info.HRADC_boards[1].SamplesBuffer = buffers_HRADC[1];
+    HRADCs_Info.HRADC_boards[2].SamplesBuffer = buffers_HRADC[2];
+    HRADCs_Info.HRADC_boards[3].SamplesBuffer = buffers_HRADC[3];
+
+    RUN_IPC_LATENCY;
+
     RUN_SCOPE(SCOPE_MOD_A);
     RUN_SCOPE(SCOPE_MOD_B);
 
     SET_INTERLOCKS_TIMEBASE_FLAG(0);
     SET_INTERLOCKS_TIMEBASE_FLAG(1);
 
+    /*********************************************/
+    END_ISR_DEFERRED_PHASE(ISR_PROFILE, ISR_ELAPSED_CYCLES)
+    /*********************************************/
+
     PWM_MODULATOR_MOD_A->ETCLR.bit.INT = 1;
     PieCtrlRegs.PIEACK.all |= M_INT3;
 
     CLEAR_DEBUG_GPIO1;
 }
 
+/**
+ * Reference generator for SlowRef and SlowRefSync operation modes.
+ *
+ * @param p_srlim pointer to reference slew-rate limiter
+ */
+static void run_reference_srlim(volatile void *p_srlim)
+{
+    run_dsp_srlim((dsp_srlim_t *) p_srlim, USE_MODULE);
+}
+
 /**
  * Initialization of interruptions.
  */
@@ -690,7 +727,7 @@ static void turn_on(uint16_t dummy)
     if(g_ipc_ctom.ps_module[MOD_A_ID].ps_status.bit.state <= Interlock)
     #endif
     {
-        g_ipc_ctom.ps_module[MOD_A_ID].ps_status.bit.state = Initializing;
+        cfg_ps_operation_mode(&g_ipc_ctom.ps_module[MOD_A_ID], Initializing);
 
         if(V_OUT_RECT_MOD_A < MIN_V_OUT_RECT)
         {
@@ -737,7 +774,7 @@ static void turn_on(uint16_t dummy)
             {
             #endif
 
-                g_ipc_ctom.ps_module[MOD_A_ID].ps_status.bit.state = SlowRef;
+                cfg_ps_operation_mode(&g_ipc_ctom.ps_module[MOD_A_ID], SlowRef);
 
                 enable_pwm_output(MOD_A_ID);
                 enable_pwm_output(MOD_B_ID);
@@ -44,6 +44,7 @@
 #include "ipc/ipc.h"
 #include "parameters/parameters.h"
 #include "pwm/pwm.h"
+#include "signals/signals.h"
 
 #include "fac_2s_dcdc.h"
 
@@ -55,6 +56,10 @@
 #define MAX_V_CAPBANK           ANALOG_VARS_MAX[1]
 #define MIN_V_CAPBANK           ANALOG_VARS_MIN[1]
 
+/// Modules capacitor bank voltages are only used after LPF, including by
+/// interlocks, so they average fewer samples than load currents
+#define HRADC_OVERSAMPLING_V_CAPBANK    1
+
 #define MAX_DCCTS_DIFF          ANALOG_VARS_MAX[2]
 
 #define MAX_I_IDLE_DCCT         ANALOG_VARS_MAX[3]
@@ -81,10 +86,16 @@
 #define V_CAPBANK_MOD_1_FILTERED        g_controller_ctom.net_signals[8].f
 #define V_CAPBANK_MOD_2_FILTERED        g_controller_ctom.net_signals[9].f
 
-#define IN_FF_V_CAPBANK                 g_controller_ctom.net_signals[10].f
+#define IN_FF_V_CAPBANK_MOD_1           g_controller_ctom.net_signals[10].f
 
 #define I_LOAD_DIFF                     g_controller_ctom.net_signals[11].f
 
+#define V_CAPBANK_DIFF                  g_controller_ctom.net_signals[12].f
+#define DUTY_V_CAPBANK_BALANCE          g_controller_ctom.net_signals[13].f
+#define IN_FF_V_CAPBANK_MOD_2           g_controller_ctom.net_signals[14].f
+#define BALANCE_DIRECTION               g_controller_ctom.net_signals[15].f
+#define V_CAPBANK_DIFF_WEIGHTED         g_controller_ctom.net_signals[16].f
+
 #define WFMREF_IDX                      g_controller_ctom.net_signals[31].f
 
 #define DUTY_CYCLE_MOD_1                g_controller_ctom.output_signals[0].f
@@ -117,6 +128,12 @@
 #define IIR_2P2Z_REFERENCE_FEEDFORWARD          &g_controller_ctom.dsp_modules.dsp_iir_2p2z[0]
 #define IIR_2P2Z_REFERENCE_FEEDFORWARD_COEFFS   g_controller_mtoc.dsp_modules.dsp_iir_2p2z[0].coeffs.s
 
+/// Load current DCCTs voting
+#define REDUNDANCY_I_LOAD                   &g_controller_ctom.dsp_modules.dsp_redundancy[0]
+#define REDUNDANCY_I_LOAD_COEFFS            g_controller_mtoc.dsp_modules.dsp_redundancy[0].coeffs.s
+#define DCCTS_FAULT                         g_controller_ctom.dsp_modules.dsp_redundancy[0].fault
+#define DCCTS_EXCLUDED                      g_controller_ctom.dsp_modules.dsp_redundancy[0].excluded
+
 /// Cap-bank voltage feedforward controllers
 #define IIR_2P2Z_LPF_V_CAPBANK_MOD_1            &g_controller_ctom.dsp_modules.dsp_iir_2p2z[1]
 #define IIR_2P2Z_LPF_V_CAPBANK_MOD_1_COEFFS     g_controller_mtoc.dsp_modules.dsp_iir_2p2z[1].coeffs.s
@@ -134,6 +151,16 @@
 #define NOM_V_CAPBANK_FF_MOD_2          FF_V_CAPBANK_MOD_2_COEFFS.vdc_nom
 #define MIN_V_CAPBANK_FF_MOD_2          FF_V_CAPBANK_MOD_2_COEFFS.vdc_min
 
+/// Cap-bank voltages balance controller
+#define PI_CONTROLLER_V_CAPBANK_BALANCE         &g_controller_ctom.dsp_modules.dsp_pi[1]
+#define PI_CONTROLLER_V_CAPBANK_BALANCE_COEFFS  g_controller_mtoc.dsp_modules.dsp_pi[1].coeffs.s
+#define KP_V_CAPBANK_BALANCE                    PI_CONTROLLER_V_CAPBANK_BALANCE_COEFFS.kp
+#define KI_V_CAPBANK_BALANCE                    PI_CONTROLLER_V_CAPBANK_BALANCE_COEFFS.ki
+
+/// Load current band, relative to maximum reference, where balance direction
+/// is smoothly reversed
+#define BALANCE_DIRECTION_BAND_PU               0.01
+
 /// PWM modulators
 #define PWM_MODULATOR_Q1_MOD_1          g_pwm_modules.pwm_regs[0]
 #define PWM_MODULATOR_Q2_MOD_1          g_pwm_modules.pwm_regs[1]
@@ -142,6 +169,22 @@
 
 #define SCOPE                           SCOPE_CTOM[0]
 
+/**
+ * Uncomment to calculate references one sample ahead, on deferred phase of
+ * control ISR, removing reference generators from critical phase.
+ */
+//#define USE_PIPELINED_REFERENCE
+
+/**
+ * Uncomment to use compensated integrator on load current PI controller. See
+ * cfg_dsp_pi_integrator().
+ */
+//#define USE_COMPENSATED_INTEGRATOR
+
+/// Control ISR profile, measured by counter of ePWM module which triggered it
+#define ISR_PROFILE                     g_controller_ctom.isr_profile
+#define ISR_ELAPSED_CYCLES              GET_PWM_ELAPSED_CYCLES(p_pwm_isr)
+
 /**
  * Digital I/O's status
  */
@@ -183,7 +226,9 @@ typedef enum
 
 typedef enum
 {
-    High_Sync_Input_Frequency = 0x00000001
+    High_Sync_Input_Frequency = 0x00000001,
+    DCCT_1_Excluded = 0x00000002,
+    DCCT_2_Excluded = 0x00000004
 } alarms_t;
 
 #define NUM_HARD_INTERLOCKS     Rack_Interlock + 1
@@ -193,13 +238,19 @@ typedef enum
  *  Private variables
  */
 static uint16_t decimation_factor;
-static float decimation_coeff;
+
+static volatile float *p_i_load_dccts[2] = {&I_LOAD_1, &I_LOAD_2};
+static float gain_balance_direction;
+static ps_reference_gen_t reference_gens[NUM_PS_STATES];
 
 /**
  * Private functions
  */
 #pragma CODE_SECTION(isr_init_controller, "ramfuncs");
 #pragma CODE_SECTION(isr_controller, "ramfuncs");
+#pragma CODE_SECTION(run_reference_srlim, "ramfuncs");
+#pragma CODE_SECTION(run_reference_cycle, "ramfuncs");
+#pragma CODE_SECTION(run_reference_wfmref, "ramfuncs");
 #pragma CODE_SECTION(turn_off, "ramfuncs");
 
 static void init_peripherals_drivers(void);
@@ -212,6 +263,10 @@ static void disable_controller();
 static interrupt void isr_init_controller(void);
 static interrupt void isr_controller(void);
 
+static void run_reference_srlim(volatile void *p_srlim);
+static void run_reference_cycle(volatile void *p_siggen);
+static void run_reference_wfmref(volatile void *p_wfmref);
+
 static void init_interruptions(void);
 static void term_interruptions(void);
 
@@ -220,6 +275,7 @@ static void turn_off(uint16_t dummy);
 
 static void reset_interlocks(uint16_t dummy);
 static inline void check_interlocks(void);
+static void set_dcct_fault(uint16_t id, soft_interlocks_t itlk);
 
 static void cfg_pwm_module_h_brigde_q2(volatile struct EPWM_REGS *p_pwm_module);
 
@@ -240,6 +296,7 @@ void main_fac_2s_dcdc(void)
     while(1)
     {
         check_interlocks();
+        run_ipc_deferred_work();
     }
 
     turn_off(0);
@@ -253,17 +310,22 @@ void main_fac_2s_dcdc(void)
 static void init_peripherals_drivers(void)
 {
     uint16_t i;
+    tDMA_Plan dma_plan;
 
     /// Initialization of HRADC boards
     stop_DMA();
 
-    decimation_factor = (uint16_t) roundf(HRADC_FREQ_SAMP / ISR_CONTROL_FREQ);
-    decimation_coeff = 1.0 / (float) decimation_factor;
+    HRADCs_Info.DMA_PlanStatus = Plan_DMA_McBSP_nBuffers(&dma_plan, NUM_HRADC_BOARDS,
+                                                         HRADC_SPI_CLK,
+                                                         HRADC_FREQ_SAMP,
+                                                         ISR_CONTROL_FREQ);
+
+    decimation_factor = dma_plan.size_buffers;
 
     HRADCs_Info.enable_Sampling = 0;
     HRADCs_Info.n_HRADC_boards = NUM_HRADC_BOARDS;
 
-    Init_DMA_McBSP_nBuffers(NUM_HRADC_BOARDS, decimation_factor, HRADC_SPI_CLK);
+    Init_DMA_McBSP_nBuffers(&dma_plan);
 
     Init_SPIMaster_McBSP(HRADC_SPI_CLK);
     Init_SPIMaster_Gpio();
@@ -281,6 +343,14 @@ static void init_peripherals_drivers(void)
                            HRADC_HEATER_ENABLE[i], HRADC_MONITOR_ENABLE[i]);
     }
 
+    i = NUM_DCCTs ? 2 : 1;
+    Config_HRADC_Oversampling(&HRADCs_Info.HRADC_boards[i],
+                              HRADC_OVERSAMPLING_V_CAPBANK);
+    Config_HRADC_Oversampling(&HRADCs_Info.HRADC_boards[i+1],
+                              HRADC_OVERSAMPLING_V_CAPBANK);
+
+    register_hradc_signals(NUM_HRADC_BOARDS);
+
     Config_HRADC_SoC(HRADC_FREQ_SAMP);
 
     /**
@@ -360,8 +430,8 @@ static void init_controller(void)
     init_ipc();
 
     init_wfmref(&WFMREF, WFMREF_SELECTED_PARAM[0], WFMREF_SYNC_MODE_PARAM[0],
-                ISR_CONTROL_FREQ, WFMREF_FREQUENCY_PARAM[0], WFMREF_GAIN_PARAM[0],
-                WFMREF_OFFSET_PARAM[0], &g_wfmref_data.data, SIZE_WFMREF,
+                ISR_CONTROL_FREQ, WFMREF_FREQUENCY_PARAM[0],
+                WFMREF_GAIN_PARAM[0], WFMREF_OFFSET_PARAM[0],
                 &I_LOAD_REFERENCE);
 
     /***********************************************/
@@ -414,6 +484,24 @@ static void init_controller(void)
     init_dsp_srlim(SRLIM_I_LOAD_REFERENCE, MAX_SLEWRATE_SLOWREF, ISR_CONTROL_FREQ,
                    &I_LOAD_SETPOINT, &I_LOAD_REFERENCE);
 
+    /**
+     *        name:     REDUNDANCY_I_LOAD
+     * description:     Load current DCCTs voting and failover
+     *  dsp module:     DSP_Redundancy
+     *          in:     I_LOAD_1, I_LOAD_2
+     *         out:     I_LOAD_MEAN
+     *        diff:     I_LOAD_DIFF
+     */
+
+    init_dsp_redundancy(REDUNDANCY_I_LOAD, NUM_DCCTs ? 2 : 1,
+                        REDUNDANCY_I_LOAD_COEFFS.max_diff,
+                        REDUNDANCY_I_LOAD_COEFFS.max_step,
+                        REDUNDANCY_I_LOAD_COEFFS.stuck_time,
+                        REDUNDANCY_I_LOAD_COEFFS.noise_tolerance,
+                        REDUNDANCY_I_LOAD_COEFFS.max_slewrate_transfer,
+                        ISR_CONTROL_FREQ, p_i_load_dccts, &I_LOAD_MEAN,
+                        &I_LOAD_DIFF);
+
     /**
      *        name:     ERROR_I_LOAD
      * description:     Load current reference error
@@ -436,6 +524,10 @@ static void init_controller(void)
     init_dsp_pi(PI_CONTROLLER_I_LOAD, KP_I_LOAD, KI_I_LOAD, ISR_CONTROL_FREQ,
                 PWM_MAX_DUTY, PWM_MIN_DUTY, &I_LOAD_ERROR, &DUTY_I_LOAD_PI);
 
+    #ifdef USE_COMPENSATED_INTEGRATOR
+    cfg_dsp_pi_integrator(PI_CONTROLLER_I_LOAD, COMPENSATED_INTEGRATOR);
+    #endif
+
     /**
      *        name:     IIR_2P2Z_REFERENCE_FEEDFORWARD
      * description:     Load current reference feedforward IIR 2P2Z controller
@@ -479,13 +571,13 @@ static void init_controller(void)
      * description:     Module 1 capacitor bank voltage feed-forward
      *    DP class:     DSP_VdcLink_FeedForward
      *    vdc_meas:     V_CAPBANK_MOD_1_FILTERED
-     *          in:     IN_FF_V_CAPBANK
+     *          in:     IN_FF_V_CAPBANK_MOD_1
      *         out:     DUTY_CYCLE_MOD_1
      */
 
     init_dsp_vdclink_ff(FF_V_CAPBANK_MOD_1, NOM_V_CAPBANK_FF_MOD_1,
                         MIN_V_CAPBANK_FF_MOD_1, &V_CAPBANK_MOD_1_FILTERED,
-                        &IN_FF_V_CAPBANK, &DUTY_CYCLE_MOD_1);
+                        &IN_FF_V_CAPBANK_MOD_1, &DUTY_CYCLE_MOD_1);
 
     /**
      *        name:     IIR_2P2Z_LPF_V_CAPBANK_MOD_2
@@ -509,13 +601,84 @@ static void init_controller(void)
      * description:     Module 2 capacitor bank voltage feed-forward
      *    DP class:     DSP_VdcLink_FeedForward
      *    vdc_meas:     V_CAPBANK_MOD_2_FILTERED
-     *          in:     IN_FF_V_CAPBANK
+     *          in:     IN_FF_V_CAPBANK_MOD_2
      *         out:     DUTY_CYCLE_MOD_2
      */
 
     init_dsp_vdclink_ff(FF_V_CAPBANK_MOD_2, NOM_V_CAPBANK_FF_MOD_2,
                         MIN_V_CAPBANK_FF_MOD_2, &V_CAPBANK_MOD_2_FILTERED,
-                        &IN_FF_V_CAPBANK, &DUTY_CYCLE_MOD_2);
+                        &IN_FF_V_CAPBANK_MOD_2, &DUTY_CYCLE_MOD_2);
+
+    /**
+     *        name:     PI_CONTROLLER_V_CAPBANK_BALANCE
+     * description:     Capacitor banks voltage balance PI controller
+     *  dsp module:     DSP_PI
+     *          in:     V_CAPBANK_DIFF_WEIGHTED
+     *         out:     DUTY_V_CAPBANK_BALANCE
+     */
+
+    init_dsp_pi(PI_CONTROLLER_V_CAPBANK_BALANCE, KP_V_CAPBANK_BALANCE,
+                KI_V_CAPBANK_BALANCE, ISR_CONTROL_FREQ, PWM_LIM_DUTY_SHARE,
+                -PWM_LIM_DUTY_SHARE, &V_CAPBANK_DIFF_WEIGHTED,
+                &DUTY_V_CAPBANK_BALANCE);
+
+    if(MAX_REF[0] > 0.0)
+    {
+        gain_balance_direction = 1.0 / (BALANCE_DIRECTION_BAND_PU * MAX_REF[0]);
+    }
+    else
+    {
+        gain_balance_direction = 0.0;
+    }
+
+    /********************************************/
+    /** INITIALIZATION OF REFERENCE GENERATORS **/
+    /********************************************/
+
+    init_ps_reference(&g_ipc_ctom.ps_module[0], reference_gens);
+
+    cfg_ps_reference(&g_ipc_ctom.ps_module[0], SlowRef,
+                     &run_reference_srlim, SRLIM_I_LOAD_REFERENCE);
+    cfg_ps_reference(&g_ipc_ctom.ps_module[0], SlowRefSync,
+                     &run_reference_srlim, SRLIM_I_LOAD_REFERENCE);
+    cfg_ps_reference(&g_ipc_ctom.ps_module[0], Cycle,
+                     &run_reference_cycle, &SIGGEN);
+    cfg_ps_reference(&g_ipc_ctom.ps_module[0], RmpWfm,
+                     &run_reference_wfmref, &WFMREF);
+    cfg_ps_reference(&g_ipc_ctom.ps_module[0], MigWfm,
+                     &run_reference_wfmref, &WFMREF);
+
+    /****************************************/
+    /** INITIALIZATION OF SIGNALS REGISTRY **/
+    /****************************************/
+
+    init_signals();
+
+    REGISTER_SIGNAL(I_LOAD_SETPOINT, is_float, Unit_Ampere);
+    REGISTER_SIGNAL(I_LOAD_REFERENCE, is_float, Unit_Ampere);
+    REGISTER_SIGNAL(I_LOAD_1, is_float, Unit_Ampere);
+    REGISTER_SIGNAL(I_LOAD_2, is_float, Unit_Ampere);
+    REGISTER_SIGNAL(V_CAPBANK_MOD_1, is_float, Unit_Volt);
+    REGISTER_SIGNAL(V_CAPBANK_MOD_2, is_float, Unit_Volt);
+    REGISTER_SIGNAL(I_LOAD_MEAN, is_float, Unit_Ampere);
+    REGISTER_SIGNAL(I_LOAD_ERROR, is_float, Unit_Ampere);
+    REGISTER_SIGNAL(DUTY_I_LOAD_PI, is_float, Unit_Duty);
+    REGISTER_SIGNAL(DUTY_REF_FF, is_float, Unit_Duty);
+    REGISTER_SIGNAL(V_CAPBANK_MOD_1_FILTERED, is_float, Unit_Volt);
+    REGISTER_SIGNAL(V_CAPBANK_MOD_2_FILTERED, is_float, Unit_Volt);
+    REGISTER_SIGNAL(IN_FF_V_CAPBANK_MOD_1, is_float, Unit_Duty);
+    REGISTER_SIGNAL(I_LOAD_DIFF, is_float, Unit_Ampere);
+    REGISTER_SIGNAL(V_CAPBANK_DIFF, is_float, Unit_Volt);
+    REGISTER_SIGNAL(DUTY_V_CAPBANK_BALANCE, is_float, Unit_Duty);
+    REGISTER_SIGNAL(IN_FF_V_CAPBANK_MOD_2, is_float, Unit_Duty);
+    REGISTER_SIGNAL(BALANCE_DIRECTION, is_float, Unit_None);
+    REGISTER_SIGNAL(V_CAPBANK_DIFF_WEIGHTED, is_float, Unit_Volt);
+    REGISTER_SIGNAL(WFMREF_IDX, is_float, Unit_None);
+    REGISTER_SIGNAL(DUTY_CYCLE_MOD_1, is_float, Unit_Duty);
+    REGISTER_SIGNAL(DUTY_CYCLE_MOD_2, is_float, Unit_Duty);
+
+    REGISTER_DSP_PI_INTEGRATOR(PI_CONTROLLER_I_LOAD, Unit_Duty);
+    REGISTER_DSP_PI_INTEGRATOR(PI_CONTROLLER_V_CAPBANK_BALANCE, Unit_Duty);
 
     /******************************/
     /** INITIALIZATION OF SCOPES **/
@@ -550,12 +713,17 @@ static void reset_controller(void)
 
     reset_dsp_iir_2p2z(IIR_2P2Z_REFERENCE_FEEDFORWARD);
 
-    reset_dsp_iir_2p2z(IIR_2P2Z_LPF_V_CAPBANK_MOD_1);
-    reset_dsp_iir_2p2z(IIR_2P2Z_LPF_V_CAPBANK_MOD_2);
+    /// V_CAPBANK LPF's are kept running, so interlocks don't see a false
+    /// undervoltage right after turn off
 
     reset_dsp_vdclink_ff(FF_V_CAPBANK_MOD_1);
     reset_dsp_vdclink_ff(FF_V_CAPBANK_MOD_2);
 
+    V_CAPBANK_DIFF = 0.0;
+    V_CAPBANK_DIFF_WEIGHTED = 0.0;
+    reset_dsp_pi(PI_CONTROLLER_V_CAPBANK_BALANCE);
+    BALANCE_DIRECTION = 0.0;
+
     reset_dsp_srlim(SRLIM_SIGGEN_AMP);
     reset_dsp_srlim(SRLIM_SIGGEN_OFFSET);
     disable_siggen(&SIGGEN);
@@ -563,6 +731,38 @@ static void reset_controller(void)
     reset_wfmref(&WFMREF);
 }
 
+/**
+ * Reference generator for SlowRef and SlowRefSync operation modes.
+ *
+ * @param p_srlim pointer to reference slew-rate limiter
+ */
+static void run_reference_srlim(volatile void *p_srlim)
+{
+    run_dsp_srlim((dsp_srlim_t *) p_srlim, USE_MODULE);
+}
+
+/**
+ * Reference generator for Cycle operation mode.
+ *
+ * @param p_siggen pointer to signal generator
+ */
+static void run_reference_cycle(volatile void *p_siggen)
+{
+    run_dsp_srlim(SRLIM_SIGGEN_AMP, USE_MODULE);
+    run_dsp_srlim(SRLIM_SIGGEN_OFFSET, USE_MODULE);
+    ((siggen_t *) p_siggen)->p_run_siggen((siggen_t *) p_siggen);
+}
+
+/**
+ * Reference generator for RmpWfm and MigWfm operation modes.
+ *
+ * @param p_wfmref pointer to waveform reference
+ */
+static void run_reference_wfmref(volatile void *p_wfmref)
+{
+    run_wfmref((wfmref_t *) p_wfmref);
+}
+
 /**
  * Initialization of interruptions.
  */
@@ -662,44 +862,16 @@ static interrupt void isr_init_controller(void)
 static interrupt void isr_controller(void)
 {
     static float temp[4];
-    static uint16_t i;
+    volatile struct EPWM_REGS *p_pwm_isr;
+
+    p_pwm_isr = GET_PWM_ISR_MODULE;
 
     //CLEAR_DEBUG_GPIO1;
     //SET_DEBUG_GPIO0;
     SET_DEBUG_GPIO1;
 
-    temp[0] = 0.0;
-    temp[1] = 0.0;
-    temp[2] = 0.0;
-    temp[3] = 0.0;
-
     /// Get HRADC samples
-    for(i = 0; i < decimation_factor; i++)
-    {
-        temp[0] += (float) *(HRADCs_Info.HRADC_boards[0].SamplesBuffer++);
-        temp[1] += (float) *(HRADCs_Info.HRADC_boards[1].SamplesBuffer++);
-        temp[2] += (float) *(HRADCs_Info.HRADC_boards[2].SamplesBuffer++);
-        temp[3] += (float) *(HRADCs_Info.HRADC_boards[3].SamplesBuffer++);
-    }
-
-    //CLEAR_DEBUG_GPIO1;
-
-    HRADCs_Info.HRADC_boards[0].SamplesBuffer = buffers_HRADC[0];
-    HRADCs_Info.HRADC_boards[1].SamplesBuffer = buffers_HRADC[1];
-    HRADCs_Info.HRADC_boards[2].SamplesBuffer = buffers_HRADC[2];
-    HRADCs_Info.HRADC_boards[3].SamplesBuffer = buffers_HRADC[3];
-
-    temp[0] *= HRADCs_Info.HRADC_boards[0].gain * decimation_coeff;
-    temp[0] += HRADCs_Info.HRADC_boards[0].offset;
-
-    temp[1] *= HRADCs_Info.HRADC_boards[1].gain * decimation_coeff;
-    temp[1] += HRADCs_Info.HRADC_boards[1].offset;
-
-    temp[2] *= HRADCs_Info.HRADC_boards[2].gain * decimation_coeff;
-    temp[2] += HRADCs_Info.HRADC_boards[2].offset;
-
-    temp[3] *= HRADCs_Info.HRADC_boards[3].gain * decimation_coeff;
-    temp[3] += HRADCs_Info.HRADC_boards[3].offset;
+    Read_HRADC_Samples(temp);
 
     if(NUM_DCCTs)
     {
@@ -708,8 +880,10 @@ static interrupt void isr_controller(void)
         V_CAPBANK_MOD_1 = temp[2];
         V_CAPBANK_MOD_2 = temp[3];
 
-        I_LOAD_MEAN = 0.5*(I_LOAD_1 + I_LOAD_2);
-        I_LOAD_DIFF = I_LOAD_1 - I_LOAD_2;
+        if(!PIN_STATUS_DCCT_2_STATUS)
+        {
+            set_dsp_redundancy_fault(REDUNDANCY_I_LOAD, 1);
+        }
     }
     else
     {
@@ -717,11 +891,15 @@ static interrupt void isr_controller(void)
         V_CAPBANK_MOD_1 = temp[1];
         V_CAPBANK_MOD_2 = temp[2];
         g_controller_ctom.net_signals[20].f = temp[3];
+    }
 
-        I_LOAD_MEAN = I_LOAD_1;
-        I_LOAD_DIFF = 0;
+    if(!PIN_STATUS_DCCT_1_STATUS)
+    {
+        set_dsp_redundancy_fault(REDUNDANCY_I_LOAD, 0);
     }
 
+    run_dsp_redundancy(REDUNDANCY_I_LOAD);
+
     run_dsp_iir_2p2z(IIR_2P2Z_LPF_V_CAPBANK_MOD_1);
     run_dsp_iir_2p2z(IIR_2P2Z_LPF_V_CAPBANK_MOD_2);
 
@@ -729,32 +907,11 @@ static interrupt void isr_controller(void)
     if(g_ipc_ctom.ps_module[0].ps_status.bit.state > Interlock)
     {
         /// Calculate reference according to operation mode
-        switch(g_ipc_ctom.ps_module[0].ps_status.bit.state)
-        {
-            case SlowRef:
-            case SlowRefSync:
-            {
-                run_dsp_srlim(SRLIM_I_LOAD_REFERENCE, USE_MODULE);
-                break;
-            }
-            case Cycle:
-            {
-                run_dsp_srlim(SRLIM_SIGGEN_AMP, USE_MODULE);
-                run_dsp_srlim(SRLIM_SIGGEN_OFFSET, USE_MODULE);
-                SIGGEN.p_run_siggen(&SIGGEN);
-                break;
-            }
-            case RmpWfm:
-            case MigWfm:
-            {
-                run_wfmref(&WFMREF);
-                break;
-            }
-            default:
-            {
-                break;
-            }
-        }
+        #ifdef USE_PIPELINED_REFERENCE
+        LATCH_PS_REFERENCE(&g_ipc_ctom.ps_module[0]);
+        #else
+        RUN_PS_REFERENCE(&g_ipc_ctom.ps_module[0]);
+        #endif
 
         /// Open-loop
         if(g_ipc_ctom.ps_module[0].ps_status.bit.openloop)
@@ -775,7 +932,30 @@ static interrupt void isr_controller(void)
             run_dsp_pi(PI_CONTROLLER_I_LOAD);
             run_dsp_iir_2p2z(IIR_2P2Z_REFERENCE_FEEDFORWARD);
 
-            IN_FF_V_CAPBANK = DUTY_I_LOAD_PI + DUTY_REF_FF;
+            /**
+             * Cap-bank voltages balance controller. Module with higher
+             * cap-bank voltage must deliver more (or absorb less) power. Power
+             * drawn from each cap-bank is duty cycle times measured load
+             * current, so a duty cycle offset moves power between modules in
+             * the direction of measured load current, both when delivering
+             * and regenerating. Direction is reversed linearly within a small
+             * current band, avoiding duty cycle steps at zero crossings.
+             *
+             * Within this band, balance has little or no effect, so error is
+             * weighted by direction magnitude, which holds the integrator
+             * instead of winding it up while load current is near zero.
+             */
+            BALANCE_DIRECTION = gain_balance_direction * I_LOAD_MEAN;
+            SATURATE(BALANCE_DIRECTION, 1.0, -1.0);
+
+            V_CAPBANK_DIFF = V_CAPBANK_MOD_1_FILTERED - V_CAPBANK_MOD_2_FILTERED;
+            V_CAPBANK_DIFF_WEIGHTED = fabs(BALANCE_DIRECTION) * V_CAPBANK_DIFF;
+            run_dsp_pi(PI_CONTROLLER_V_CAPBANK_BALANCE);
+
+            IN_FF_V_CAPBANK_MOD_1 = DUTY_I_LOAD_PI + DUTY_REF_FF +
+                                    BALANCE_DIRECTION * DUTY_V_CAPBANK_BALANCE;
+            IN_FF_V_CAPBANK_MOD_2 = DUTY_I_LOAD_PI + DUTY_REF_FF -
+                                    BALANCE_DIRECTION * DUTY_V_CAPBANK_BALANCE;
 
             /// Cap-bank voltage feedforward controllers
             run_dsp_vdclink_ff(FF_V_CAPBANK_MOD_1);
@@ -789,8 +969,19 @@ static interrupt void isr_controller(void)
         set_pwm_duty_hbridge(PWM_MODULATOR_Q1_MOD_2, DUTY_CYCLE_MOD_2);
     }
 
-    WFMREF_IDX = (float) (WFMREF.wfmref_data[WFMREF.wfmref_selected].p_buf_idx -
-                          WFMREF.wfmref_data[WFMREF.wfmref_selected].p_buf_start);
+    /*********************************************/
+    END_ISR_CRITICAL_PHASE(ISR_PROFILE, ISR_ELAPSED_CYCLES)
+    /*********************************************/
+
+    HRADCs_Info.HRADC_boards[0].SamplesBuffer = buffers_HRADC[0];
+    HRADCs_Info.HRADC_boards[1].SamplesBuffer = buffers_HRADC[1];
+    HRADCs_Info.HRADC_boards[2].SamplesBuffer = buffers_HRADC[2];
+    HRADCs_Info.HRADC_boards[3].SamplesBuffer = buffers_HRADC[3];
+
+    WFMREF_IDX = (float) (WFMREF.wfmref_data.p_buf_idx -
+                          WFMREF.wfmref_data.p_buf_start);
+
+    RUN_IPC_LATENCY;
 
     RUN_SCOPE(SCOPE);
 
@@ -826,6 +1017,18 @@ static interrupt void isr_controller(void)
     /// Re-enable XINT2 (external interrupt 2) interrupt used for sync pulses
     PieCtrlRegs.PIEIER1.bit.INTx5 = 1;
 
+    #ifdef USE_PIPELINED_REFERENCE
+    /// Calculate reference for next ISR
+    if(g_ipc_ctom.ps_module[0].ps_status.bit.state > Interlock)
+    {
+        run_ps_reference_ahead(&g_ipc_ctom.ps_module[0]);
+    }
+    #endif
+
+    /*********************************************/
+    END_ISR_DEFERRED_PHASE(ISR_PROFILE, ISR_ELAPSED_CYCLES)
+    /*********************************************/
+
     /// Clear interrupt flags for PWM interrupts
     PWM_MODULATOR_Q1_MOD_1->ETCLR.bit.INT = 1;
     PWM_MODULATOR_Q2_MOD_1->ETCLR.bit.INT = 1;
@@ -841,6 +1044,11 @@ static interrupt void isr_controller(void)
  */
 static void enable_controller()
 {
+    if(!DMA_PLAN_IS_VALID(HRADCs_Info.DMA_PlanStatus))
+    {
+        return;
+    }
+
     stop_DMA();
     DELAY_US(5);
     start_DMA();
@@ -867,14 +1075,14 @@ static void disable_controller()
  */
 static void turn_on(uint16_t dummy)
 {
-    if(V_CAPBANK_MOD_1 < MIN_V_CAPBANK)
+    if(V_CAPBANK_MOD_1_FILTERED < MIN_V_CAPBANK)
     {
         PIN_SET_UDC_INTERLOCK;
         BYPASS_HARD_INTERLOCK_DEBOUNCE(0, Module_1_CapBank_Undervoltage);
         set_hard_interlock(0, Module_1_CapBank_Undervoltage);
     }
 
-    if(V_CAPBANK_MOD_2 < MIN_V_CAPBANK)
+    if(V_CAPBANK_MOD_2_FILTERED < MIN_V_CAPBANK)
     {
         PIN_SET_UDC_INTERLOCK;
         BYPASS_HARD_INTERLOCK_DEBOUNCE(0, Module_2_CapBank_Undervoltage);
@@ -888,7 +1096,7 @@ static void turn_on(uint16_t dummy)
     #endif
     {
 
-        g_ipc_ctom.ps_module[0].ps_status.bit.state = SlowRef;
+        cfg_ps_operation_mode(&g_ipc_ctom.ps_module[0], SlowRef);
         enable_pwm_output(0);
         enable_pwm_output(1);
         enable_pwm_output(2);
@@ -927,6 +1135,8 @@ static void reset_interlocks(uint16_t dummy)
     g_ipc_ctom.ps_module[0].ps_soft_interlock = 0;
     g_ipc_ctom.ps_module[0].ps_alarms = 0;
 
+    reset_dsp_redundancy(REDUNDANCY_I_LOAD);
+
     if(g_ipc_ctom.ps_module[0].ps_status.bit.state < Initializing)
     {
         g_ipc_ctom.ps_module[0].ps_status.bit.state = Off;
@@ -960,28 +1170,18 @@ static inline void check_interlocks(void)
         set_hard_interlock(0, Rack_Interlock);
     }
 
-    if(!PIN_STATUS_DCCT_1_STATUS)
-    {
-        set_soft_interlock(0, DCCT_1_Fault);
-    }
-
-    if( NUM_DCCTs && !PIN_STATUS_DCCT_2_STATUS )
-    {
-        set_soft_interlock(0, DCCT_2_Fault);
-    }
-
     if(PIN_STATUS_DCCT_1_ACTIVE)
     {
         if(fabs(I_LOAD_1) < MIN_I_ACTIVE_DCCT)
         {
-            set_soft_interlock(0, Load_Feedback_1_Fault);
+            set_dcct_fault(0, Load_Feedback_1_Fault);
         }
     }
     else
     {
         if(fabs(I_LOAD_1) > MAX_I_IDLE_DCCT)
         {
-            set_soft_interlock(0, Load_Feedback_1_Fault);
+            set_dcct_fault(0, Load_Feedback_1_Fault);
         }
     }
 
@@ -991,24 +1191,46 @@ static inline void check_interlocks(void)
         {
             if(fabs(I_LOAD_2) < MIN_I_ACTIVE_DCCT)
             {
-                set_soft_interlock(0, Load_Feedback_2_Fault);
+                set_dcct_fault(1, Load_Feedback_2_Fault);
             }
         }
         else
         {
             if(fabs(I_LOAD_2) > MAX_I_IDLE_DCCT)
             {
-                set_soft_interlock(0, Load_Feedback_2_Fault);
+                set_dcct_fault(1, Load_Feedback_2_Fault);
             }
         }
     }
 
-    if(V_CAPBANK_MOD_1 > MAX_V_CAPBANK)
+    /**
+     * DCCT faults are detected on control ISR. Excluded DCCTs are logged as
+     * alarms, while faults that couldn't be isolated trip the power supply.
+     */
+    if(DCCTS_EXCLUDED & 0x0001)
+    {
+        g_ipc_ctom.ps_module[0].ps_alarms |= DCCT_1_Excluded;
+    }
+    else if(DCCTS_FAULT & 0x0001)
+    {
+        set_soft_interlock(0, DCCT_1_Fault);
+    }
+
+    if(DCCTS_EXCLUDED & 0x0002)
+    {
+        g_ipc_ctom.ps_module[0].ps_alarms |= DCCT_2_Excluded;
+    }
+    else if(DCCTS_FAULT & 0x0002)
+    {
+        set_soft_interlock(0, DCCT_2_Fault);
+    }
+
+    if(V_CAPBANK_MOD_1_FILTERED > MAX_V_CAPBANK)
     {
         set_hard_interlock(0, Module_1_CapBank_Overvoltage);
     }
 
-    if(V_CAPBANK_MOD_2 > MAX_V_CAPBANK)
+    if(V_CAPBANK_MOD_2_FILTERED > MAX_V_CAPBANK)
     {
         set_hard_interlock(0, Module_2_CapBank_Overvoltage);
     }
@@ -1017,12 +1239,12 @@ static inline void check_interlocks(void)
 
     if(g_ipc_ctom.ps_module[0].ps_status.bit.state > Interlock)
     {
-        if(V_CAPBANK_MOD_1 < MIN_V_CAPBANK)
+        if(V_CAPBANK_MOD_1_FILTERED < MIN_V_CAPBANK)
         {
             set_hard_interlock(0, Module_1_CapBank_Undervoltage);
         }
 
-        if(V_CAPBANK_MOD_2 < MIN_V_CAPBANK)
+        if(V_CAPBANK_MOD_2_FILTERED < MIN_V_CAPBANK)
         {
             set_hard_interlock(0, Module_2_CapBank_Undervoltage);
         }
@@ -1040,6 +1262,25 @@ static inline void check_interlocks(void)
     }
 }
 
+/**
+ * Report fault on specified DCCT, detected on background loop. If it can't be
+ * excluded from load current measurement, set specified soft interlock.
+ *
+ * @param id DCCT index
+ * @param itlk soft interlock related to this fault
+ */
+static void set_dcct_fault(uint16_t id, soft_interlocks_t itlk)
+{
+    DINT;
+    set_dsp_redundancy_fault(REDUNDANCY_I_LOAD, id);
+    EINT;
+
+    if(!(DCCTS_EXCLUDED & (1 << id)))
+    {
+        set_soft_interlock(0, itlk);
+    }
+}
+
 /**
  * Configure specified PWM module to generate inverted PWM pulses (active on
  * LOW). This is used to generate 8x Q2 signals for the 8 DC/DC modules.
@@ -31,6 +31,7 @@
 #include "ipc/ipc.h"
 #include "parameters/parameters.h"
 #include "pwm/pwm.h"
+#include "signals/signals.h"
 
 #include "fac_dcdc_ema.h"
 
@@ -114,6 +115,16 @@
 /// Scope
 #define SCOPE                           SCOPE_CTOM[0]
 
+/**
+ * Uncomment to calculate references one sample ahead, on deferred phase of
+ * control ISR, removing reference generators from critical phase.
+ */
+//#define USE_PIPELINED_REFERENCE
+
+/// Control ISR profile, measured by counter of ePWM module which triggered it
+#define ISR_PROFILE                     g_controller_ctom.isr_profile
+#define ISR_ELAPSED_CYCLES              GET_PWM_ELAPSED_CYCLES(p_pwm_isr)
+
 /**
  * Digital I/O's status
  */
@@ -176,13 +187,16 @@ typedef enum
  *  Private variables
  */
 static uint16_t decimation_factor;
-static float decimation_coeff;
+static ps_reference_gen_t reference_gens[NUM_PS_STATES];
 
 /**
  * Private functions
  */
 #pragma CODE_SECTION(isr_init_controller, "ramfuncs");
 #pragma CODE_SECTION(isr_controller, "ramfuncs");
+#pragma CODE_SECTION(run_reference_srlim, "ramfuncs");
+#pragma CODE_SECTION(run_reference_cycle, "ramfuncs");
+#pragma CODE_SECTION(run_reference_wfmref, "ramfuncs");
 #pragma CODE_SECTION(turn_off, "ramfuncs");
 
 static void init_peripherals_drivers(void);
@@ -195,6 +209,10 @@ static void disable_controller();
 static interrupt void isr_init_controller(void);
 static interrupt void isr_controller(void);
 
+static void run_reference_srlim(volatile void *p_srlim);
+static void run_reference_cycle(volatile void *p_siggen);
+static void run_reference_wfmref(volatile void *p_wfmref);
+
 static void init_interruptions(void);
 static void term_interruptions(void);
 
@@ -224,6 +242,7 @@ void main_fac_dcdc_ema(void)
     while(1)
     {
         check_interlocks();
+        run_ipc_deferred_work();
     }
 
     turn_off(0);
@@ -237,18 +256,23 @@ void main_fac_dcdc_ema(void)
 static void init_peripherals_drivers(void)
 {
     uint16_t i;
+    tDMA_Plan dma_plan;
 
     /// Initialization of HRADC boards
     stop_DMA();
 
-    decimation_factor = (uint16_t) roundf(HRADC_FREQ_SAMP / ISR_CONTROL_FREQ);
-    decimation_coeff = 1.0 / (float) decimation_factor;
+    HRADCs_Info.DMA_PlanStatus = Plan_DMA_McBSP_nBuffers(&dma_plan, NUM_HRADC_BOARDS,
+                                                         HRADC_SPI_CLK,
+                                                         HRADC_FREQ_SAMP,
+                                                         ISR_CONTROL_FREQ);
+
+    decimation_factor = dma_plan.size_buffers;
 
 
     HRADCs_Info.enable_Sampling = 0;
     HRADCs_Info.n_HRADC_boards = NUM_HRADC_BOARDS;
 
-    Init_DMA_McBSP_nBuffers(NUM_HRADC_BOARDS, decimation_factor, HRADC_SPI_CLK);
+    Init_DMA_McBSP_nBuffers(&dma_plan);
 
     Init_SPIMaster_McBSP(HRADC_SPI_CLK);
     Init_SPIMaster_Gpio();
@@ -266,6 +290,8 @@ static void init_peripherals_drivers(void)
                            HRADC_HEATER_ENABLE[i], HRADC_MONITOR_ENABLE[i]);
     }
 
+    register_hradc_signals(NUM_HRADC_BOARDS);
+
     Config_HRADC_SoC(HRADC_FREQ_SAMP);
 
     /// Initialization of PWM modules
@@ -324,8 +350,8 @@ static void init_controller(void)
     init_ipc();
 
     init_wfmref(&WFMREF, WFMREF_SELECTED_PARAM[0], WFMREF_SYNC_MODE_PARAM[0],
-                ISR_CONTROL_FREQ, WFMREF_FREQUENCY_PARAM[0], WFMREF_GAIN_PARAM[0],
-                WFMREF_OFFSET_PARAM[0], &g_wfmref_data.data, SIZE_WFMREF,
+                ISR_CONTROL_FREQ, WFMREF_FREQUENCY_PARAM[0],
+                WFMREF_GAIN_PARAM[0], WFMREF_OFFSET_PARAM[0],
                 &I_LOAD_REFERENCE);
 
     /***********************************************/
@@ -449,6 +475,42 @@ static void init_controller(void)
     init_dsp_vdclink_ff(FF_V_DCLINK, NOM_V_DCLINK_FF, MIN_V_DCLINK_FF,
                         &V_DCLINK_FILTERED, &DUTY_NOMINAL, &DUTY_CYCLE);
 
+    /********************************************/
+    /** INITIALIZATION OF REFERENCE GENERATORS **/
+    /********************************************/
+
+    init_ps_reference(&g_ipc_ctom.ps_module[0], reference_gens);
+
+    cfg_ps_reference(&g_ipc_ctom.ps_module[0], SlowRef,
+                     &run_reference_srlim, SRLIM_I_LOAD_REFERENCE);
+    cfg_ps_reference(&g_ipc_ctom.ps_module[0], SlowRefSync,
+                     &run_reference_srlim, SRLIM_I_LOAD_REFERENCE);
+    cfg_ps_reference(&g_ipc_ctom.ps_module[0], Cycle,
+                     &run_reference_cycle, &SIGGEN);
+    cfg_ps_reference(&g_ipc_ctom.ps_module[0], RmpWfm,
+                     &run_reference_wfmref, &WFMREF);
+    cfg_ps_reference(&g_ipc_ctom.ps_module[0], MigWfm,
+                     &run_reference_wfmref, &WFMREF);
+
+    /****************************************/
+    /** INITIALIZATION OF SIGNALS REGISTRY **/
+    /****************************************/
+
+    init_signals();
+
+    REGISTER_SIGNAL(I_LOAD_SETPOINT, is_float, Unit_Ampere);
+    REGISTER_SIGNAL(I_LOAD_REFERENCE, is_float, Unit_Ampere);
+    REGISTER_SIGNAL(I_LOAD, is_float, Unit_Ampere);
+    REGISTER_SIGNAL(V_DCLINK, is_float, Unit_Volt);
+    REGISTER_SIGNAL(I_LOAD_ERROR, is_float, Unit_Ampere);
+    REGISTER_SIGNAL(DUTY_I_LOAD_PI, is_float, Unit_Duty);
+    REGISTER_SIGNAL(DUTY_REF_FF, is_float, Unit_Duty);
+    REGISTER_SIGNAL(DUTY_NOMINAL, is_float, Unit_Duty);
+    REGISTER_SIGNAL(V_DCLINK_FILTERED, is_float, Unit_Volt);
+    REGISTER_SIGNAL(DUTY_CYCLE, is_float, Unit_Duty);
+
+    REGISTER_DSP_PI_INTEGRATOR(PI_CONTROLLER_I_LOAD, Unit_Duty);
+
     /******************************/
     /** INITIALIZATION OF SCOPES **/
     /******************************/
@@ -497,6 +559,11 @@ static void reset_controller(void)
  */
 static void enable_controller()
 {
+    if(!DMA_PLAN_IS_VALID(HRADCs_Info.DMA_PlanStatus))
+    {
+        return;
+    }
+
     stop_DMA();
     DELAY_US(5);
     start_DMA();
@@ -552,44 +619,16 @@ static interrupt void isr_init_controller(void)
 static interrupt void isr_controller(void)
 {
     static float temp[4];
-    static uint16_t i;
+    volatile struct EPWM_REGS *p_pwm_isr;
+
+    p_pwm_isr = GET_PWM_ISR_MODULE;
 
     //CLEAR_DEBUG_GPIO1;
     //SET_DEBUG_GPIO0;
     SET_DEBUG_GPIO1;
 
-    temp[0] = 0.0;
-    temp[1] = 0.0;
-    temp[2] = 0.0;
-    temp[3] = 0.0;
-
     /// Get HRADC samples
-    for(i = 0; i < decimation_factor; i++)
-    {
-        temp[0] += (float) *(HRADCs_Info.HRADC_boards[0].SamplesBuffer++);
-        temp[1] += (float) *(HRADCs_Info.HRADC_boards[1].SamplesBuffer++);
-        temp[2] += (float) *(HRADCs_Info.HRADC_boards[2].SamplesBuffer++);
-        temp[3] += (float) *(HRADCs_Info.HRADC_boards[3].SamplesBuffer++);
-    }
-
-    //CLEAR_DEBUG_GPIO1;
-
-    HRADCs_Info.HRADC_boards[0].SamplesBuffer = buffers_HRADC[0];
-    HRADCs_Info.HRADC_boards[1].SamplesBuffer = buffers_HRADC[1];
-    HRADCs_Info.HRADC_boards[2].SamplesBuffer = buffers_HRADC[2];
-    HRADCs_Info.HRADC_boards[3].SamplesBuffer = buffers_HRADC[3];
-
-    temp[0] *= HRADCs_Info.HRADC_boards[0].gain * decimation_coeff;
-    temp[0] += HRADCs_Info.HRADC_boards[0].offset;
-
-    temp[1] *= HRADCs_Info.HRADC_boards[1].gain * decimation_coeff;
-    temp[1] += HRADCs_Info.HRADC_boards[1].offset;
-
-    temp[2] *= HRADCs_Info.HRADC_boards[2].gain * decimation_coeff;
-    temp[2] += HRADCs_Info.HRADC_boards[2].offset;
-
-    temp[3] *= HRADCs_Info.HRADC_boards[3].gain * decimation_coeff;
-    temp[3] += HRADCs_Info.HRADC_boards[3].offset;
+    Read_HRADC_Samples(temp);
 
     I_LOAD = temp[0];
     V_DCLINK = temp[1];
@@ -600,32 +639,11 @@ static interrupt void isr_controller(void)
     if(g_ipc_ctom.ps_module[0].ps_status.bit.state > Interlock)
     {
         /// Calculate reference according to operation mode
-        switch(g_ipc_ctom.ps_module[0].ps_status.bit.state)
-        {
-            case SlowRef:
-            case SlowRefSync:
-            {
-                run_dsp_srlim(SRLIM_I_LOAD_REFERENCE, USE_MODULE);
-                break;
-            }
-            case Cycle:
-            {
-                run_dsp_srlim(SRLIM_SIGGEN_AMP, USE_MODULE);
-                run_dsp_srlim(SRLIM_SIGGEN_OFFSET, USE_MODULE);
-                SIGGEN.p_run_siggen(&SIGGEN);
-                break;
-            }
-            case RmpWfm:
-            case MigWfm:
-            {
-                run_wfmref(&WFMREF);
-                break;
-            }
-            default:
-            {
-                break;
-            }
-        }
+        #ifdef USE_PIPELINED_REFERENCE
+        LATCH_PS_REFERENCE(&g_ipc_ctom.ps_module[0]);
+        #else
+        RUN_PS_REFERENCE(&g_ipc_ctom.ps_module[0]);
+        #endif
 
         /// Open-loop
         if(g_ipc_ctom.ps_module[0].ps_status.bit.openloop)
@@ -652,6 +670,17 @@ static interrupt void isr_controller(void)
         set_pwm_duty_hbridge(PWM_MODULATOR_Q1, DUTY_CYCLE);
     }
 
+    /*********************************************/
+    END_ISR_CRITICAL_PHASE(ISR_PROFILE, ISR_ELAPSED_CYCLES)
+    /*********************************************/
+
+    HRADCs_Info.HRADC_boards[0].SamplesBuffer = buffers_HRADC[0];
+    HRADCs_Info.HRADC_boards[1].SamplesBuffer = buffers_HRADC[1];
+    HRADCs_Info.HRADC_boards[2].SamplesBuffer = buffers_HRADC[2];
+    HRADCs_Info.HRADC_boards[3].SamplesBuffer = buffers_HRADC[3];
+
+    RUN_IPC_LATENCY;
+
     RUN_SCOPE(SCOPE);
 
     SET_INTERLOCKS_TIMEBASE_FLAG(0);
@@ -686,6 +715,18 @@ static interrupt void isr_controller(void)
     /// Re-enable XINT2 (external interrupt 2) interrupt used for sync pulses
     PieCtrlRegs.PIEIER1.bit.INTx5 = 1;
 
+    #ifdef USE_PIPELINED_REFERENCE
+    /// Calculate reference for next ISR
+    if(g_ipc_ctom.ps_module[0].ps_status.bit.state > Interlock)
+    {
+        run_ps_reference_ahead(&g_ipc_ctom.ps_module[0]);
+    }
+    #endif
+
+    /*********************************************/
+    END_ISR_DEFERRED_PHASE(ISR_PROFILE, ISR_ELAPSED_CYCLES)
+    /*********************************************/
+
     /// Clear interrupt flags for PWM interrupts
     PWM_MODULATOR_Q1->ETCLR.bit.INT = 1;
     PWM_MODULATOR_Q2->ETCLR.bit.INT = 1;
@@ -694,6 +735,38 @@ static interrupt void isr_controller(void)
     CLEAR_DEBUG_GPIO1;
 }
 
+/**
+ * Reference generator for SlowRef and SlowRefSync operation modes.
+ *
+ * @param p_srlim pointer to reference slew-rate limiter
+ */
+static void run_reference_srlim(volatile void *p_srlim)
+{
+    run_dsp_srlim((dsp_srlim_t *) p_srlim, USE_MODULE);
+}
+
+/**
+ * Reference generator for Cycle operation mode.
+ *
+ * @param p_siggen pointer to signal generator
+ */
+static void run_reference_cycle(volatile void *p_siggen)
+{
+    run_dsp_srlim(SRLIM_SIGGEN_AMP, USE_MODULE);
+    run_dsp_srlim(SRLIM_SIGGEN_OFFSET, USE_MODULE);
+    ((siggen_t *) p_siggen)->p_run_siggen((siggen_t *) p_siggen);
+}
+
+/**
+ * Reference generator for RmpWfm and MigWfm operation modes.
+ *
+ * @param p_wfmref pointer to waveform reference
+ */
+static void run_reference_wfmref(volatile void *p_wfmref)
+{
+    run_wfmref((wfmref_t *) p_wfmref);
+}
+
 /**
  * Initialization of interruptions.
  */
@@ -751,7 +824,7 @@ static void turn_on(uint16_t dummy)
     if(g_ipc_ctom.ps_module[0].ps_status.bit.state <= Interlock)
     #endif
     {
-        g_ipc_ctom.ps_module[0].ps_status.bit.state = Initializing;
+        cfg_ps_operation_mode(&g_ipc_ctom.ps_module[0], Initializing);
 
         PIN_SET_MAGNAPOWER_START;
         DELAY_US(TIMEOUT_MAGNAPOWER_COMMAND_PULSE_US);
@@ -759,7 +832,7 @@ static void turn_on(uint16_t dummy)
 
         DELAY_US(TIMEOUT_MAGNAPOWER_POWER_ON_US);
 
-        g_ipc_ctom.ps_module[0].ps_status.bit.state = SlowRef;
+        cfg_ps_operation_mode(&g_ipc_ctom.ps_module[0], SlowRef);
         enable_pwm_output(0);
         enable_pwm_output(1);
     }
@@ -45,6 +45,7 @@
 #include "ipc/ipc.h"
 #include "parameters/parameters.h"
 #include "pwm/pwm.h"
+#include "signals/signals.h"
 
 #include "fap_4p.h"
 
@@ -125,10 +126,15 @@
 #define DUTY_SHARE_MODULES_3    g_controller_ctom.net_signals[22].f
 #define DUTY_SHARE_MODULES_4    g_controller_ctom.net_signals[23].f
 
-#define DUTY_DIFF_MOD_1         g_controller_ctom.net_signals[24].f
-#define DUTY_DIFF_MOD_2         g_controller_ctom.net_signals[25].f
-#define DUTY_DIFF_MOD_3         g_controller_ctom.net_signals[26].f
-#define DUTY_DIFF_MOD_4         g_controller_ctom.net_signals[27].f
+/// Previously DUTY_DIFF_MOD_1..4 on net_signals[24..27]
+#define DUTY_SHARE_IGBT_1_MOD_1 g_controller_ctom.net_signals[24].f
+#define DUTY_SHARE_IGBT_2_MOD_1 g_controller_ctom.net_signals[25].f
+#define DUTY_SHARE_IGBT_1_MOD_2 g_controller_ctom.net_signals[26].f
+#define DUTY_SHARE_IGBT_2_MOD_2 g_controller_ctom.net_signals[27].f
+#define DUTY_SHARE_IGBT_1_MOD_3 g_controller_ctom.net_signals[28].f
+#define DUTY_SHARE_IGBT_2_MOD_3 g_controller_ctom.net_signals[29].f
+#define DUTY_SHARE_IGBT_1_MOD_4 g_controller_ctom.net_signals[30].f
+#define DUTY_SHARE_IGBT_2_MOD_4 g_controller_ctom.net_signals[31].f
 
 #define DUTY_CYCLE_IGBT_1_MOD_1     g_controller_ctom.output_signals[0].f
 #define DUTY_CYCLE_IGBT_2_MOD_1     g_controller_ctom.output_signals[1].f
@@ -179,29 +185,38 @@
 #define KI_I_LOAD                           PI_CONTROLLER_I_LOAD_COEFFS.ki
 
 /// IGBTs current share controllers
-#define ERROR_I_SHARE_MOD_1                 &g_controller_ctom.dsp_modules.dsp_error[1]
-#define PI_CONTROLLER_I_SHARE_MOD_1         &g_controller_ctom.dsp_modules.dsp_pi[1]
-#define PI_CONTROLLER_I_SHARE_MOD_1_COEFFS  g_controller_mtoc.dsp_modules.dsp_pi[1].coeffs.s
-#define KP_I_SHARE_MOD_1                    PI_CONTROLLER_I_SHARE_MOD_1_COEFFS.kp
-#define KI_I_SHARE_MOD_1                    PI_CONTROLLER_I_SHARE_MOD_1_COEFFS.ki
+#define SHARE_I_IGBTS                       &g_controller_ctom.dsp_modules.dsp_share[0]
+#define SHARE_I_IGBTS_COEFFS                g_controller_mtoc.dsp_modules.dsp_share[0].coeffs.s
 
-#define ERROR_I_SHARE_MOD_2                 &g_controller_ctom.dsp_modules.dsp_error[2]
-#define PI_CONTROLLER_I_SHARE_MOD_2         &g_controller_ctom.dsp_modules.dsp_pi[2]
+/**
+ * Parameter banks without share bank coefficients keep previous IGBTs share
+ * PI controller coefficients of each module, which are used while share bank
+ * gains are unset. Since share bank has a single gain set, they are only
+ * migrated as is if all modules have the same gains. Otherwise, module 1 gains
+ * are used and I_Share_IGBTs_Coeffs_Unset alarm is kept set until share bank
+ * coefficients are configured.
+ */
+#define PI_CONTROLLER_I_SHARE_MOD_1_COEFFS  g_controller_mtoc.dsp_modules.dsp_pi[1].coeffs.s
 #define PI_CONTROLLER_I_SHARE_MOD_2_COEFFS  g_controller_mtoc.dsp_modules.dsp_pi[2].coeffs.s
-#define KP_I_SHARE_MOD_2                    PI_CONTROLLER_I_SHARE_MOD_2_COEFFS.kp
-#define KI_I_SHARE_MOD_2                    PI_CONTROLLER_I_SHARE_MOD_2_COEFFS.ki
-
-#define ERROR_I_SHARE_MOD_3                 &g_controller_ctom.dsp_modules.dsp_error[3]
-#define PI_CONTROLLER_I_SHARE_MOD_3         &g_controller_ctom.dsp_modules.dsp_pi[3]
 #define PI_CONTROLLER_I_SHARE_MOD_3_COEFFS  g_controller_mtoc.dsp_modules.dsp_pi[3].coeffs.s
-#define KP_I_SHARE_MOD_3                    PI_CONTROLLER_I_SHARE_MOD_3_COEFFS.kp
-#define KI_I_SHARE_MOD_3                    PI_CONTROLLER_I_SHARE_MOD_3_COEFFS.ki
-
-#define ERROR_I_SHARE_MOD_4                 &g_controller_ctom.dsp_modules.dsp_error[4]
-#define PI_CONTROLLER_I_SHARE_MOD_4         &g_controller_ctom.dsp_modules.dsp_pi[4]
 #define PI_CONTROLLER_I_SHARE_MOD_4_COEFFS  g_controller_mtoc.dsp_modules.dsp_pi[4].coeffs.s
-#define KP_I_SHARE_MOD_4                    PI_CONTROLLER_I_SHARE_MOD_4_COEFFS.kp
-#define KI_I_SHARE_MOD_4                    PI_CONTROLLER_I_SHARE_MOD_4_COEFFS.ki
+#define I_SHARE_MODS_COEFFS_EQUAL(coeff)    ( (PI_CONTROLLER_I_SHARE_MOD_1_COEFFS.coeff ==    \
+                                               PI_CONTROLLER_I_SHARE_MOD_2_COEFFS.coeff) &&   \
+                                              (PI_CONTROLLER_I_SHARE_MOD_1_COEFFS.coeff ==    \
+                                               PI_CONTROLLER_I_SHARE_MOD_3_COEFFS.coeff) &&   \
+                                              (PI_CONTROLLER_I_SHARE_MOD_1_COEFFS.coeff ==    \
+                                               PI_CONTROLLER_I_SHARE_MOD_4_COEFFS.coeff) )
+#define SHARE_I_IGBTS_COEFFS_UNSET          ( (SHARE_I_IGBTS_COEFFS.kp == 0.0) &&     \
+                                              (SHARE_I_IGBTS_COEFFS.ki == 0.0) )
+#define SHARE_I_IGBTS_COEFFS_MISMATCH       ( SHARE_I_IGBTS_COEFFS_UNSET &&           \
+                                              !(I_SHARE_MODS_COEFFS_EQUAL(kp) &&      \
+                                                I_SHARE_MODS_COEFFS_EQUAL(ki)) )
+#define KP_I_SHARE_IGBTS                    ( SHARE_I_IGBTS_COEFFS_UNSET ?            \
+                                              PI_CONTROLLER_I_SHARE_MOD_1_COEFFS.kp : \
+                                              SHARE_I_IGBTS_COEFFS.kp )
+#define KI_I_SHARE_IGBTS                    ( SHARE_I_IGBTS_COEFFS_UNSET ?            \
+                                              PI_CONTROLLER_I_SHARE_MOD_1_COEFFS.ki : \
+                                              SHARE_I_IGBTS_COEFFS.ki )
 
 /// Modules current share controller
 #define PI_CONTROLLER_I_SHARE_MODULES           &g_controller_ctom.dsp_modules.dsp_pi[5]
@@ -224,6 +239,16 @@
 /// Scope
 #define SCOPE                               SCOPE_CTOM[0]
 
+/**
+ * Uncomment to calculate references one sample ahead, on deferred phase of
+ * control ISR, removing reference generators from critical phase.
+ */
+//#define USE_PIPELINED_REFERENCE
+
+/// Control ISR profile, measured by counter of ePWM module which triggered it
+#define ISR_PROFILE                         g_controller_ctom.isr_profile
+#define ISR_ELAPSED_CYCLES                  GET_PWM_ELAPSED_CYCLES(p_pwm_isr)
+
 /**
  * Digital I/O's status
  */
@@ -297,7 +322,8 @@ typedef enum
 
 typedef enum
 {
-    High_Sync_Input_Frequency = 0x00000001
+    High_Sync_Input_Frequency = 0x00000001,
+    I_Share_IGBTs_Coeffs_Unset = 0x00000002
 } alarms_t;
 
 typedef enum
@@ -313,14 +339,32 @@ typedef enum
  *  Private variables
  */
 static uint16_t decimation_factor;
-static float decimation_coeff, dummy_float;
+static float dummy_float;
+
+static volatile float *p_i_igbts[8] = {&I_IGBT_1_MOD_1, &I_IGBT_2_MOD_1,
+                                       &I_IGBT_1_MOD_2, &I_IGBT_2_MOD_2,
+                                       &I_IGBT_1_MOD_3, &I_IGBT_2_MOD_3,
+                                       &I_IGBT_1_MOD_4, &I_IGBT_2_MOD_4};
 
+static volatile float *p_duty_share_igbts[8] = {&DUTY_SHARE_IGBT_1_MOD_1,
+                                                &DUTY_SHARE_IGBT_2_MOD_1,
+                                                &DUTY_SHARE_IGBT_1_MOD_2,
+                                                &DUTY_SHARE_IGBT_2_MOD_2,
+                                                &DUTY_SHARE_IGBT_1_MOD_3,
+                                                &DUTY_SHARE_IGBT_2_MOD_3,
+                                                &DUTY_SHARE_IGBT_1_MOD_4,
+                                                &DUTY_SHARE_IGBT_2_MOD_4};
+
+static ps_reference_gen_t reference_gens[NUM_PS_STATES];
 
 /**
  * Private functions
  */
 #pragma CODE_SECTION(isr_init_controller, "ramfuncs");
 #pragma CODE_SECTION(isr_controller, "ramfuncs");
+#pragma CODE_SECTION(run_reference_srlim, "ramfuncs");
+#pragma CODE_SECTION(run_reference_cycle, "ramfuncs");
+#pragma CODE_SECTION(run_reference_wfmref, "ramfuncs");
 #pragma CODE_SECTION(turn_off, "ramfuncs");
 
 static void init_peripherals_drivers(void);
@@ -328,11 +372,16 @@ static void term_peripherals_drivers(void);
 
 static void init_controller(void);
 static void reset_controller(void);
+static void update_i_share_controller(float freq_sampling);
 static void enable_controller();
 static void disable_controller();
 static interrupt void isr_init_controller(void);
 static interrupt void isr_controller(void);
 
+static void run_reference_srlim(volatile void *p_srlim);
+static void run_reference_cycle(volatile void *p_siggen);
+static void run_reference_wfmref(volatile void *p_wfmref);
+
 static void init_interruptions(void);
 static void term_interruptions(void);
 
@@ -359,6 +408,7 @@ void main_fap_4p(void)
     while(1)
     {
         check_interlocks();
+        run_ipc_deferred_work();
     }
 
     turn_off(0);
@@ -372,18 +422,23 @@ void main_fap_4p(void)
 static void init_peripherals_drivers(void)
 {
     uint16_t i;
+    tDMA_Plan dma_plan;
 
     /// Initialization of HRADC boards
     stop_DMA();
 
-    decimation_factor = (uint16_t) roundf(HRADC_FREQ_SAMP / ISR_CONTROL_FREQ);
-    decimation_coeff = 1.0 / (float) decimation_factor;
+    HRADCs_Info.DMA_PlanStatus = Plan_DMA_McBSP_nBuffers(&dma_plan, NUM_HRADC_BOARDS,
+                                                         HRADC_SPI_CLK,
+                                                         HRADC_FREQ_SAMP,
+                                                         ISR_CONTROL_FREQ);
+
+    decimation_factor = dma_plan.size_buffers;
 
 
     HRADCs_Info.enable_Sampling = 0;
     HRADCs_Info.n_HRADC_boards = NUM_HRADC_BOARDS;
 
-    Init_DMA_McBSP_nBuffers(NUM_HRADC_BOARDS, decimation_factor, HRADC_SPI_CLK);
+    Init_DMA_McBSP_nBuffers(&dma_plan);
 
     Init_SPIMaster_McBSP(HRADC_SPI_CLK);
     Init_SPIMaster_Gpio();
@@ -401,6 +456,8 @@ static void init_peripherals_drivers(void)
                            HRADC_HEATER_ENABLE[i], HRADC_MONITOR_ENABLE[i]);
     }
 
+    register_hradc_signals(NUM_HRADC_BOARDS);
+
     Config_HRADC_SoC(HRADC_FREQ_SAMP);
 
     /**
@@ -499,8 +556,8 @@ static void init_controller(void)
     init_ipc();
 
     init_wfmref(&WFMREF, WFMREF_SELECTED_PARAM[0], WFMREF_SYNC_MODE_PARAM[0],
-                ISR_CONTROL_FREQ, WFMREF_FREQUENCY_PARAM[0], WFMREF_GAIN_PARAM[0],
-                WFMREF_OFFSET_PARAM[0], &g_wfmref_data.data, SIZE_WFMREF,
+                ISR_CONTROL_FREQ, WFMREF_FREQUENCY_PARAM[0],
+                WFMREF_GAIN_PARAM[0], WFMREF_OFFSET_PARAM[0],
                 &I_LOAD_REFERENCE);
 
     /***********************************************/
@@ -581,52 +638,24 @@ static void init_controller(void)
     /*******************************************************/
 
     /**
-     *        name:     PI_CONTROLLER_I_SHARE_MOD_1
-     * description:     IGBT current share PI controller for module 1
-     *  dsp module:     DSP_PI
-     *          in:     I_IGBTS_DIFF_MOD_1
-     *         out:     DUTY_DIFF_MOD_1
-     */
-
-    init_dsp_pi(PI_CONTROLLER_I_SHARE_MOD_1, KP_I_SHARE_MOD_1, KI_I_SHARE_MOD_1,
-                I_SHARE_CONTROLLER_FREQ_SAMP, PWM_LIM_DUTY_SHARE,
-                -PWM_LIM_DUTY_SHARE, &I_IGBTS_DIFF_MOD_1, &DUTY_DIFF_MOD_1);
-
-    /**
-     *        name:     PI_CONTROLLER_I_SHARE_MOD_2
-     * description:     IGBT current share PI controller for module 2
-     *  dsp module:     DSP_PI
-     *          in:     I_IGBTS_DIFF_MOD_2
-     *         out:     DUTY_DIFF_MOD_2
+     *        name:     SHARE_I_IGBTS
+     * description:     IGBTs current share PI controllers, for each module
+     *  dsp module:     DSP_Share
+     *          in:     I_IGBT_1_MOD_1 ... I_IGBT_2_MOD_4
+     *         out:     DUTY_SHARE_IGBT_1_MOD_1 ... DUTY_SHARE_IGBT_2_MOD_4
      */
 
-    init_dsp_pi(PI_CONTROLLER_I_SHARE_MOD_2, KP_I_SHARE_MOD_2, KI_I_SHARE_MOD_2,
-                I_SHARE_CONTROLLER_FREQ_SAMP, PWM_LIM_DUTY_SHARE,
-                -PWM_LIM_DUTY_SHARE, &I_IGBTS_DIFF_MOD_2, &DUTY_DIFF_MOD_2);
-
-    /**
-     *        name:     PI_CONTROLLER_I_SHARE_MOD_3
-     * description:     IGBT current share PI controller for module 3
-     *  dsp module:     DSP_PI
-     *          in:     I_IGBTS_DIFF_MOD_3
-     *         out:     DUTY_DIFF_MOD_3
-     */
-
-    init_dsp_pi(PI_CONTROLLER_I_SHARE_MOD_3, KP_I_SHARE_MOD_3, KI_I_SHARE_MOD_3,
-                I_SHARE_CONTROLLER_FREQ_SAMP, PWM_LIM_DUTY_SHARE,
-                -PWM_LIM_DUTY_SHARE, &I_IGBTS_DIFF_MOD_3, &DUTY_DIFF_MOD_3);
-
-    /**
-     *        name:     PI_CONTROLLER_I_SHARE_MOD_4
-     * description:     IGBT current share PI controller for module 4
-     *  dsp module:     DSP_PI
-     *          in:     I_IGBTS_DIFF_MOD_4
-     *         out:     DUTY_DIFF_MOD_4
-     */
+    init_dsp_share(SHARE_I_IGBTS, 8, 2,
+                   (I_IGBT_SHARE_MODE == DaisyChain) ? DSP_Share_Daisy_Chain :
+                                                       DSP_Share_Average,
+                   KP_I_SHARE_IGBTS, KI_I_SHARE_IGBTS,
+                   I_SHARE_CONTROLLER_FREQ_SAMP, PWM_LIM_DUTY_SHARE,
+                   -PWM_LIM_DUTY_SHARE, p_i_igbts, p_duty_share_igbts);
 
-    init_dsp_pi(PI_CONTROLLER_I_SHARE_MOD_4, KP_I_SHARE_MOD_4, KI_I_SHARE_MOD_4,
-                I_SHARE_CONTROLLER_FREQ_SAMP, PWM_LIM_DUTY_SHARE,
-                -PWM_LIM_DUTY_SHARE, &I_IGBTS_DIFF_MOD_4, &DUTY_DIFF_MOD_4);
+    if(SHARE_I_IGBTS_COEFFS_MISMATCH)
+    {
+        g_ipc_ctom.ps_module[0].ps_alarms |= I_Share_IGBTs_Coeffs_Unset;
+    }
 
     /**
      *        name:     PI_CONTROLLER_I_SHARE_MODULES
@@ -650,6 +679,76 @@ static void init_controller(void)
      */
     init_timeslicer(&TIMESLICER_I_SHARE_CONTROLLER, ISR_CONTROL_FREQ);
     cfg_timeslicer(&TIMESLICER_I_SHARE_CONTROLLER, I_SHARE_CONTROLLER_FREQ_SAMP);
+    cfg_timeslicer_update(TIMESLICER_I_SHARE_CONTROLLER_IDX,
+                          &update_i_share_controller);
+
+    /********************************************/
+    /** INITIALIZATION OF REFERENCE GENERATORS **/
+    /********************************************/
+
+    init_ps_reference(&g_ipc_ctom.ps_module[0], reference_gens);
+
+    cfg_ps_reference(&g_ipc_ctom.ps_module[0], SlowRef,
+                     &run_reference_srlim, SRLIM_I_LOAD_REFERENCE);
+    cfg_ps_reference(&g_ipc_ctom.ps_module[0], SlowRefSync,
+                     &run_reference_srlim, SRLIM_I_LOAD_REFERENCE);
+    cfg_ps_reference(&g_ipc_ctom.ps_module[0], Cycle,
+                     &run_reference_cycle, &SIGGEN);
+    cfg_ps_reference(&g_ipc_ctom.ps_module[0], RmpWfm,
+                     &run_reference_wfmref, &WFMREF);
+    cfg_ps_reference(&g_ipc_ctom.ps_module[0], MigWfm,
+                     &run_reference_wfmref, &WFMREF);
+
+    /****************************************/
+    /** INITIALIZATION OF SIGNALS REGISTRY **/
+    /****************************************/
+
+    init_signals();
+
+    REGISTER_SIGNAL(I_LOAD_SETPOINT, is_float, Unit_Ampere);
+    REGISTER_SIGNAL(I_LOAD_REFERENCE, is_float, Unit_Ampere);
+    REGISTER_SIGNAL(I_LOAD_1, is_float, Unit_Ampere);
+    REGISTER_SIGNAL(I_LOAD_2, is_float, Unit_Ampere);
+    REGISTER_SIGNAL(V_LOAD, is_float, Unit_Volt);
+    REGISTER_SIGNAL(I_LOAD_MEAN, is_float, Unit_Ampere);
+    REGISTER_SIGNAL(I_LOAD_ERROR, is_float, Unit_Ampere);
+    REGISTER_SIGNAL(DUTY_MEAN, is_float, Unit_Duty);
+    REGISTER_SIGNAL(I_LOAD_DIFF, is_float, Unit_Ampere);
+    REGISTER_SIGNAL(I_MOD_1, is_float, Unit_Ampere);
+    REGISTER_SIGNAL(I_MOD_2, is_float, Unit_Ampere);
+    REGISTER_SIGNAL(I_MOD_3, is_float, Unit_Ampere);
+    REGISTER_SIGNAL(I_MOD_4, is_float, Unit_Ampere);
+    REGISTER_SIGNAL(I_MOD_MEAN, is_float, Unit_Ampere);
+    REGISTER_SIGNAL(I_MOD_1_DIFF, is_float, Unit_Ampere);
+    REGISTER_SIGNAL(I_MOD_2_DIFF, is_float, Unit_Ampere);
+    REGISTER_SIGNAL(I_MOD_3_DIFF, is_float, Unit_Ampere);
+    REGISTER_SIGNAL(I_MOD_4_DIFF, is_float, Unit_Ampere);
+    REGISTER_SIGNAL(I_IGBTS_DIFF_MOD_1, is_float, Unit_Ampere);
+    REGISTER_SIGNAL(I_IGBTS_DIFF_MOD_2, is_float, Unit_Ampere);
+    REGISTER_SIGNAL(I_IGBTS_DIFF_MOD_3, is_float, Unit_Ampere);
+    REGISTER_SIGNAL(I_IGBTS_DIFF_MOD_4, is_float, Unit_Ampere);
+    REGISTER_SIGNAL(DUTY_SHARE_MODULES_1, is_float, Unit_Duty);
+    REGISTER_SIGNAL(DUTY_SHARE_MODULES_2, is_float, Unit_Duty);
+    REGISTER_SIGNAL(DUTY_SHARE_MODULES_3, is_float, Unit_Duty);
+    REGISTER_SIGNAL(DUTY_SHARE_MODULES_4, is_float, Unit_Duty);
+    REGISTER_SIGNAL(DUTY_SHARE_IGBT_1_MOD_1, is_float, Unit_Duty);
+    REGISTER_SIGNAL(DUTY_SHARE_IGBT_2_MOD_1, is_float, Unit_Duty);
+    REGISTER_SIGNAL(DUTY_SHARE_IGBT_1_MOD_2, is_float, Unit_Duty);
+    REGISTER_SIGNAL(DUTY_SHARE_IGBT_2_MOD_2, is_float, Unit_Duty);
+    REGISTER_SIGNAL(DUTY_SHARE_IGBT_1_MOD_3, is_float, Unit_Duty);
+    REGISTER_SIGNAL(DUTY_SHARE_IGBT_2_MOD_3, is_float, Unit_Duty);
+    REGISTER_SIGNAL(DUTY_SHARE_IGBT_1_MOD_4, is_float, Unit_Duty);
+    REGISTER_SIGNAL(DUTY_SHARE_IGBT_2_MOD_4, is_float, Unit_Duty);
+    REGISTER_SIGNAL(DUTY_CYCLE_IGBT_1_MOD_1, is_float, Unit_Duty);
+    REGISTER_SIGNAL(DUTY_CYCLE_IGBT_2_MOD_1, is_float, Unit_Duty);
+    REGISTER_SIGNAL(DUTY_CYCLE_IGBT_1_MOD_2, is_float, Unit_Duty);
+    REGISTER_SIGNAL(DUTY_CYCLE_IGBT_2_MOD_2, is_float, Unit_Duty);
+    REGISTER_SIGNAL(DUTY_CYCLE_IGBT_1_MOD_3, is_float, Unit_Duty);
+    REGISTER_SIGNAL(DUTY_CYCLE_IGBT_2_MOD_3, is_float, Unit_Duty);
+    REGISTER_SIGNAL(DUTY_CYCLE_IGBT_1_MOD_4, is_float, Unit_Duty);
+    REGISTER_SIGNAL(DUTY_CYCLE_IGBT_2_MOD_4, is_float, Unit_Duty);
+
+    REGISTER_DSP_PI_INTEGRATOR(PI_CONTROLLER_I_LOAD, Unit_Duty);
 
     /******************************/
     /** INITIALIZATION OF SCOPES **/
@@ -687,10 +786,7 @@ static void reset_controller(void)
     reset_dsp_error(ERROR_I_LOAD);
     reset_dsp_pi(PI_CONTROLLER_I_LOAD);
 
-    reset_dsp_pi(PI_CONTROLLER_I_SHARE_MOD_1);
-    reset_dsp_pi(PI_CONTROLLER_I_SHARE_MOD_2);
-    reset_dsp_pi(PI_CONTROLLER_I_SHARE_MOD_3);
-    reset_dsp_pi(PI_CONTROLLER_I_SHARE_MOD_4);
+    reset_dsp_share(SHARE_I_IGBTS);
 
     reset_dsp_srlim(SRLIM_SIGGEN_AMP);
     reset_dsp_srlim(SRLIM_SIGGEN_OFFSET);
@@ -699,11 +795,27 @@ static void reset_controller(void)
     reset_wfmref(&WFMREF);
 }
 
+/**
+ * Re-derive current share controller coefficients from new sampling frequency
+ * of its time slicer, set by ARM through Cfg_TimeSlicer.
+ *
+ * @param freq_sampling new sampling frequency [Hz]
+ */
+static void update_i_share_controller(float freq_sampling)
+{
+    cfg_dsp_share_freq(SHARE_I_IGBTS, freq_sampling);
+}
+
 /**
  * Enable control ISR
  */
 static void enable_controller()
 {
+    if(!DMA_PLAN_IS_VALID(HRADCs_Info.DMA_PlanStatus))
+    {
+        return;
+    }
+
     stop_DMA();
     DELAY_US(5);
     start_DMA();
@@ -759,44 +871,16 @@ static interrupt void isr_init_controller(void)
 static interrupt void isr_controller(void)
 {
     static float temp[4];
-    static uint16_t i;
+    volatile struct EPWM_REGS *p_pwm_isr;
+
+    p_pwm_isr = GET_PWM_ISR_MODULE;
 
     //CLEAR_DEBUG_GPIO1;
     //SET_DEBUG_GPIO0;
     SET_DEBUG_GPIO1;
 
-    temp[0] = 0.0;
-    temp[1] = 0.0;
-    temp[2] = 0.0;
-    temp[3] = 0.0;
-
     /// Get HRADC samples
-    for(i = 0; i < decimation_factor; i++)
-    {
-        temp[0] += (float) *(HRADCs_Info.HRADC_boards[0].SamplesBuffer++);
-        temp[1] += (float) *(HRADCs_Info.HRADC_boards[1].SamplesBuffer++);
-        temp[2] += (float) *(HRADCs_Info.HRADC_boards[2].SamplesBuffer++);
-        temp[3] += (float) *(HRADCs_Info.HRADC_boards[3].SamplesBuffer++);
-    }
-
-    //CLEAR_DEBUG_GPIO1;
-
-    HRADCs_Info.HRADC_boards[0].SamplesBuffer = buffers_HRADC[0];
-    HRADCs_Info.HRADC_boards[1].SamplesBuffer = buffers_HRADC[1];
-    HRADCs_Info.HRADC_boards[2].SamplesBuffer = buffers_HRADC[2];
-    HRADCs_Info.HRADC_boards[3].SamplesBuffer = buffers_HRADC[3];
-
-    temp[0] *= HRADCs_Info.HRADC_boards[0].gain * decimation_coeff;
-    temp[0] += HRADCs_Info.HRADC_boards[0].offset;
-
-    temp[1] *= HRADCs_Info.HRADC_boards[1].gain * decimation_coeff;
-    temp[1] += HRADCs_Info.HRADC_boards[1].offset;
-
-    temp[2] *= HRADCs_Info.HRADC_boards[2].gain * decimation_coeff;
-    temp[2] += HRADCs_Info.HRADC_boards[2].offset;
-
-    temp[3] *= HRADCs_Info.HRADC_boards[3].gain * decimation_coeff;
-    temp[3] += HRADCs_Info.HRADC_boards[3].offset;
+    Read_HRADC_Samples(temp);
 
     if(NUM_DCCTs)
     {
@@ -821,32 +905,11 @@ static interrupt void isr_controller(void)
     if(g_ipc_ctom.ps_module[0].ps_status.bit.state > Interlock)
     {
         /// Calculate reference according to operation mode
-        switch(g_ipc_ctom.ps_module[0].ps_status.bit.state)
-        {
-            case SlowRef:
-            case SlowRefSync:
-            {
-                run_dsp_srlim(SRLIM_I_LOAD_REFERENCE, USE_MODULE);
-                break;
-            }
-            case Cycle:
-            {
-                run_dsp_srlim(SRLIM_SIGGEN_AMP, USE_MODULE);
-                run_dsp_srlim(SRLIM_SIGGEN_OFFSET, USE_MODULE);
-                SIGGEN.p_run_siggen(&SIGGEN);
-                break;
-            }
-            case RmpWfm:
-            case MigWfm:
-            {
-                run_wfmref(&WFMREF);
-                break;
-            }
-            default:
-            {
-                break;
-            }
-        }
+        #ifdef USE_PIPELINED_REFERENCE
+        LATCH_PS_REFERENCE(&g_ipc_ctom.ps_module[0]);
+        #else
+        RUN_PS_REFERENCE(&g_ipc_ctom.ps_module[0]);
+        #endif
 
         /// Open-loop
         if(g_ipc_ctom.ps_module[0].ps_status.bit.openloop)
@@ -910,13 +973,27 @@ static interrupt void isr_controller(void)
                         SATURATE(DUTY_SHARE_MODULES_4, U_MAX_I_SHARE_MODULES,
                                  U_MIN_I_SHARE_MODULES);
 
-                        run_dsp_pi(PI_CONTROLLER_I_SHARE_MOD_1);
-                        run_dsp_pi(PI_CONTROLLER_I_SHARE_MOD_2);
-                        run_dsp_pi(PI_CONTROLLER_I_SHARE_MOD_3);
-                        run_dsp_pi(PI_CONTROLLER_I_SHARE_MOD_4);
+                        run_dsp_share(SHARE_I_IGBTS);
 
                         break;
                     }
+
+                    /**
+                     * Current share between modules isn't implemented for
+                     * daisy-chain mode, so only IGBTs are balanced
+                     */
+                    case DaisyChain:
+                    {
+                        DUTY_SHARE_MODULES_1 = 0.0;
+                        DUTY_SHARE_MODULES_2 = 0.0;
+                        DUTY_SHARE_MODULES_3 = 0.0;
+                        DUTY_SHARE_MODULES_4 = 0.0;
+
+                        run_dsp_share(SHARE_I_IGBTS);
+
+                        break;
+                    }
+
                     default:
                     {
                         break;
@@ -927,14 +1004,14 @@ static interrupt void isr_controller(void)
             END_TIMESLICER(TIMESLICER_I_SHARE_CONTROLLER)
             /*********************************************/
 
-            DUTY_CYCLE_IGBT_1_MOD_1 = DUTY_MEAN + DUTY_SHARE_MODULES_1 - DUTY_DIFF_MOD_1;
-            DUTY_CYCLE_IGBT_2_MOD_1 = DUTY_MEAN + DUTY_SHARE_MODULES_1 + DUTY_DIFF_MOD_1;
-            DUTY_CYCLE_IGBT_1_MOD_2 = DUTY_MEAN + DUTY_SHARE_MODULES_2 - DUTY_DIFF_MOD_2;
-            DUTY_CYCLE_IGBT_2_MOD_2 = DUTY_MEAN + DUTY_SHARE_MODULES_2 + DUTY_DIFF_MOD_2;
-            DUTY_CYCLE_IGBT_1_MOD_3 = DUTY_MEAN + DUTY_SHARE_MODULES_3 - DUTY_DIFF_MOD_3;
-            DUTY_CYCLE_IGBT_2_MOD_3 = DUTY_MEAN + DUTY_SHARE_MODULES_3 + DUTY_DIFF_MOD_3;
-            DUTY_CYCLE_IGBT_1_MOD_4 = DUTY_MEAN + DUTY_SHARE_MODULES_4 - DUTY_DIFF_MOD_4;
-            DUTY_CYCLE_IGBT_2_MOD_4 = DUTY_MEAN + DUTY_SHARE_MODULES_4 + DUTY_DIFF_MOD_4;
+            DUTY_CYCLE_IGBT_1_MOD_1 = DUTY_MEAN + DUTY_SHARE_MODULES_1 + DUTY_SHARE_IGBT_1_MOD_1;
+            DUTY_CYCLE_IGBT_2_MOD_1 = DUTY_MEAN + DUTY_SHARE_MODULES_1 + DUTY_SHARE_IGBT_2_MOD_1;
+            DUTY_CYCLE_IGBT_1_MOD_2 = DUTY_MEAN + DUTY_SHARE_MODULES_2 + DUTY_SHARE_IGBT_1_MOD_2;
+            DUTY_CYCLE_IGBT_2_MOD_2 = DUTY_MEAN + DUTY_SHARE_MODULES_2 + DUTY_SHARE_IGBT_2_MOD_2;
+            DUTY_CYCLE_IGBT_1_MOD_3 = DUTY_MEAN + DUTY_SHARE_MODULES_3 + DUTY_SHARE_IGBT_1_MOD_3;
+            DUTY_CYCLE_IGBT_2_MOD_3 = DUTY_MEAN + DUTY_SHARE_MODULES_3 + DUTY_SHARE_IGBT_2_MOD_3;
+            DUTY_CYCLE_IGBT_1_MOD_4 = DUTY_MEAN + DUTY_SHARE_MODULES_4 + DUTY_SHARE_IGBT_1_MOD_4;
+            DUTY_CYCLE_IGBT_2_MOD_4 = DUTY_MEAN + DUTY_SHARE_MODULES_4 + DUTY_SHARE_IGBT_2_MOD_4;
 
             SATURATE(DUTY_CYCLE_IGBT_1_MOD_1, PWM_MAX_DUTY, PWM_MIN_DUTY);
             SATURATE(DUTY_CYCLE_IGBT_2_MOD_1, PWM_MAX_DUTY, PWM_MIN_DUTY);
@@ -956,6 +1033,17 @@ static interrupt void isr_controller(void)
         set_pwm_duty_chA(PWM_MODULATOR_IGBT_2_MOD_4, DUTY_CYCLE_IGBT_2_MOD_4);
     }
 
+    /*********************************************/
+    END_ISR_CRITICAL_PHASE(ISR_PROFILE, ISR_ELAPSED_CYCLES)
+    /*********************************************/
+
+    HRADCs_Info.HRADC_boards[0].SamplesBuffer = buffers_HRADC[0];
+    HRADCs_Info.HRADC_boards[1].SamplesBuffer = buffers_HRADC[1];
+    HRADCs_Info.HRADC_boards[2].SamplesBuffer = buffers_HRADC[2];
+    HRADCs_Info.HRADC_boards[3].SamplesBuffer = buffers_HRADC[3];
+
+    RUN_IPC_LATENCY;
+
     RUN_SCOPE(SCOPE);
 
     SET_INTERLOCKS_TIMEBASE_FLAG(0);
@@ -969,7 +1057,7 @@ static interrupt void isr_controller(void)
         /// Set alarm if counter is below limit when receiving new sync pulse
         if(counter_sync_period < MIN_NUM_ISR_CONTROLLER_SYNC)
         {
-            g_ipc_ctom.ps_module[0].ps_alarms = High_Sync_Input_Frequency;
+            g_ipc_ctom.ps_module[0].ps_alarms |= High_Sync_Input_Frequency;
         }
 
         /// Store counter value on BSMP variable
@@ -990,6 +1078,18 @@ static interrupt void isr_controller(void)
     /// Re-enable XINT2 (external interrupt 2) interrupt used for sync pulses
     PieCtrlRegs.PIEIER1.bit.INTx5 = 1;
 
+    #ifdef USE_PIPELINED_REFERENCE
+    /// Calculate reference for next ISR
+    if(g_ipc_ctom.ps_module[0].ps_status.bit.state > Interlock)
+    {
+        run_ps_reference_ahead(&g_ipc_ctom.ps_module[0]);
+    }
+    #endif
+
+    /*********************************************/
+    END_ISR_DEFERRED_PHASE(ISR_PROFILE, ISR_ELAPSED_CYCLES)
+    /*********************************************/
+
     /// Clear interrupt flags for PWM interrupts
     PWM_MODULATOR_IGBT_1_MOD_1->ETCLR.bit.INT = 1;
     PWM_MODULATOR_IGBT_2_MOD_1->ETCLR.bit.INT = 1;
@@ -998,6 +1098,38 @@ static interrupt void isr_controller(void)
     CLEAR_DEBUG_GPIO1;
 }
 
+/**
+ * Reference generator for SlowRef and SlowRefSync operation modes.
+ *
+ * @param p_srlim pointer to reference slew-rate limiter
+ */
+static void run_reference_srlim(volatile void *p_srlim)
+{
+    run_dsp_srlim((dsp_srlim_t *) p_srlim, USE_MODULE);
+}
+
+/**
+ * Reference generator for Cycle operation mode.
+ *
+ * @param p_siggen pointer to signal generator
+ */
+static void run_reference_cycle(volatile void *p_siggen)
+{
+    run_dsp_srlim(SRLIM_SIGGEN_AMP, USE_MODULE);
+    run_dsp_srlim(SRLIM_SIGGEN_OFFSET, USE_MODULE);
+    ((siggen_t *) p_siggen)->p_run_siggen((siggen_t *) p_siggen);
+}
+
+/**
+ * Reference generator for RmpWfm and MigWfm operation modes.
+ *
+ * @param p_wfmref pointer to waveform reference
+ */
+static void run_reference_wfmref(volatile void *p_wfmref)
+{
+    run_wfmref((wfmref_t *) p_wfmref);
+}
+
 /**
  * Initialization of interruptions.
  */
@@ -1122,7 +1254,7 @@ static void turn_on(uint16_t dummy)
             else
             {
             #endif
-                g_ipc_ctom.ps_module[0].ps_status.bit.state = Initializing;
+                cfg_ps_operation_mode(&g_ipc_ctom.ps_module[0], Initializing);
             #ifdef USE_ITLK
             }
         }
@@ -1172,6 +1304,11 @@ static void reset_interlocks(uint16_t dummy)
     g_ipc_ctom.ps_module[0].ps_soft_interlock = 0;
     g_ipc_ctom.ps_module[0].ps_alarms = 0;
 
+    if(SHARE_I_IGBTS_COEFFS_MISMATCH)
+    {
+        g_ipc_ctom.ps_module[0].ps_alarms |= I_Share_IGBTs_Coeffs_Unset;
+    }
+
     if(g_ipc_ctom.ps_module[0].ps_status.bit.state < Initializing)
     {
         if(PIN_STATUS_DCLINK_CONTACTOR_MOD_1)
@@ -1390,7 +1527,7 @@ static inline void check_interlocks(void)
                 (V_DCLINK_MOD_3 > MIN_V_DCLINK) &&
                 (V_DCLINK_MOD_4 > MIN_V_DCLINK) )
             {
-                g_ipc_ctom.ps_module[0].ps_status.bit.state = SlowRef;
+                cfg_ps_operation_mode(&g_ipc_ctom.ps_module[0], SlowRef);
 
                 enable_pwm_output(0);
                 enable_pwm_output(1);
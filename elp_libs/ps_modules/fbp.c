@@ -29,6 +29,7 @@
 #include "ipc/ipc.h"
 #include "parameters/parameters.h"
 #include "pwm/pwm.h"
+#include "signals/signals.h"
 
 #include "fbp.h"
 
@@ -42,9 +43,12 @@
 #define MAX_TEMP(id)            ANALOG_VARS_MAX[12+id]
 
 /**
- * All power supplies defines
+ * Uncomment to update duty cycles on both peak and valley of PWM carrier. It
+ * requires ISR_CONTROL_FREQ = 2 * PWM_FREQ, and is ignored otherwise. If HRADC
+ * sampling isn't aligned with both carrier events, controller isn't enabled
+ * and PWM_Double_Update_Fault alarm is set.
  */
-#define DECIMATION_FACTOR       1//(HRADC_FREQ_SAMP/ISR_CONTROL_FREQ)
+//#define USE_PWM_DOUBLE_UPDATE
 
 #define SIGGEN                  SIGGEN_CTOM
 #define SIGGEN_OUTPUT           g_controller_ctom.net_signals[12].f
@@ -54,6 +58,9 @@
 
 #define PS_SETPOINT(i)          g_ipc_ctom.ps_module[i].ps_setpoint
 #define PS_REFERENCE(i)         g_ipc_ctom.ps_module[i].ps_reference
+#define PS_LOAD_CURRENT(i)      g_controller_ctom.net_signals[i].f
+
+#define PS_MASK(i)              (1 << (i))
 
 /**
  * Power supply 1 defines
@@ -183,6 +190,16 @@
 
 #define PS4_SCOPE                       SCOPE_CTOM[3]
 
+/**
+ * Uncomment to calculate references one sample ahead, on deferred phase of
+ * control ISR, removing reference generators from critical phase.
+ */
+//#define USE_PIPELINED_REFERENCE
+
+/// Control ISR profile, measured by ePWM1 counter (HRADC sampling reference)
+#define ISR_PROFILE                     g_controller_ctom.isr_profile
+#define ISR_ELAPSED_CYCLES              GET_PWM_ELAPSED_CYCLES(PS4_PWM_MODULATOR)
+
 /**
  * Interlocks defines
  */
@@ -205,7 +222,8 @@ typedef enum
 
 typedef enum
 {
-    High_Sync_Input_Frequency = 0x00000001
+    High_Sync_Input_Frequency = 0x00000001,
+    PWM_Double_Update_Fault = 0x00000002
 } alarms_t;
 
 #define NUM_HARD_INTERLOCKS             MOSFETs_Driver_Fault + 1
@@ -213,11 +231,38 @@ typedef enum
 
 #define ISR_FREQ_INTERLOCK_TIMEBASE     5000.0
 
+/**
+ *  Private variables
+ */
+static ps_reference_gen_t reference_gens[NUM_MAX_PS_MODULES][NUM_PS_STATES];
+
+/**
+ * Masks of installed (active) power supplies, and of those which are also
+ * switched on. They are updated by turn_on() and turn_off(), which are also
+ * called on interlocks, so control ISR doesn't need to check status of each
+ * power supply.
+ */
+static uint16_t ps_active_mask;
+static uint16_t ps_on_mask;
+
+/// Set if double-update PWM mode couldn't be configured
+static uint16_t pwm_double_update_fault;
+
+/**
+ * Index of least significant bit set for each 4-bit mask, used to iterate only
+ * over the power supplies set in a mask
+ */
+static const uint16_t mask_lsb_idx[16] = {0, 0, 1, 0, 2, 0, 1, 0,
+                                          3, 0, 1, 0, 2, 0, 1, 0};
+
 /**
  * Private functions
  */
 #pragma CODE_SECTION(isr_init_controller, "ramfuncs");
 #pragma CODE_SECTION(isr_controller, "ramfuncs");
+#pragma CODE_SECTION(run_reference_setpoint, "ramfuncs");
+#pragma CODE_SECTION(run_reference_cycle, "ramfuncs");
+#pragma CODE_SECTION(run_reference_wfmref, "ramfuncs");
 #pragma CODE_SECTION(turn_off, "ramfuncs");
 #pragma CODE_SECTION(open_relay, "ramfuncs");
 
@@ -232,6 +277,10 @@ static void disable_controller();
 static interrupt void isr_init_controller(void);
 static interrupt void isr_controller(void);
 
+static void run_reference_setpoint(volatile void *p_ps_module);
+static void run_reference_cycle(volatile void *p_siggen);
+static void run_reference_wfmref(volatile void *p_wfmref);
+
 static void init_interruptions(void);
 static void term_interruptions(void);
 
@@ -274,6 +323,8 @@ void main_fbp(void)
                 check_interlocks_ps_module(i);
             }
         }
+
+        run_ipc_deferred_work();
     }
 
     for(i = 0; i < NUM_MAX_PS_MODULES; i++)
@@ -290,13 +341,23 @@ void main_fbp(void)
 static void init_peripherals_drivers(void)
 {
     uint16_t i;
+    tDMA_Plan dma_plan;
 
     /// Initialization of HRADC boards
     stop_DMA();
 
     HRADCs_Info.enable_Sampling = 0;
 
-    Init_DMA_McBSP_nBuffers(NUM_PS_MODULES, DECIMATION_FACTOR, HRADC_SPI_CLK);
+    /**
+     * Each power supply reads a single sample from its board per control
+     * period, so no decimation is planned
+     */
+    HRADCs_Info.DMA_PlanStatus = Plan_DMA_McBSP_nBuffers(&dma_plan, NUM_PS_MODULES,
+                                                         HRADC_SPI_CLK,
+                                                         HRADC_FREQ_SAMP,
+                                                         HRADC_FREQ_SAMP);
+
+    Init_DMA_McBSP_nBuffers(&dma_plan);
 
     Init_SPIMaster_McBSP(HRADC_SPI_CLK);
     Init_SPIMaster_Gpio();
@@ -308,12 +369,14 @@ static void init_peripherals_drivers(void)
 
     for(i = 0; i < NUM_PS_MODULES; i++)
     {
-        Init_HRADC_Info(&HRADCs_Info.HRADC_boards[i], i, DECIMATION_FACTOR,
+        Init_HRADC_Info(&HRADCs_Info.HRADC_boards[i], i, dma_plan.size_buffers,
                         buffers_HRADC[i], TRANSDUCER_GAIN[i]);
         Config_HRADC_board(&HRADCs_Info.HRADC_boards[i], TRANSDUCER_OUTPUT_TYPE[i],
                            HRADC_HEATER_ENABLE[i], HRADC_MONITOR_ENABLE[i]);
     }
 
+    register_hradc_signals(NUM_PS_MODULES);
+
     HRADCs_Info.n_HRADC_boards = NUM_PS_MODULES;
 
     Config_HRADC_SoC(HRADC_FREQ_SAMP);
@@ -361,6 +424,38 @@ static void init_peripherals_drivers(void)
     init_pwm_module(PS1_PWM_MODULATOR_NEG, PWM_FREQ, 7, PWM_Sync_Slave, 180,
                     PWM_ChB_Complementary, PWM_DEAD_TIME);
 
+    pwm_double_update_fault = 0;
+
+    #ifdef USE_PWM_DOUBLE_UPDATE
+    if(ISR_CONTROL_FREQ == 2.0 * PWM_FREQ)
+    {
+        /**
+         * All modules share the same sampling alignment, so either all of them
+         * are reconfigured, or all are kept unchanged and controller, designed
+         * for ISR_CONTROL_FREQ, must not be enabled
+         */
+        if( !cfg_pwm_double_update(PS4_PWM_MODULATOR, PWM_FREQ,
+                                   PWM_Sync_Master, 0, HRADC_FREQ_SAMP) ||
+            !cfg_pwm_double_update(PS4_PWM_MODULATOR_NEG, PWM_FREQ,
+                                   PWM_Sync_Slave, 180, HRADC_FREQ_SAMP) ||
+            !cfg_pwm_double_update(PS3_PWM_MODULATOR, PWM_FREQ,
+                                   PWM_Sync_Slave, 0, HRADC_FREQ_SAMP) ||
+            !cfg_pwm_double_update(PS3_PWM_MODULATOR_NEG, PWM_FREQ,
+                                   PWM_Sync_Slave, 180, HRADC_FREQ_SAMP) ||
+            !cfg_pwm_double_update(PS2_PWM_MODULATOR, PWM_FREQ,
+                                   PWM_Sync_Slave, 0, HRADC_FREQ_SAMP) ||
+            !cfg_pwm_double_update(PS2_PWM_MODULATOR_NEG, PWM_FREQ,
+                                   PWM_Sync_Slave, 180, HRADC_FREQ_SAMP) ||
+            !cfg_pwm_double_update(PS1_PWM_MODULATOR, PWM_FREQ,
+                                   PWM_Sync_Slave, 0, HRADC_FREQ_SAMP) ||
+            !cfg_pwm_double_update(PS1_PWM_MODULATOR_NEG, PWM_FREQ,
+                                   PWM_Sync_Slave, 180, HRADC_FREQ_SAMP) )
+        {
+            pwm_double_update_fault = 1;
+        }
+    }
+    #endif
+
     InitEPwm1Gpio();
     InitEPwm2Gpio();
     InitEPwm3Gpio();
@@ -385,6 +480,48 @@ static void init_controller(void)
 {
     static uint16_t i;
 
+    ps_active_mask = 0;
+    ps_on_mask = 0;
+
+    /// Initialization of signals registry, which must precede scopes
+    init_signals();
+
+    REGISTER_SIGNAL(PS1_SETPOINT, is_float, Unit_Ampere);
+    REGISTER_SIGNAL(PS1_REFERENCE, is_float, Unit_Ampere);
+    REGISTER_SIGNAL(PS1_LOAD_CURRENT, is_float, Unit_Ampere);
+    REGISTER_SIGNAL(PS2_SETPOINT, is_float, Unit_Ampere);
+    REGISTER_SIGNAL(PS2_REFERENCE, is_float, Unit_Ampere);
+    REGISTER_SIGNAL(PS2_LOAD_CURRENT, is_float, Unit_Ampere);
+    REGISTER_SIGNAL(PS3_SETPOINT, is_float, Unit_Ampere);
+    REGISTER_SIGNAL(PS3_REFERENCE, is_float, Unit_Ampere);
+    REGISTER_SIGNAL(PS3_LOAD_CURRENT, is_float, Unit_Ampere);
+    REGISTER_SIGNAL(PS4_SETPOINT, is_float, Unit_Ampere);
+    REGISTER_SIGNAL(PS4_REFERENCE, is_float, Unit_Ampere);
+    REGISTER_SIGNAL(PS4_LOAD_CURRENT, is_float, Unit_Ampere);
+
+    register_signal("PS1_LOAD_CURRENT_ERROR", is_float, Unit_Ampere,
+                    &g_controller_ctom.net_signals[4].f);
+    register_signal("PS2_LOAD_CURRENT_ERROR", is_float, Unit_Ampere,
+                    &g_controller_ctom.net_signals[5].f);
+    register_signal("PS3_LOAD_CURRENT_ERROR", is_float, Unit_Ampere,
+                    &g_controller_ctom.net_signals[6].f);
+    register_signal("PS4_LOAD_CURRENT_ERROR", is_float, Unit_Ampere,
+                    &g_controller_ctom.net_signals[7].f);
+
+    register_signal("PS1_DUTY_CYCLE", is_float, Unit_Duty,
+                    &g_controller_ctom.output_signals[0].f);
+    register_signal("PS2_DUTY_CYCLE", is_float, Unit_Duty,
+                    &g_controller_ctom.output_signals[1].f);
+    register_signal("PS3_DUTY_CYCLE", is_float, Unit_Duty,
+                    &g_controller_ctom.output_signals[2].f);
+    register_signal("PS4_DUTY_CYCLE", is_float, Unit_Duty,
+                    &g_controller_ctom.output_signals[3].f);
+
+    REGISTER_DSP_PI_INTEGRATOR(PI_CONTROLLER_ILOAD_PS1, Unit_Duty);
+    REGISTER_DSP_PI_INTEGRATOR(PI_CONTROLLER_ILOAD_PS2, Unit_Duty);
+    REGISTER_DSP_PI_INTEGRATOR(PI_CONTROLLER_ILOAD_PS3, Unit_Duty);
+    REGISTER_DSP_PI_INTEGRATOR(PI_CONTROLLER_ILOAD_PS4, Unit_Duty);
+
     for(i = 0; i < NUM_MAX_PS_MODULES; i++)
     {
         init_ps_module(&g_ipc_ctom.ps_module[i],
@@ -403,11 +540,15 @@ static void init_controller(void)
         {
             g_ipc_ctom.ps_module[i].ps_status.bit.active = 0;
         }
+        else
+        {
+            ps_active_mask |= PS_MASK(i);
+        }
 
         init_wfmref(&WFMREF[i], WFMREF_SELECTED_PARAM[i], WFMREF_SYNC_MODE_PARAM[i],
-                    ISR_CONTROL_FREQ, WFMREF_FREQUENCY_PARAM[i], WFMREF_GAIN_PARAM[i],
-                    WFMREF_OFFSET_PARAM[i], &g_wfmref_data.data_fbp[i],
-                    SIZE_WFMREF_FBP, &PS_REFERENCE(i));
+                    ISR_CONTROL_FREQ, WFMREF_FREQUENCY_PARAM[i],
+                    WFMREF_GAIN_PARAM[i], WFMREF_OFFSET_PARAM[i],
+                    &PS_REFERENCE(i));
 
         init_scope(&SCOPE_CTOM[i], ISR_CONTROL_FREQ,
                    SCOPE_FREQ_SAMPLING_PARAM[i],
@@ -423,6 +564,20 @@ static void init_controller(void)
         cfg_siggen(&SIGGEN[i], SIGGEN_TYPE_PARAM, SIGGEN_NUM_CYCLES_PARAM,
                    SIGGEN_FREQ_PARAM, SIGGEN_AMP_PARAM,
                    SIGGEN_OFFSET_PARAM, SIGGEN_AUX_PARAM);
+
+        /// Initialization of reference generators
+        init_ps_reference(&g_ipc_ctom.ps_module[i], reference_gens[i]);
+
+        cfg_ps_reference(&g_ipc_ctom.ps_module[i], SlowRef,
+                         &run_reference_setpoint, &g_ipc_ctom.ps_module[i]);
+        cfg_ps_reference(&g_ipc_ctom.ps_module[i], SlowRefSync,
+                         &run_reference_setpoint, &g_ipc_ctom.ps_module[i]);
+        cfg_ps_reference(&g_ipc_ctom.ps_module[i], Cycle,
+                         &run_reference_cycle, &SIGGEN[i]);
+        cfg_ps_reference(&g_ipc_ctom.ps_module[i], RmpWfm,
+                         &run_reference_wfmref, &WFMREF[i]);
+        cfg_ps_reference(&g_ipc_ctom.ps_module[i], MigWfm,
+                         &run_reference_wfmref, &WFMREF[i]);
     }
 
     init_control_framework(&g_controller_ctom);
@@ -580,6 +735,25 @@ static void reset_controllers(void)
  */
 static void enable_controller()
 {
+    uint16_t i;
+
+    if(pwm_double_update_fault)
+    {
+        for(i = 0; i < NUM_MAX_PS_MODULES; i++)
+        {
+            if(g_ipc_ctom.ps_module[i].ps_status.bit.active)
+            {
+                g_ipc_ctom.ps_module[i].ps_alarms |= PWM_Double_Update_Fault;
+            }
+        }
+        return;
+    }
+
+    if(!DMA_PLAN_IS_VALID(HRADCs_Info.DMA_PlanStatus))
+    {
+        return;
+    }
+
     stop_DMA();
     DELAY_US(5);
     start_DMA();
@@ -640,102 +814,71 @@ static interrupt void isr_init_controller(void)
 static interrupt void isr_controller(void)
 {
     static uint16_t i;
-    static float temp[4];
+    static uint16_t mask;
 
     //SET_DEBUG_GPIO0;
     SET_DEBUG_GPIO1;
 
-    /// Get HRADC samples
-    temp[0] = (float) *(HRADCs_Info.HRADC_boards[0].SamplesBuffer);
-    temp[1] = (float) *(HRADCs_Info.HRADC_boards[1].SamplesBuffer);
-    temp[2] = (float) *(HRADCs_Info.HRADC_boards[2].SamplesBuffer);
-    temp[3] = (float) *(HRADCs_Info.HRADC_boards[3].SamplesBuffer);
-
-    temp[0] *= HRADCs_Info.HRADC_boards[0].gain;
-    temp[0] += HRADCs_Info.HRADC_boards[0].offset;
-
-    temp[1] *= HRADCs_Info.HRADC_boards[1].gain;
-    temp[1] += HRADCs_Info.HRADC_boards[1].offset;
+    /// Get HRADC samples from installed power supplies
+    mask = ps_active_mask;
+    while(mask)
+    {
+        i = mask_lsb_idx[mask];
+        mask &= mask - 1;
 
-    temp[2] *= HRADCs_Info.HRADC_boards[2].gain;
-    temp[2] += HRADCs_Info.HRADC_boards[2].offset;
+        PS_LOAD_CURRENT(i) = (float) *(HRADCs_Info.HRADC_boards[i].SamplesBuffer);
+        PS_LOAD_CURRENT(i) *= HRADCs_Info.HRADC_boards[i].gain;
+        PS_LOAD_CURRENT(i) += HRADCs_Info.HRADC_boards[i].offset;
+    }
 
-    temp[3] *= HRADCs_Info.HRADC_boards[3].gain;
-    temp[3] += HRADCs_Info.HRADC_boards[3].offset;
+    /// Loop through power supplies which are switched on
+    mask = ps_on_mask;
+    while(mask)
+    {
+        i = mask_lsb_idx[mask];
+        mask &= mask - 1;
 
-    PS1_LOAD_CURRENT = temp[0];
-    PS2_LOAD_CURRENT = temp[1];
-    PS3_LOAD_CURRENT = temp[2];
-    PS4_LOAD_CURRENT = temp[3];
+        /// Calculate reference according to operation mode
+        #ifdef USE_PIPELINED_REFERENCE
+        LATCH_PS_REFERENCE(&g_ipc_ctom.ps_module[i]);
+        #else
+        RUN_PS_REFERENCE(&g_ipc_ctom.ps_module[i]);
+        #endif
 
-    /// Loop through active power supplies
-    for(i = 0; i < NUM_MAX_PS_MODULES; i++)
-    {
-        /// Check whether power supply is active
-        if(g_ipc_ctom.ps_module[i].ps_status.bit.active)
+        /// Open-loop
+        if(g_ipc_ctom.ps_module[i].ps_status.bit.openloop)
         {
-            /// Check whether power supply is ON
-            if(g_ipc_ctom.ps_module[i].ps_status.bit.state > Interlock)
-            {
-                /// Calculate reference according to operation mode
-                switch(g_ipc_ctom.ps_module[i].ps_status.bit.state)
-                {
-                    case SlowRef:
-                    case SlowRefSync:
-                    {
-                        PS_REFERENCE(i) = PS_SETPOINT(i);
-                        break;
-                    }
-                    case RmpWfm:
-                    case MigWfm:
-                    {
-                        run_wfmref(&WFMREF[i]);
-                        break;
-                    }
-                    case Cycle:
-                    {
-                        SIGGEN[i].amplitude = SIGGEN_MTOC[i].amplitude;
-                        SIGGEN[i].offset = SIGGEN_MTOC[i].offset;
-                        SIGGEN[i].p_run_siggen(&SIGGEN[i]);
+            g_controller_ctom.output_signals[i].f = 0.01 * PS_REFERENCE(i);
 
-                        break;
-                    }
-                    default:
-                    {
-                        break;
-                    }
-                }
+            SATURATE(g_controller_ctom.output_signals[i].f,
+                     PWM_MAX_DUTY_OL, PWM_MIN_DUTY_OL);
+        }
+        /// Closed-loop
+        else
+        {
+            SATURATE(PS_REFERENCE(i), MAX_REF[i], MIN_REF[i]);
 
-                /// Open-loop
-                if(g_ipc_ctom.ps_module[i].ps_status.bit.openloop)
-                {
-                    g_controller_ctom.output_signals[i].f = 0.01 * PS_REFERENCE(i);
+            //run_dsp_error(&g_controller_ctom.dsp_modules.dsp_error[i]);
 
-                    SATURATE(g_controller_ctom.output_signals[i].f,
-                             PWM_MAX_DUTY_OL, PWM_MIN_DUTY_OL);
-                }
-                /// Closed-loop
-                else
-                {
-                    SATURATE(PS_REFERENCE(i), MAX_REF[i], MIN_REF[i]);
+            *g_controller_ctom.dsp_modules.dsp_error[i].error =
+                    *g_controller_ctom.dsp_modules.dsp_error[i].pos -
+                    *g_controller_ctom.dsp_modules.dsp_error[i].neg;
 
-                    //run_dsp_error(&g_controller_ctom.dsp_modules.dsp_error[i]);
+            run_dsp_pi_inline(&g_controller_ctom.dsp_modules.dsp_pi[i]);
 
-                    *g_controller_ctom.dsp_modules.dsp_error[i].error =
-                            *g_controller_ctom.dsp_modules.dsp_error[i].pos -
-                            *g_controller_ctom.dsp_modules.dsp_error[i].neg;
+            //SATURATE(g_controller_ctom.output_signals[i].f,
+            //         PWM_MAX_DUTY, PWM_MIN_DUTY);
+        }
 
-                    run_dsp_pi_inline(&g_controller_ctom.dsp_modules.dsp_pi[i]);
+        set_pwm_duty_hbridge_inline(g_pwm_modules.pwm_regs[i*2],
+                                    g_controller_ctom.output_signals[i].f);
+    }
 
-                    //SATURATE(g_controller_ctom.output_signals[i].f,
-                    //         PWM_MAX_DUTY, PWM_MIN_DUTY);
-                }
+    /*********************************************/
+    END_ISR_CRITICAL_PHASE(ISR_PROFILE, ISR_ELAPSED_CYCLES)
+    /*********************************************/
 
-                set_pwm_duty_hbridge_inline(g_pwm_modules.pwm_regs[i*2],
-                                     g_controller_ctom.output_signals[i].f);
-            }
-        }
-    }
+    RUN_IPC_LATENCY;
 
     RUN_SCOPE(PS1_SCOPE);
     RUN_SCOPE(PS2_SCOPE);
@@ -779,6 +922,22 @@ static interrupt void isr_controller(void)
     /// Re-enable XINT2 (external interrupt 2) interrupt used for sync pulses
     PieCtrlRegs.PIEIER1.bit.INTx5 = 1;
 
+    #ifdef USE_PIPELINED_REFERENCE
+    /// Calculate references for next ISR
+    mask = ps_on_mask;
+    while(mask)
+    {
+        i = mask_lsb_idx[mask];
+        mask &= mask - 1;
+
+        run_ps_reference_ahead(&g_ipc_ctom.ps_module[i]);
+    }
+    #endif
+
+    /*********************************************/
+    END_ISR_DEFERRED_PHASE(ISR_PROFILE, ISR_ELAPSED_CYCLES)
+    /*********************************************/
+
     /// Clear interrupt flags for PWM interrupts
     PS1_PWM_MODULATOR->ETCLR.bit.INT = 1;
     PS1_PWM_MODULATOR_NEG->ETCLR.bit.INT = 1;
@@ -794,6 +953,44 @@ static interrupt void isr_controller(void)
     CLEAR_DEBUG_GPIO1;
 }
 
+/**
+ * Reference generator for SlowRef and SlowRefSync operation modes. FBP
+ * doesn't use slew-rate limiters, so setpoint is applied directly.
+ *
+ * @param p_ps_module pointer to the ps module struct
+ */
+static void run_reference_setpoint(volatile void *p_ps_module)
+{
+    ((ps_module_t *) p_ps_module)->ps_reference =
+                                ((ps_module_t *) p_ps_module)->ps_setpoint;
+}
+
+/**
+ * Reference generator for Cycle operation mode. Amplitude and offset are
+ * updated from ARM without slew-rate limiters.
+ *
+ * @param p_siggen pointer to signal generator
+ */
+static void run_reference_cycle(volatile void *p_siggen)
+{
+    siggen_t *p = (siggen_t *) p_siggen;
+    uint16_t id = p - SIGGEN;
+
+    p->amplitude = SIGGEN_MTOC[id].amplitude;
+    p->offset = SIGGEN_MTOC[id].offset;
+    p->p_run_siggen(p);
+}
+
+/**
+ * Reference generator for RmpWfm and MigWfm operation modes.
+ *
+ * @param p_wfmref pointer to waveform reference
+ */
+static void run_reference_wfmref(volatile void *p_wfmref)
+{
+    run_wfmref((wfmref_t *) p_wfmref);
+}
+
 /**
  * Initialization of interruptions.
  */
@@ -915,7 +1112,8 @@ static void turn_on(uint16_t id)
             {
                 close_relay(id);
 
-                g_ipc_ctom.ps_module[id].ps_status.bit.state = SlowRef;
+                cfg_ps_operation_mode(&g_ipc_ctom.ps_module[id], SlowRef);
+                ps_on_mask |= PS_MASK(id);
 
                 enable_pwm_output(2*id);
                 enable_pwm_output((2*id)+1);
@@ -939,6 +1137,8 @@ static void turn_off(uint16_t id)
 {
     if(g_ipc_ctom.ps_module[id].ps_status.bit.active)
     {
+        ps_on_mask &= ~PS_MASK(id);
+
         disable_pwm_output(2*id);
         disable_pwm_output((2*id)+1);
 
@@ -964,6 +1164,12 @@ static void reset_interlocks(uint16_t id)
     g_ipc_ctom.ps_module[id].ps_soft_interlock = 0;
     g_ipc_ctom.ps_module[id].ps_alarms = 0;
 
+    /// Controller is never enabled in this case, so alarm is kept
+    if(pwm_double_update_fault)
+    {
+        g_ipc_ctom.ps_module[id].ps_alarms = PWM_Double_Update_Fault;
+    }
+
     if(g_ipc_ctom.ps_module[id].ps_status.bit.state < Initializing)
     {
         g_ipc_ctom.ps_module[id].ps_status.bit.state = Off;
@@ -14,16 +14,26 @@
  *
  * Module for control of DC-Link crate from FBP FAC power supplies.
  *
+ * In open-loop, setpoint is applied directly to the digital potentiometer. In
+ * closed-loop, setpoint is the DC-Link voltage [V], which is regulated by
+ * trimming the digital potentiometer reference. In both cases, ARM applies
+ * ps_reference to the digital potentiometer. Closed-loop is only unlocked when
+ * DCLink_Digital_Pot_Step parameter is set, otherwise power supply is kept
+ * locked in open-loop.
+ *
  * @author gabriel.brunheira
  * @date 05/06/2018
  *
  */
 
+#include <math.h>
+
 #include "boards/udc_c28.h"
 #include "control/control.h"
 #include "event_manager/event_manager.h"
 #include "ipc/ipc.h"
 #include "pwm/pwm.h"
+#include "signals/signals.h"
 
 #include "fbp_dclink.h"
 
@@ -57,6 +67,37 @@
 
 #define DIGITAL_POT_VOLTAGE             g_controller_mtoc.net_signals[4].u32
 
+#define V_DCLINK_REFERENCE              g_controller_ctom.net_signals[1].f
+#define V_DCLINK_ERROR                  g_controller_ctom.net_signals[2].f
+#define DIGITAL_POT_REFERENCE_PI        g_controller_ctom.net_signals[3].f
+
+/**
+ * Controller defines
+ */
+#define V_DCLINK_SETPOINT               g_ipc_ctom.ps_module[0].ps_setpoint
+#define DIGITAL_POT_REFERENCE           g_ipc_ctom.ps_module[0].ps_reference
+#define DIGITAL_POT_STEP                DCLINK_DIGITAL_POT_STEP
+
+#define TIMESLICER_CONTROLLER_IDX       0
+#define TIMESLICER_CONTROLLER           g_controller_ctom.timeslicer[TIMESLICER_CONTROLLER_IDX]
+#define CONTROLLER_FREQ_SAMP            TIMESLICER_FREQ[TIMESLICER_CONTROLLER_IDX]
+
+#define SRLIM_V_DCLINK_REFERENCE        &g_controller_ctom.dsp_modules.dsp_srlim[0]
+#define MAX_SLEWRATE_SLOWREF            g_controller_mtoc.dsp_modules.dsp_srlim[0].coeffs.s.max_slewrate
+
+#define ERROR_V_DCLINK                  &g_controller_ctom.dsp_modules.dsp_error[0]
+
+#define PI_CONTROLLER_V_DCLINK          &g_controller_ctom.dsp_modules.dsp_pi[0]
+#define PI_CONTROLLER_V_DCLINK_COEFFS   g_controller_mtoc.dsp_modules.dsp_pi[0].coeffs.s
+#define KP_V_DCLINK                     PI_CONTROLLER_V_DCLINK_COEFFS.kp
+#define KI_V_DCLINK                     PI_CONTROLLER_V_DCLINK_COEFFS.ki
+#define INTEGRATOR_V_DCLINK             g_controller_ctom.dsp_modules.dsp_pi[0].u_int
+
+/// Control ISR profile, measured by CPU timer 0 counter, which triggers it
+#define ISR_PROFILE                     g_controller_ctom.isr_profile
+#define ISR_ELAPSED_CYCLES              (uint16_t) (CpuTimer0Regs.PRD.all - \
+                                                    CpuTimer0Regs.TIM.all)
+
 /**
  * Analog variables parameters
  */
@@ -97,10 +138,24 @@ typedef enum
 
 #define ISR_FREQ_INTERLOCK_TIMEBASE     10000.0
 
+/**
+ *  Private variables
+ */
+static ps_reference_gen_t reference_gens[NUM_PS_STATES];
+
 /**
  * Private functions
  */
+#pragma CODE_SECTION(isr_controller, "ramfuncs");
+#pragma CODE_SECTION(run_reference_srlim, "ramfuncs");
+#pragma CODE_SECTION(update_digital_pot_reference, "ramfuncs");
+
 static void init_controller(void);
+static void reset_controller(void);
+static void update_controller(float freq_sampling);
+static interrupt void isr_controller(void);
+static void run_reference_srlim(volatile void *p_srlim);
+static void update_digital_pot_reference(void);
 
 static void init_peripherals_drivers(void);
 
@@ -151,20 +206,22 @@ void main_fbp_dclink(void)
             check_interlocks_ps_module(i);
         }
 
-        /// Saturate and reference
+        /**
+         * Saturate setpoint. In open-loop, it's applied directly to digital
+         * potentiometer. In closed-loop, reference is calculated on
+         * isr_controller.
+         */
         if(g_ipc_ctom.ps_module[0].ps_status.bit.openloop)
         {
-            SATURATE(g_ipc_ctom.ps_module[0].ps_setpoint, MAX_REF_OL[0], MIN_REF_OL[0]);
+            SATURATE(V_DCLINK_SETPOINT, MAX_REF_OL[0], MIN_REF_OL[0]);
+            DIGITAL_POT_REFERENCE = V_DCLINK_SETPOINT;
         }
         else
         {
-            /// TODO: After implementation of closed loop, remove first line
-            /// below and un-comment second line
-            open_loop(&g_ipc_ctom.ps_module[0]);
-            ///SATURATE(g_ipc_ctom.ps_module[0].ps_setpoint, MAX_REF[0], MIN_REF[0]);
+            SATURATE(V_DCLINK_SETPOINT, MAX_REF[0], MIN_REF[0]);
         }
 
-        g_ipc_ctom.ps_module[0].ps_reference = g_ipc_ctom.ps_module[0].ps_setpoint;
+        run_ipc_deferred_work();
     }
 
     turn_off(0);
@@ -188,12 +245,126 @@ static void init_controller(void)
     init_ipc();
     init_control_framework(&g_controller_ctom);
 
-    /// TODO: This line avoids this PS model to open/close loop. After
-    /// implementation of control law, remove this line.
-    g_ipc_ctom.ps_module[0].ps_status.bit.unlocked = LOCKED;
+    /**
+     * Digital potentiometer step is required to close the loop, so keep this
+     * power supply locked in open-loop while it isn't set.
+     */
+    if(DIGITAL_POT_STEP <= 0.0)
+    {
+        g_ipc_ctom.ps_module[0].ps_status.bit.unlocked = LOCKED;
+    }
 
     g_ipc_ctom.ps_module[0].ps_setpoint = g_ipc_mtoc.ps_module[0].ps_setpoint;
 
+    /****************************************************/
+    /** INITIALIZATION OF DC-LINK VOLTAGE CONTROL LOOP **/
+    /****************************************************/
+
+    init_timeslicer(&TIMESLICER_CONTROLLER, ISR_FREQ_INTERLOCK_TIMEBASE);
+    cfg_timeslicer(&TIMESLICER_CONTROLLER, CONTROLLER_FREQ_SAMP);
+    cfg_timeslicer_update(TIMESLICER_CONTROLLER_IDX, &update_controller);
+
+    /**
+     *        name:     SRLIM_V_DCLINK_REFERENCE
+     * description:     DC-Link voltage slew-rate limiter
+     *    DP class:     DSP_SRLim
+     *          in:     V_DCLINK_SETPOINT
+     *         out:     V_DCLINK_REFERENCE
+     */
+
+    init_dsp_srlim(SRLIM_V_DCLINK_REFERENCE, MAX_SLEWRATE_SLOWREF,
+                   TIMESLICER_CONTROLLER.freq_sampling, &V_DCLINK_SETPOINT,
+                   &V_DCLINK_REFERENCE);
+
+    /**
+     *        name:     ERROR_V_DCLINK
+     * description:     DC-Link voltage reference error
+     *  dsp module:     DSP_Error
+     *           +:     V_DCLINK_REFERENCE
+     *           -:     V_DCLINK_OUTPUT
+     *         out:     V_DCLINK_ERROR
+     */
+
+    init_dsp_error(ERROR_V_DCLINK, &V_DCLINK_REFERENCE, &V_DCLINK_OUTPUT,
+                   &V_DCLINK_ERROR);
+
+    /**
+     *        name:     PI_CONTROLLER_V_DCLINK
+     * description:     DC-Link voltage PI controller
+     *  dsp module:     DSP_PI
+     *          in:     V_DCLINK_ERROR
+     *         out:     DIGITAL_POT_REFERENCE_PI
+     */
+
+    init_dsp_pi(PI_CONTROLLER_V_DCLINK, KP_V_DCLINK, KI_V_DCLINK,
+                TIMESLICER_CONTROLLER.freq_sampling, MAX_REF_OL[0],
+                MIN_REF_OL[0], &V_DCLINK_ERROR, &DIGITAL_POT_REFERENCE_PI);
+
+    DIGITAL_POT_REFERENCE = 0.0;
+    V_DCLINK_REFERENCE = 0.0;
+
+    /**
+     * DC-Link voltage is only set by SlowRef modes
+     */
+    init_ps_reference(&g_ipc_ctom.ps_module[0], reference_gens);
+
+    cfg_ps_reference(&g_ipc_ctom.ps_module[0], SlowRef,
+                     &run_reference_srlim, SRLIM_V_DCLINK_REFERENCE);
+    cfg_ps_reference(&g_ipc_ctom.ps_module[0], SlowRefSync,
+                     &run_reference_srlim, SRLIM_V_DCLINK_REFERENCE);
+
+    /****************************************/
+    /** INITIALIZATION OF SIGNALS REGISTRY **/
+    /****************************************/
+
+    init_signals();
+
+    REGISTER_SIGNAL(V_DCLINK_SETPOINT, is_float, Unit_Volt);
+    REGISTER_SIGNAL(V_DCLINK_REFERENCE, is_float, Unit_Volt);
+    REGISTER_SIGNAL(PIN_STATUS_ALL_PS_FAIL, is_uint32_t, Unit_None);
+    REGISTER_SIGNAL(DIGITAL_POT_REFERENCE, is_float, Unit_None);
+    REGISTER_SIGNAL(V_DCLINK_ERROR, is_float, Unit_Volt);
+    REGISTER_SIGNAL(DIGITAL_POT_REFERENCE_PI, is_float, Unit_None);
+
+    REGISTER_DSP_PI_INTEGRATOR(PI_CONTROLLER_V_DCLINK, Unit_None);
+
+    reset_controller();
+}
+
+/**
+ * Reset DC-Link voltage controller. Reference starts from measured voltage and
+ * integrator from current digital potentiometer reference, rounded to its
+ * resolution, so the loop starts without steps.
+ */
+static void reset_controller(void)
+{
+    if(DIGITAL_POT_STEP > 0.0)
+    {
+        DIGITAL_POT_REFERENCE = DIGITAL_POT_STEP *
+                                roundf(DIGITAL_POT_REFERENCE / DIGITAL_POT_STEP);
+    }
+
+    V_DCLINK_REFERENCE = V_DCLINK_OUTPUT;
+
+    reset_dsp_error(ERROR_V_DCLINK);
+    reset_dsp_pi(PI_CONTROLLER_V_DCLINK);
+
+    INTEGRATOR_V_DCLINK = DIGITAL_POT_REFERENCE;
+    DIGITAL_POT_REFERENCE_PI = DIGITAL_POT_REFERENCE;
+
+    reset_timeslicer(&TIMESLICER_CONTROLLER);
+}
+
+/**
+ * Re-derive DC-Link voltage controller coefficients from new sampling
+ * frequency of its time slicer, set by ARM through Cfg_TimeSlicer.
+ *
+ * @param freq_sampling new sampling frequency [Hz]
+ */
+static void update_controller(float freq_sampling)
+{
+    cfg_dsp_srlim_freq(SRLIM_V_DCLINK_REFERENCE, freq_sampling);
+    cfg_dsp_pi_freq(PI_CONTROLLER_V_DCLINK, freq_sampling);
 }
 
 static void init_peripherals_drivers(void)
@@ -209,7 +380,7 @@ static void init_peripherals_drivers(void)
 static void init_interruptions(void)
 {
     EALLOW;
-    PieVectTable.TINT0 = &isr_interlocks_timebase;
+    PieVectTable.TINT0 = &isr_controller;
     EDIS;
 
     /// Enable TINT0 in the PIE: Group 1 interrupt 7
@@ -240,9 +411,110 @@ static void turn_on(uint16_t id)
         PIN_CLOSE_EXTERNAL_RELAY;
         DELAY_US(TIMEOUT_DCLINK_RELAY);
 
-        g_ipc_ctom.ps_module[0].ps_status.bit.state = SlowRef;
         g_ipc_ctom.ps_module[0].ps_setpoint = g_ipc_mtoc.ps_module[0].ps_setpoint;
-        g_ipc_ctom.ps_module[0].ps_reference = g_ipc_mtoc.ps_module[0].ps_setpoint;
+
+        if(g_ipc_ctom.ps_module[0].ps_status.bit.openloop)
+        {
+            g_ipc_ctom.ps_module[0].ps_reference = g_ipc_mtoc.ps_module[0].ps_setpoint;
+        }
+        else
+        {
+            reset_controller();
+        }
+
+        cfg_ps_operation_mode(&g_ipc_ctom.ps_module[0], SlowRef);
+    }
+}
+
+/**
+ * Control ISR, running at interlocks time-base frequency. DC-Link voltage
+ * controller is decimated by TIMESLICER_CONTROLLER.
+ */
+static interrupt void isr_controller(void)
+{
+    RUN_TIMESLICER(TIMESLICER_CONTROLLER)
+
+    if( (g_ipc_ctom.ps_module[0].ps_status.bit.state > Interlock) &&
+        (g_ipc_ctom.ps_module[0].ps_status.bit.openloop == CLOSED_LOOP) )
+    {
+        RUN_PS_REFERENCE(&g_ipc_ctom.ps_module[0]);
+        run_dsp_error(ERROR_V_DCLINK);
+        run_dsp_pi(PI_CONTROLLER_V_DCLINK);
+        update_digital_pot_reference();
+    }
+
+    END_TIMESLICER(TIMESLICER_CONTROLLER)
+
+    /*********************************************/
+    END_ISR_CRITICAL_PHASE(ISR_PROFILE, ISR_ELAPSED_CYCLES)
+    /*********************************************/
+
+    RUN_IPC_LATENCY;
+
+    SET_INTERLOCKS_TIMEBASE_FLAG(0);
+
+    /*********************************************/
+    END_ISR_DEFERRED_PHASE(ISR_PROFILE, ISR_ELAPSED_CYCLES)
+    /*********************************************/
+
+    PieCtrlRegs.PIEACK.all |= PIEACK_GROUP1;
+}
+
+/**
+ * Reference generator for SlowRef and SlowRefSync operation modes.
+ *
+ * @param p_srlim pointer to reference slew-rate limiter
+ */
+static void run_reference_srlim(volatile void *p_srlim)
+{
+    run_dsp_srlim((dsp_srlim_t *) p_srlim, USE_MODULE);
+}
+
+/**
+ * Update digital potentiometer reference from DC-Link voltage controller. The
+ * potentiometer only accepts integer steps, so its reference is moved by one
+ * step whenever the controller output is one step away from it. This avoids
+ * dithering between adjacent steps, and limits the trimming rate to one step
+ * per controller period.
+ *
+ * Anti-windup keeps the controller output within one step from the
+ * potentiometer reference, so the integrator doesn't charge while the
+ * potentiometer is catching up, but still accumulates errors smaller than one
+ * step.
+ */
+static void update_digital_pot_reference(void)
+{
+    float delta;
+
+    if(DIGITAL_POT_STEP > 0.0)
+    {
+        delta = DIGITAL_POT_REFERENCE_PI - DIGITAL_POT_REFERENCE;
+
+        if(delta >= DIGITAL_POT_STEP)
+        {
+            DIGITAL_POT_REFERENCE += DIGITAL_POT_STEP;
+            delta -= DIGITAL_POT_STEP;
+        }
+        else if(delta <= -DIGITAL_POT_STEP)
+        {
+            DIGITAL_POT_REFERENCE -= DIGITAL_POT_STEP;
+            delta += DIGITAL_POT_STEP;
+        }
+
+        if(delta > DIGITAL_POT_STEP)
+        {
+            INTEGRATOR_V_DCLINK -= delta - DIGITAL_POT_STEP;
+            DIGITAL_POT_REFERENCE_PI -= delta - DIGITAL_POT_STEP;
+        }
+        else if(delta < -DIGITAL_POT_STEP)
+        {
+            INTEGRATOR_V_DCLINK -= delta + DIGITAL_POT_STEP;
+            DIGITAL_POT_REFERENCE_PI -= delta + DIGITAL_POT_STEP;
+        }
+    }
+    else
+    {
+        DIGITAL_POT_REFERENCE = DIGITAL_POT_REFERENCE_PI;
     }
 }
 
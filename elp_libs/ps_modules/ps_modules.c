@@ -21,6 +21,7 @@
  */
 
 #include "ps_modules.h"
+#include "ipc/ipc.h"
 #include "parameters/parameters.h"
 
 /**
@@ -29,11 +30,23 @@
  */
 #define PASSWORD    0xCAFE
 
+#pragma CODE_SECTION(run_ps_reference_none, "ramfuncs");
+#pragma CODE_SECTION(run_ps_reference_ahead, "ramfuncs");
+
 /**
  * TODO: Put here your constants and variables. Always use static for 
  * private members.
  */
 
+/**
+ * Reference generator used for states without reference calculation (e.g.,
+ * *Off*, *Interlock*, *Initializing* and *FastRef*) and for modules which
+ * didn't register any generator.
+ */
+static ps_reference_gen_t reference_none = {&run_ps_reference_none, 0};
+
+ps_reference_ctrl_t g_ps_reference_ctrl[NUM_MAX_PS_MODULES];
+
 /**
  * TODO: Put here your function prototypes for private functions. Use
  * static in declaration.
@@ -76,6 +89,90 @@ void init_ps_module(ps_module_t *p_ps_module, ps_model_t model,
     p_ps_module->isr_soft_interlock = isr_soft_interlock;
     p_ps_module->isr_hard_interlock = isr_hard_interlock;
     p_ps_module->reset_interlocks   = reset_interlocks;
+
+    PS_REFERENCE_CTRL(p_ps_module).p_reference_gens    = 0;
+    PS_REFERENCE_CTRL(p_ps_module).p_reference         = &reference_none;
+    PS_REFERENCE_CTRL(p_ps_module).ps_reference_next   = 0.0;
+    PS_REFERENCE_CTRL(p_ps_module).reference_ahead     = 0;
+}
+
+/**
+ * Initialization of reference generators table. Table is owned by the power
+ * supply model and is indexed by ps_state_t. All entries are initialized with
+ * a generator which does nothing, so only states with reference calculation
+ * must be configured with ```cfg_ps_reference()```.
+ *
+ * @param p_ps_module pointer to the ps module struct
+ * @param p_reference_gens pointer to table with NUM_PS_STATES generators
+ */
+void init_ps_reference(ps_module_t *p_ps_module,
+                       ps_reference_gen_t *p_reference_gens)
+{
+    uint16_t i;
+
+    for(i = 0; i < NUM_PS_STATES; i++)
+    {
+        p_reference_gens[i] = reference_none;
+    }
+
+    PS_REFERENCE_CTRL(p_ps_module).p_reference_gens = p_reference_gens;
+    PS_REFERENCE_CTRL(p_ps_module).p_reference =
+                        &p_reference_gens[p_ps_module->ps_status.bit.state];
+}
+
+/**
+ * Configuration of reference generator for specified operation state. It's
+ * applied only on next change of operation state.
+ *
+ * @param p_ps_module pointer to the ps module struct
+ * @param state operation state which uses this generator
+ * @param p_run address of reference generator function
+ * @param p_ctx pointer to generator context, passed to ```p_run()```
+ */
+void cfg_ps_reference(ps_module_t *p_ps_module, ps_state_t state,
+                      void (*p_run)(volatile void *p_ctx),
+                      volatile void *p_ctx)
+{
+    ps_reference_gen_t *p_reference_gens;
+
+    p_reference_gens = PS_REFERENCE_CTRL(p_ps_module).p_reference_gens;
+
+    if( (p_reference_gens != 0) && (state < NUM_PS_STATES) )
+    {
+        p_reference_gens[state].p_run = p_run;
+        p_reference_gens[state].p_ctx = p_ctx;
+    }
+}
+
+/**
+ * Reference generator which does nothing.
+ *
+ * @param p_ctx not used
+ */
+void run_ps_reference_none(volatile void *p_ctx)
+{
+}
+
+/**
+ * Run reference generator one sample ahead, to be latched by next control ISR
+ * with LATCH_PS_REFERENCE. Current reference is restored afterwards, since
+ * it's used by telemetry and it's also the state of slew-rate limiters, so
+ * generators always run with the same inputs as RUN_PS_REFERENCE on next ISR.
+ *
+ * @param p_ps_module pointer to the ps module struct
+ */
+void run_ps_reference_ahead(ps_module_t *p_ps_module)
+{
+    float reference;
+
+    reference = p_ps_module->ps_reference;
+
+    RUN_PS_REFERENCE(p_ps_module);
+
+    PS_REFERENCE_CTRL(p_ps_module).ps_reference_next =
+                                                    p_ps_module->ps_reference;
+    p_ps_module->ps_reference = reference;
+    PS_REFERENCE_CTRL(p_ps_module).reference_ahead = 1;
 }
 
 /**
@@ -138,6 +235,19 @@ void cfg_ps_operation_mode(ps_module_t *p_ps_module, ps_state_t op_mode)
         }
     }
 
+    /**
+     * Active generator is selected here, so control ISR doesn't need to
+     * decode operation state. Single pointer write keeps it consistent if
+     * ISR preempts this function.
+     */
+    if(PS_REFERENCE_CTRL(p_ps_module).p_reference_gens != 0)
+    {
+        PS_REFERENCE_CTRL(p_ps_module).p_reference =
+                    &PS_REFERENCE_CTRL(p_ps_module).p_reference_gens[op_mode];
+    }
+
+    INVALIDATE_PS_REFERENCE_AHEAD(p_ps_module);
+
     p_ps_module->ps_status.bit.state = op_mode;
 }
 
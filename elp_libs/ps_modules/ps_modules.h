@@ -36,6 +36,47 @@
 #define UNLOCKED            1
 
 #define NUM_MAX_PS_MODULES  4
+#define NUM_PS_STATES       9
+
+/**
+ * C28 private reference state of specified ps module. Modules are always
+ * elements of g_ipc_ctom.ps_module, so state is indexed by their position.
+ */
+#define PS_REFERENCE_CTRL(p_ps_module)  \
+    g_ps_reference_ctrl[(p_ps_module) - g_ipc_ctom.ps_module]
+
+/**
+ * Run reference generator currently selected for specified ps module. This is
+ * called by control ISR's instead of decoding operation state every sample.
+ */
+#define RUN_PS_REFERENCE(p_ps_module)                           \
+    PS_REFERENCE_CTRL(p_ps_module).p_reference->p_run(          \
+                        PS_REFERENCE_CTRL(p_ps_module).p_reference->p_ctx)
+
+/**
+ * Pipelined reference. Reference for next sample is calculated by
+ * ```run_ps_reference_ahead()``` on deferred phase of control ISR, and it's
+ * only latched on critical phase of next one. Sync pulses and operation mode
+ * changes between both ISR's either complete this sample (siggen start) or
+ * invalidate it, and then generator is executed inline, so reference samples
+ * and their timing relative to sync pulses are the same as with
+ * RUN_PS_REFERENCE. Asynchronous commands (e.g., SlowRef setpoints) may be
+ * applied one sample later.
+ */
+#define LATCH_PS_REFERENCE(p_ps_module)                                 \
+    if(PS_REFERENCE_CTRL(p_ps_module).reference_ahead)                  \
+    {                                                                   \
+        (p_ps_module)->ps_reference =                                   \
+                        PS_REFERENCE_CTRL(p_ps_module).ps_reference_next; \
+        PS_REFERENCE_CTRL(p_ps_module).reference_ahead = 0;             \
+    }                                                                   \
+    else                                                                \
+    {                                                                   \
+        RUN_PS_REFERENCE(p_ps_module);                                  \
+    }
+
+#define INVALIDATE_PS_REFERENCE_AHEAD(p_ps_module)  \
+    PS_REFERENCE_CTRL(p_ps_module).reference_ahead = 0
 
 typedef enum
 {
@@ -95,6 +136,16 @@ typedef union
     ps_status_bits_t    bit;
 } ps_status_t;
 
+/**
+ * Reference generator of a ps module. Context is specific for each generator
+ * (e.g., slew-rate limiter, signal generator or waveform reference).
+ */
+typedef struct
+{
+    void            (*p_run)(volatile void *p_ctx);
+    volatile void   *p_ctx;
+} ps_reference_gen_t;
+
 typedef struct
 {
     ps_status_t     ps_status;
@@ -110,11 +161,32 @@ typedef struct
     void            (*reset_interlocks)(uint16_t id);
 } ps_module_t;
 
+/**
+ * Reference generation state of a ps module. It's private to C28, so it's
+ * kept apart from ps_module_t, whose layout is shared with ARM.
+ */
+typedef struct
+{
+    ps_reference_gen_t  *p_reference_gens;
+    ps_reference_gen_t  *p_reference;
+    float               ps_reference_next;
+    uint16_t            reference_ahead;
+} ps_reference_ctrl_t;
+
+extern ps_reference_ctrl_t g_ps_reference_ctrl[NUM_MAX_PS_MODULES];
+
 extern void init_ps_module(ps_module_t *p_ps_module, ps_model_t model,
                            void (*turn_on)(uint16_t), void (*turn_off)(uint16_t),
                            void (*isr_soft_interlock)(void),
                            void (*isr_hard_interlock)(void),
                            void (*reset_interlocks)(uint16_t id));
+extern void init_ps_reference(ps_module_t *p_ps_module,
+                              ps_reference_gen_t *p_reference_gens);
+extern void cfg_ps_reference(ps_module_t *p_ps_module, ps_state_t state,
+                             void (*p_run)(volatile void *p_ctx),
+                             volatile void *p_ctx);
+extern void run_ps_reference_none(volatile void *p_ctx);
+extern void run_ps_reference_ahead(ps_module_t *p_ps_module);
 extern void cfg_ps_operation_mode(ps_module_t *p_ps_module, ps_state_t op_mode);
 extern void open_loop(ps_module_t *p_ps_module);
 extern void close_loop(ps_module_t *p_ps_module);
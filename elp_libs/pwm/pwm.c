@@ -137,7 +137,7 @@ void cfg_pwm_sync(volatile struct EPWM_REGS *p_pwm_module, pwm_sync_t sync_mode,
  *
  * @param p_pwm_module specified PWM module
  * @param cfg_channel_b channel B configuration [`PWM_ChB_Independent`,
- * `PWM_ChB_Complementary`]
+ * `PWM_ChB_Complementary`, `PWM_ChB_Complementary_Swapped`]
  */
 void cfg_pwm_channel_b(volatile struct EPWM_REGS *p_pwm_module,
                        cfg_pwm_channel_b_t cfg_channel_b)
@@ -243,6 +243,18 @@ void set_pwm_duty_chB(volatile struct EPWM_REGS *p_pwm_module, float duty_pu)
  * with unipolar switching scheme. Channel B must be set as complementary using
  * `cfg_pwm_channel_b()` function.
  *
+ * Only the module of the first leg is written. Second leg module must be linked
+ * to it (`set_pwm_primary_module()`) and synchronized with 180º phase, so both
+ * legs share the same compare value over carriers shifted by half period. As
+ * second leg upper switch is driven by the complement of its channel A (either
+ * by `PWM_ChB_Complementary_Swapped` or by board wiring), this is equivalent to
+ * opposite references over in-phase carriers: output voltage switches between
+ * 0 and +/-Vdc, with ripple at twice the switching frequency and half the
+ * amplitude of a bipolar scheme. This holds for both saw-tooth and triangular
+ * carriers (`cfg_pwm_double_update()`). With triangular carriers, output pulses
+ * are also centered on zero and period events, so samples taken there are at
+ * load current ripple mean value.
+ *
  * @param p_pwm_module specified PWM module
  * @param duty specified duty cycle [p.u.]
  */
@@ -351,6 +363,98 @@ void init_pwm_module(volatile struct EPWM_REGS *p_pwm_module, double freq,
     EDIS;
 }
 
+/**
+ * Reconfigure specified PWM module, already initialized by
+ * `init_pwm_module()`, for double-update mode. Carrier is changed to a
+ * triangular (up-down) waveform with the same switching frequency, and compare
+ * registers are loaded both at zero and at period, as well as PWM interrupt,
+ * so duty cycle can be updated twice per switching period. This halves the
+ * modulation delay, and samples taken at those events are free of switching
+ * ripple.
+ *
+ * Control ISR driven by this module runs at twice the switching frequency,
+ * and the HRADC start-of-conversion (`Config_HRADC_SoC()`), which is
+ * synchronized with zero of ePWM1, must have an integer number of periods
+ * within half switching period to remain aligned with both events. Otherwise,
+ * module is kept unchanged.
+ *
+ * @param p_pwm_module specified PWM module
+ * @param freq switching frequency of pwm signal [Hz]
+ * @param sync_mode synchronization mode [`PWM_Sync_Master`/`PWM_Sync_Slave`]
+ * @param phase_degrees phase between modules[º]
+ * @param freq_sampling HRADC sampling frequency [Hz]
+ * @return `STATUS_SUCCESS`, or `STATUS_FAIL` if sampling isn't aligned
+ */
+uint16_t cfg_pwm_double_update(volatile struct EPWM_REGS *p_pwm_module,
+                               double freq, pwm_sync_t sync_mode,
+                               uint16_t phase_degrees, double freq_sampling)
+{
+    uint16_t period, period_sampling, phase;
+
+    period = ((double) C28_FREQ_MHZ * (double) 1E6) / (2.0 * freq);
+    period_sampling = ((double) C28_FREQ_MHZ * (double) 1E6) / freq_sampling;
+
+    if( (period_sampling == 0) || (period % period_sampling) )
+    {
+        return STATUS_FAIL;
+    }
+
+    /* Counter-register configuration */
+    p_pwm_module->TBCTL.bit.CTRMODE = TB_COUNT_UPDOWN;
+    p_pwm_module->TBPRD = period;
+    p_pwm_module->TBCTR = 0;
+
+    /**
+     * Phase is given in counter units within triangular carrier, which is
+     * mirrored on the second half of switching period
+     */
+    if(sync_mode == PWM_Sync_Slave)
+    {
+        if(phase_degrees <= 180)
+        {
+            phase = (float) phase_degrees * ((float) period / 180.0);
+            p_pwm_module->TBCTL.bit.PHSDIR = TB_DOWN;
+        }
+        else
+        {
+            phase = (360.0 - (float) phase_degrees) * ((float) period / 180.0);
+            p_pwm_module->TBCTL.bit.PHSDIR = TB_UP;
+        }
+
+        p_pwm_module->TBPHS.half.TBPHS = phase;
+    }
+
+    set_pwm_duty_chA(p_pwm_module, 0.0);
+    set_pwm_duty_chB(p_pwm_module, 0.0);
+
+    /* Action-Qualifier configuration: output is set while CTR < CMP */
+    p_pwm_module->AQCTLA.bit.ZRO = AQ_NO_ACTION;
+    p_pwm_module->AQCTLA.bit.CAU = AQ_CLEAR;
+    p_pwm_module->AQCTLA.bit.CAD = AQ_SET;
+
+    p_pwm_module->AQCTLB.bit.ZRO = AQ_NO_ACTION;
+    p_pwm_module->AQCTLB.bit.CBU = AQ_CLEAR;
+    p_pwm_module->AQCTLB.bit.CBD = AQ_SET;
+
+    /* Compare registers configuration */
+    p_pwm_module->CMPCTL.bit.LOADAMODE = CC_CTR_ZERO_PRD;
+    p_pwm_module->CMPCTL.bit.LOADBMODE = CC_CTR_ZERO_PRD;
+
+    /* Interruption configuration */
+    p_pwm_module->ETSEL.bit.INTSEL = ET_CTR_PRDZERO;
+
+    EALLOW;
+
+    /* High-resolution feature configuration for up-down counter */
+    p_pwm_module->HRCNFG.bit.EDGMODE = HR_BEP;
+    p_pwm_module->HRCNFG.bit.EDGMODEB = HR_BEP;
+    p_pwm_module->HRPCTL.bit.HRPE = 1;
+
+    EDIS;
+
+    return STATUS_SUCCESS;
+}
+
 /**
  * Enable outputs from specified PWM module.
  *
@@ -32,6 +32,24 @@
 
 #define NUM_MAX_PWM_MODULES   8
 
+/**
+ * Elapsed TBCLK cycles since last zero or period event of specified PWM
+ * module, according to its current count direction. Used to profile ISR's
+ * triggered by these events.
+ */
+#define GET_PWM_ELAPSED_CYCLES(p_pwm)   ( (p_pwm)->TBSTS.bit.CTRDIR ?       \
+                                          (p_pwm)->TBCTR :                  \
+                                          (p_pwm)->TBPRD - (p_pwm)->TBCTR )
+
+/**
+ * PWM module whose EPWMx_INT is being serviced, given by address of PIE vector
+ * fetched by CPU (PIEVECT holds bits 15:1 of that address, and each vector
+ * takes 2 words). Used by ISR's shared by several EPWMx_INT vectors, which
+ * must read it before re-enabling interrupts.
+ */
+#define GET_PWM_ISR_MODULE  ePWM[PieCtrlRegs.PIECTRL.bit.PIEVECT -                \
+                                 (((uint16_t) &PieVectTable.EPWM1_INT) >> 1) + 1]
+
 typedef enum {
         PWM_Sync_Master,
         PWM_Sync_Slave
@@ -85,6 +103,10 @@ extern void init_pwm_module(volatile struct EPWM_REGS *p_pwm_module,
                             double freq, uint16_t primary_module,
                             pwm_sync_t sync_mode, uint16_t phase_degrees,
                             cfg_pwm_channel_b_t cfg_channel_b, uint16_t deadtime);
+extern uint16_t cfg_pwm_double_update(volatile struct EPWM_REGS *p_pwm_module,
+                                      double freq, pwm_sync_t sync_mode,
+                                      uint16_t phase_degrees,
+                                      double freq_sampling);
 
 extern void enable_pwm_output(uint16_t pwm_module);
 extern void disable_pwm_output(uint16_t pwm_module);
@@ -20,7 +20,14 @@
  *
  */
 
+#include "boards/udc_c28.h"
 #include "scope/scope.h"
+#include "signals/signals.h"
+
+/// Source used when no signal was registered by power supply model
+static float scope_null_source = 0.0;
+
+static void record_sync_scope(scope_t *p_scp, scope_sync_t *p_sync);
 
 void init_scope(scope_t *p_scp, float freq_base, float freq_sampling,
                 float *p_buf_start, uint16_t size, float *p_source,
@@ -33,13 +40,52 @@ void init_scope(scope_t *p_scp, float freq_base, float freq_sampling,
     init_timeslicer(&p_scp->timeslicer, freq_base);
     cfg_freq_scope(p_scp, freq_sampling);
 
+    /// Source address from parameter bank is only accepted if it belongs to
+    /// signals registry. Otherwise, scope falls back to first signal.
+    p_scp->source_id = find_signal(p_source);
+
+    if(p_scp->source_id == SIGNAL_ID_INVALID)
+    {
+        p_scp->source_id = 0;
+        p_source = (float *) get_signal(0);
+    }
+
+    if(p_source == 0)
+    {
+        p_source = &scope_null_source;
+    }
+
     p_scp->p_source = p_source;
     p_scp->p_run_scope = p_run_scope;
+
+    p_scp->counter_ticks = 0;
+    p_scp->sync_last.counter_sync_pulse = 0;
+    record_sync_scope(p_scp, &p_scp->sync_last);
+    record_sync_scope(p_scp, &p_scp->sync_start);
 }
 
-void cfg_source_scope(scope_t *p_scp, float *p_source)
+/**
+ * Configure scope source from signals registry.
+ *
+ * @param p_scp pointer to scope
+ * @param source_id ID from signals registry
+ * @return 1 if successful, 0 if ID is invalid (current source is kept)
+ */
+uint16_t cfg_source_scope(scope_t *p_scp, uint16_t source_id)
 {
-    p_scp->p_source = p_source;
+    volatile float *p_source;
+
+    p_source = get_signal(source_id);
+
+    if(p_source == 0)
+    {
+        return 0;
+    }
+
+    p_scp->source_id = source_id;
+    p_scp->p_source = (float *) p_source;
+
+    return 1;
 }
 
 void cfg_freq_scope(scope_t *p_scp, float freq_sampling)
@@ -59,6 +105,7 @@ void cfg_duration_scope(scope_t *p_scp, float duration)
 void enable_scope(scope_t *p_scp)
 {
     enable_buffer(&p_scp->buffer);
+    record_sync_scope(p_scp, &p_scp->sync_start);
 }
 
 void disable_scope(scope_t *p_scp)
@@ -66,9 +113,33 @@ void disable_scope(scope_t *p_scp)
     disable_buffer(&p_scp->buffer);
 }
 
+/**
+ * Reset scope buffer. It must be called from background loop: buffer is
+ * disabled before being cleared, so clearing may be preempted by scope ISR, and
+ * only time reference is recorded with interrupts disabled.
+ *
+ * @param p_scp pointer to scope
+ */
 void reset_scope(scope_t *p_scp)
 {
     reset_buffer(&p_scp->buffer);
+
+    DINT;
+    record_sync_scope(p_scp, &p_scp->sync_start);
+    EINT;
+}
+
+/**
+ * Record time reference of scope at sync pulse. It must be called by sync
+ * pulse ISR, after updating its counter.
+ *
+ * @param p_scp pointer to scope
+ * @param counter_sync_pulse current sync pulse counter
+ */
+void sync_scope(scope_t *p_scp, uint32_t counter_sync_pulse)
+{
+    p_scp->sync_last.counter_sync_pulse = counter_sync_pulse;
+    record_sync_scope(p_scp, &p_scp->sync_last);
 }
 
 void run_scope_shared_ram(scope_t *p_scp)
@@ -80,3 +151,18 @@ void run_scope_shared_ram(scope_t *p_scp)
 void run_scope_onboard_ram(scope_t *p_scp)
 {
 }
+
+/**
+ * Record current ticks and buffer index of scope. Sync pulse counter is taken
+ * from last sync pulse, so the offset from that pulse is given by the
+ * difference between ticks.
+ *
+ * @param p_scp pointer to scope
+ * @param p_sync pointer to time reference record
+ */
+static void record_sync_scope(scope_t *p_scp, scope_sync_t *p_sync)
+{
+    p_sync->counter_sync_pulse = p_scp->sync_last.counter_sync_pulse;
+    p_sync->counter_ticks = p_scp->counter_ticks;
+    p_sync->buffer_idx = idx_buffer(&p_scp->buffer);
+}
@@ -26,26 +26,48 @@
 #include <stdint.h>
 #include "common/structs.h"
 #include "common/timeslicer.h"
+#include "common/isr_phases.h"
 
 #define NUM_MAX_SCOPES      4
 
-#define RUN_SCOPE(scp)  RUN_TIMESLICER(scp.timeslicer)  \
+#define RUN_SCOPE(scp)  ISR_DEFERRED_PHASE_ONLY;        \
+                        scp.counter_ticks++;            \
+                        RUN_TIMESLICER(scp.timeslicer)  \
                             scp.p_run_scope(&scp);      \
                         END_TIMESLICER(scp.timeslicer)
 
+/**
+ * Time reference of scope buffer, composed by sync pulse counter, number of
+ * ticks of scope base frequency (usually, control ISR) and buffer index. They
+ * allow captures from different controllers to be aligned to the same control
+ * period.
+ */
+typedef volatile struct
+{
+    uint32_t        counter_sync_pulse;
+    uint32_t        counter_ticks;
+    uint16_t        buffer_idx;
+} scope_sync_t;
+
 typedef volatile struct scope_t scope_t;
 struct scope_t
 {
 
     buf_t           buffer;
     timeslicer_t    timeslicer;
+    uint32_t        counter_ticks;
+    scope_sync_t    sync_last;      // Recorded at last sync pulse
+    scope_sync_t    sync_start;     // Recorded at capture (re)start
     float           duration;
+    uint16_t        source_id;
     float           *p_source;
     void            (*p_run_scope)(scope_t *p_scp);
 };
 
 inline void run_scope(scope_t *p_scp)
 {
+    p_scp->counter_ticks++;
+
     /*********************************************/
     RUN_TIMESLICER(p_scp->timeslicer)
     /*********************************************/
@@ -58,12 +80,13 @@ inline void run_scope(scope_t *p_scp)
 extern void init_scope(scope_t *p_scp, float freq_base, float freq_sampling,
                        float *p_buf_start, uint16_t size, float *p_source,
                        void *p_run_scope);
-extern void cfg_source_scope(scope_t *p_scp,float *p_source);
+extern uint16_t cfg_source_scope(scope_t *p_scp, uint16_t source_id);
 extern void cfg_freq_scope(scope_t *p_scp, float freq_sampling);
 extern void cfg_duration_scope(scope_t *p_scp, float duration);
 extern void enable_scope(scope_t *p_scp);
 extern void disable_scope(scope_t *p_scp);
 extern void reset_scope(scope_t *p_scp);
+extern void sync_scope(scope_t *p_scp, uint32_t counter_sync_pulse);
 extern void run_scope_shared_ram(scope_t *p_scp);
 
 #endif
@@ -25,12 +25,31 @@
 
 #include <math.h>
 #include <float.h>
+#include "common/fast_math.h"
 #include "siggen.h"
 
 #define _USE_MATH_DEFINES
 #define PI                  3.14159265358979323846
 #define NUM_ITE_EXP_APPROX  12
 
+#ifdef SIGGEN_USE_FAST_MATH
+/**
+ * Signal phase grows with sample counter, up to 2*pi*num_cycles (or 2*pi*freq
+ * for continuous operation), so fast_sinf() is only used within domain of its
+ * error bound (see common/fast_math.h), and RTS library is used beyond it
+ */
+#define SIGGEN_SIN_MAX_ARG  1.0e4
+#define SIGGEN_SIN(x)       siggen_sin(x)
+#define SIGGEN_EXP(x)       fast_expf(x)
+#define SIGGEN_ATAN(x)      fast_atanf(x)
+#define SIGGEN_EXP_RUN(x)   fast_expf(x)
+#else
+#define SIGGEN_SIN(x)       sin(x)
+#define SIGGEN_EXP(x)       exp(x)
+#define SIGGEN_ATAN(x)      atan(x)
+#define SIGGEN_EXP_RUN(x)   exp_approx(x)
+#endif
+
 const static float default_aux_param[NUM_SIGGEN_AUX_PARAM] = {0.0, 0.0, 0.0, 0.0};
 static float coeff_exp_approx;
 
@@ -47,6 +66,13 @@ static float coeff_exp_approx;
 static void update_siggen_freq(siggen_t *p_siggen);
 inline float exp_approx(float x);
 
+#ifdef SIGGEN_USE_FAST_MATH
+static inline float siggen_sin(float x)
+{
+    return (fabs(x) <= SIGGEN_SIN_MAX_ARG) ? fast_sinf(x) : sin(x);
+}
+#endif
+
 /**
  * Initialization of Signal Generator module. SigGen must be disabled.
  *
@@ -85,6 +111,7 @@ void cfg_siggen(siggen_t *p_siggen, siggen_type_t sig_type, uint16_t num_cycles,
                 float freq, float amplitude, float offset, float *p_aux_param)
 {
     uint16_t i;
+    float sine_peak;
 
     if(p_siggen->enable == 0)
     {
@@ -149,13 +176,13 @@ void cfg_siggen(siggen_t *p_siggen, siggen_type_t sig_type, uint16_t num_cycles,
                 /// Amplitude correction factor
                 p_siggen->aux_var[6] = 2.0 * PI * (p_siggen->freq);
 
-                p_siggen->aux_var[5] = atan( p_siggen->aux_var[6] *
-                                             p_siggen->aux_param[2] ) /
+                p_siggen->aux_var[5] = SIGGEN_ATAN( p_siggen->aux_var[6] *
+                                                    p_siggen->aux_param[2] ) /
                                        p_siggen->aux_var[6];
-                p_siggen->aux_var[4] = exp( p_siggen->aux_var[5] /
-                                            p_siggen->aux_param[2] ) /
-                                       sin( p_siggen->aux_var[6] *
-                                            p_siggen->aux_var[5] );
+                p_siggen->aux_var[4] = SIGGEN_EXP( p_siggen->aux_var[5] /
+                                                   p_siggen->aux_param[2] ) /
+                                       SIGGEN_SIN( p_siggen->aux_var[6] *
+                                                   p_siggen->aux_var[5] );
 
                 p_siggen->p_run_siggen = &run_siggen_dampedsine;
                 break;
@@ -208,13 +235,14 @@ void cfg_siggen(siggen_t *p_siggen, siggen_type_t sig_type, uint16_t num_cycles,
                 /// Amplitude correction factor
                 p_siggen->aux_var[6] = 2.0 * PI * (p_siggen->freq);
 
-                p_siggen->aux_var[5] = atan( 2.0 * p_siggen->aux_var[6] *
-                                             p_siggen->aux_param[2] ) /
+                p_siggen->aux_var[5] = SIGGEN_ATAN( 2.0 * p_siggen->aux_var[6] *
+                                                    p_siggen->aux_param[2] ) /
                                        p_siggen->aux_var[6];
-                p_siggen->aux_var[4] = exp( p_siggen->aux_var[5] /
-                                            p_siggen->aux_param[2] ) /
-                                       ( pow( sin( p_siggen->aux_var[6] *
-                                                   p_siggen->aux_var[5] ), 2) );
+                sine_peak = SIGGEN_SIN( p_siggen->aux_var[6] *
+                                        p_siggen->aux_var[5] );
+                p_siggen->aux_var[4] = SIGGEN_EXP( p_siggen->aux_var[5] /
+                                                   p_siggen->aux_param[2] ) /
+                                       ( sine_peak * sine_peak );
 
                 p_siggen->p_run_siggen = &run_siggen_dampedsquaredsine;
                 break;
@@ -344,9 +372,10 @@ void run_siggen_sine(siggen_t *p_siggen)
 {
 	if(p_siggen->enable)
 	{
-		*(p_siggen->p_out) = (p_siggen->amplitude) * sin( p_siggen->aux_var[0] *
-		                      p_siggen->n++ + p_siggen->aux_var[1]) +
-		                      p_siggen->offset;
+		*(p_siggen->p_out) = (p_siggen->amplitude) *
+		                     SIGGEN_SIN( p_siggen->aux_var[0] * p_siggen->n++ +
+		                                 p_siggen->aux_var[1]) +
+		                     p_siggen->offset;
 
 		if(p_siggen->aux_var[2] >  0)
 		{
@@ -386,9 +415,10 @@ void run_siggen_dampedsine(siggen_t *p_siggen)
 		if(p_siggen->n < p_siggen->aux_var[2])
 		{
 			*(p_siggen->p_out) = p_siggen->amplitude * p_siggen->aux_var[4] *
-			                     exp_approx(p_siggen->aux_var[3] * p_siggen->n) *
-			                     sin( p_siggen->aux_var[0] * p_siggen->n +
-			                     p_siggen->aux_var[1] ) + p_siggen->offset;
+			                     SIGGEN_EXP_RUN(p_siggen->aux_var[3] * p_siggen->n) *
+			                     SIGGEN_SIN( p_siggen->aux_var[0] * p_siggen->n +
+			                                 p_siggen->aux_var[1] ) +
+			                     p_siggen->offset;
 
 			p_siggen->n++;
 		}
@@ -454,11 +484,11 @@ void run_siggen_dampedsquaredsine(siggen_t *p_siggen)
     {
         if(p_siggen->n < p_siggen->aux_var[2])
         {
-            aux_sine = sin( p_siggen->aux_var[0] * p_siggen->n +
-                        p_siggen->aux_var[1] );
+            aux_sine = SIGGEN_SIN( p_siggen->aux_var[0] * p_siggen->n +
+                                   p_siggen->aux_var[1] );
 
             *(p_siggen->p_out) = p_siggen->amplitude * p_siggen->aux_var[4] *
-                                 exp_approx(p_siggen->aux_var[3] * p_siggen->n) *
+                                 SIGGEN_EXP_RUN(p_siggen->aux_var[3] * p_siggen->n) *
                                  aux_sine * aux_sine + p_siggen->offset;
 
             p_siggen->n++;
@@ -481,7 +511,8 @@ void run_siggen_square(siggen_t *p_siggen)
 
     if(p_siggen->enable)
     {
-        temp = sin( p_siggen->aux_var[0] * p_siggen->n++ + p_siggen->aux_var[1] );
+        temp = SIGGEN_SIN( p_siggen->aux_var[0] * p_siggen->n++ +
+                           p_siggen->aux_var[1] );
 
         if(temp < 0)
         {
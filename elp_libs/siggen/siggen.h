@@ -33,6 +33,13 @@
 
 #include <stdint.h>
 
+/**
+ * Uncomment to select fast math library (common/fast_math.h) instead of RTS
+ * library for signal calculation and configuration. See common/fast_math.h
+ * for error bounds. Sine phases beyond |x| <= 1e4 still use RTS library.
+ */
+//#define SIGGEN_USE_FAST_MATH
+
 #define NUM_SIGGEN_AUX_PARAM    4
 #define NUM_SIGGEN_AUX_VAR      8
 
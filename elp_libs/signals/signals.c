@@ -0,0 +1,160 @@
+/******************************************************************************
+ * Copyright (C) 2026 by LNLS - Brazilian Synchrotron Light Laboratory
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. LNLS and
+ * the Brazilian Center for Research in Energy and Materials (CNPEM) are not
+ * liable for any misuse of this material.
+ *
+ *****************************************************************************/
+
+/**
+ * @file signals.c
+ * @brief Signals registry module
+ *
+ * Registry is filled by each power supply model during init_controller(), and
+ * it's not modified afterwards.
+ *
+ * @date 18/10/2026
+ *
+ */
+
+#include "HRADC_board/HRADC_Boards.h"
+#include "signals/signals.h"
+
+#pragma DATA_SECTION(g_signals,"SHARERAMS1_1");
+
+volatile signals_registry_t g_signals;
+
+static volatile float *p_signals[NUM_MAX_SIGNALS];
+
+void init_signals(void)
+{
+    uint16_t i, j;
+
+    g_signals.num_signals = 0;
+
+    for(i = 0; i < NUM_MAX_SIGNALS; i++)
+    {
+        g_signals.signal[i].type = is_float;
+        g_signals.signal[i].unit = Unit_None;
+
+        for(j = 0; j < SIZE_SIGNAL_NAME/2; j++)
+        {
+            g_signals.signal[i].name[j] = 0;
+        }
+
+        p_signals[i] = 0;
+    }
+}
+
+/**
+ * Register new signal. If signal address was already registered, its current
+ * ID is returned.
+ *
+ * @param name null-terminated string, truncated to SIZE_SIGNAL_NAME chars
+ * @param type signal type
+ * @param unit signal unit
+ * @param p_signal pointer to signal
+ * @return signal ID, or SIGNAL_ID_INVALID if registry is full
+ */
+uint16_t register_signal(const char *name, param_type_t type,
+                         signal_unit_t unit, volatile void *p_signal)
+{
+    uint16_t id, i;
+
+    id = find_signal((volatile float *) p_signal);
+
+    if( (id != SIGNAL_ID_INVALID) || (p_signal == 0) )
+    {
+        return id;
+    }
+
+    if(g_signals.num_signals >= NUM_MAX_SIGNALS)
+    {
+        return SIGNAL_ID_INVALID;
+    }
+
+    id = g_signals.num_signals;
+
+    for(i = 0; (i < SIZE_SIGNAL_NAME) && (name[i] != '\0'); i++)
+    {
+        if(i & 0x1)
+        {
+            g_signals.signal[id].name[i >> 1] |= ((uint16_t) name[i] & 0xFF) << 8;
+        }
+        else
+        {
+            g_signals.signal[id].name[i >> 1] = (uint16_t) name[i] & 0xFF;
+        }
+    }
+
+    g_signals.signal[id].type = type;
+    g_signals.signal[id].unit = unit;
+    p_signals[id] = (volatile float *) p_signal;
+
+    /// Number of signals is written last, so ARM only sees complete entries
+    g_signals.num_signals++;
+
+    return id;
+}
+
+/**
+ * Register latest raw sample from each HRADC board, as HRADCx_RAW. DMA fills
+ * each board buffer every control period, so latest sample is the last slot.
+ * Must be called after Init_HRADC_Info(), which sets buffer size.
+ *
+ * @param num_hradc number of HRADC boards
+ */
+void register_hradc_signals(uint16_t num_hradc)
+{
+    uint16_t i, last;
+    char name[] = "HRADC0_RAW";
+
+    for(i = 0; (i < num_hradc) && (i < 4); i++)
+    {
+        name[5] = '0' + i;
+        last = HRADCs_Info.HRADC_boards[i].size_SamplesBuffer - 1;
+        register_signal(name, is_uint32_t, Unit_None, &buffers_HRADC[i][last]);
+    }
+}
+
+/**
+ * Get pointer to registered float signal. Raw signals (such as HRADCx_RAW)
+ * are only listed to ARM, as their words are not valid floats.
+ *
+ * @param id signal ID
+ * @return pointer to signal, or null pointer if ID is invalid or not float
+ */
+volatile float *get_signal(uint16_t id)
+{
+    if( (id >= g_signals.num_signals) ||
+        (g_signals.signal[id].type != is_float) )
+    {
+        return 0;
+    }
+
+    return p_signals[id];
+}
+
+/**
+ * Search registry for float signal address.
+ *
+ * @param p_signal pointer to signal
+ * @return signal ID, or SIGNAL_ID_INVALID if not registered as float
+ */
+uint16_t find_signal(volatile float *p_signal)
+{
+    uint16_t id;
+
+    for(id = 0; id < g_signals.num_signals; id++)
+    {
+        if( (p_signals[id] == p_signal) &&
+            (g_signals.signal[id].type == is_float) )
+        {
+            return id;
+        }
+    }
+
+    return SIGNAL_ID_INVALID;
+}
@@ -0,0 +1,81 @@
+/******************************************************************************
+ * Copyright (C) 2026 by LNLS - Brazilian Synchrotron Light Laboratory
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. LNLS and
+ * the Brazilian Center for Research in Energy and Materials (CNPEM) are not
+ * liable for any misuse of this material.
+ *
+ *****************************************************************************/
+
+/**
+ * @file signals.h
+ * @brief Signals registry module
+ *
+ * This module implements a registry of observable signals from the active
+ * power supply model. Each signal is identified by an ID, which is its index
+ * on registry, and described by name, type and unit. Description is exported
+ * on shared RAM, so ARM can list available signals, while signal pointers are
+ * kept private on C28. Registry takes 1 + 18*NUM_MAX_SIGNALS words from
+ * RAMS1_1 (865 words, shared with HRADCs_Info and g_ipc_latency). This way,
+ * modules such as scopes select their sources by ID, and invalid addresses
+ * are never dereferenced.
+ *
+ * @date 18/10/2026
+ *
+ */
+
+#ifndef SIGNALS_H_
+#define SIGNALS_H_
+
+#include <stdint.h>
+#include "parameters/parameters.h"
+
+#define NUM_MAX_SIGNALS     48
+#define SIZE_SIGNAL_NAME    32          // Max number of chars, packed 2 per word
+#define SIGNAL_ID_INVALID   0xFFFF
+
+/**
+ * Register signal using its macro name from power supply model
+ */
+#define REGISTER_SIGNAL(sig, type, unit)    \
+    register_signal(#sig, type, unit, &(sig))
+
+/**
+ * Register integrator state from PI controller, named after its macro
+ */
+#define REGISTER_DSP_PI_INTEGRATOR(pi, unit)    \
+    register_signal(#pi "_INT", is_float, unit, &((pi)->u_int))
+
+typedef enum
+{
+    Unit_None,
+    Unit_Ampere,
+    Unit_Volt,
+    Unit_Duty,
+    Unit_Celsius
+} signal_unit_t;
+
+typedef volatile struct
+{
+    param_type_t    type;
+    signal_unit_t   unit;
+    uint16_t        name[SIZE_SIGNAL_NAME/2];
+} signal_info_t;
+
+typedef volatile struct
+{
+    uint16_t        num_signals;
+    signal_info_t   signal[NUM_MAX_SIGNALS];
+} signals_registry_t;
+
+extern volatile signals_registry_t g_signals;
+
+extern void init_signals(void);
+extern uint16_t register_signal(const char *name, param_type_t type,
+                                signal_unit_t unit, volatile void *p_signal);
+extern void register_hradc_signals(uint16_t num_hradc);
+extern volatile float *get_signal(uint16_t id);
+extern uint16_t find_signal(volatile float *p_signal);
+
+#endif /* SIGNALS_H_ */
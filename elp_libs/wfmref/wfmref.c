@@ -18,125 +18,169 @@
  * @date 22 de nov de 2017
  *
  */
-#include <math.h>
+#include "boards/udc_c28.h"
 #include "wfmref.h"
 
-#pragma DATA_SECTION(g_wfmref_data,"SHARERAMS2345");
-volatile u_wfmref_data_t g_wfmref_data;
+#define WFMREF_STARTED              0
+#define WFMREF_START_SYNC           1
+#define WFMREF_START_DELAYED        2
+#define WFMREF_START_SYNC_XINT2     3
+
+#define RESET_WFMREF_LERP(lerp)     (lerp).phase = 0;       \
+                                    (lerp).saturated = 0;   \
+                                    (lerp).start_status = WFMREF_STARTED
+
+#define XINT2_CTR_TO_SECONDS        (1.0 / (C28_FREQ_MHZ * 1000000.0))
+#define XINT2_CTR_MIN_FREQ          (C28_FREQ_MHZ * 1000000.0 / 65536.0)
+
+#pragma DATA_SECTION(g_wfmref_library,"SHARERAMS2345");
+volatile wfmref_library_t g_wfmref_library;
+
+/**
+ * Committed curve descriptors, validated from library. Curves are only played
+ * from this copy, so ARM may freely change library descriptors between
+ * commits. Invalid curves have length 0. Each descriptor is replaced as a
+ * whole, with interrupts disabled, so it's never seen partially updated.
+ */
+static wfmref_curve_t wfmref_curves[NUM_WFMREF_CURVES] = {0};
 
 #pragma CODE_SECTION(sync_wfmref,"ramfuncs");
 #pragma CODE_SECTION(run_wfmref,"ramfuncs");
+#pragma CODE_SECTION(switch_wfmref_curve,"ramfuncs");
+#pragma CODE_SECTION(start_wfmref_lerp,"ramfuncs");
+#pragma CODE_SECTION(float_to_q32,"ramfuncs");
+
+static uint16_t validate_wfmref_curve(uint16_t curve, wfmref_curve_t *p_curve);
+static void switch_wfmref_curve(wfmref_t *p_wfmref, wfmref_t *p_wfmref_new);
+static void set_wfmref_lerp_step(wfmref_lerp_t *p_lerp);
+static uint16_t start_wfmref_lerp(wfmref_t *p_wfmref);
+static uint32_t float_to_q32(float frac);
 
 void init_wfmref(wfmref_t *p_wfmref, uint16_t wfmref_selected,
                  sync_mode_t sync_mode, float freq_lerp, float freq_wfmref,
-                 float gain, float offset, float *p_start, uint16_t size,
-                 float *p_out)
+                 float gain, float offset, float *p_out)
 {
-    uint16_t i;
-
     p_wfmref->wfmref_selected = wfmref_selected;
     p_wfmref->sync_mode = sync_mode;
     p_wfmref->gain = gain;
     p_wfmref->offset = offset;
+    p_wfmref->start_delay = 0.0;
     p_wfmref->p_out = p_out;
 
-    for(i = 0; i < NUM_WFMREF_CURVES; i++)
+    p_wfmref->wfmref_data.status = Disabled;
+    p_wfmref->wfmref_data.p_buf_start = &g_wfmref_library.pool[0];
+    p_wfmref->wfmref_data.p_buf_end = &g_wfmref_library.pool[0];
+
+    /**
+     * Load initial curve, if it's valid, but keep waveform stopped until
+     * power supply enters RmpWfm or MigWfm mode. Interrupts aren't enabled
+     * yet, so curve is committed directly.
+     */
+    if( (wfmref_selected < NUM_WFMREF_CURVES) &&
+        validate_wfmref_curve(wfmref_selected, &wfmref_curves[wfmref_selected]) )
     {
-        init_buffer(&p_wfmref->wfmref_data[i], p_start + i * size, size);
-        p_wfmref->wfmref_data[i].p_buf_idx   = p_wfmref->wfmref_data[i].p_buf_end + 1;
+        switch_wfmref_curve(p_wfmref, p_wfmref);
     }
 
-    p_wfmref->lerp.counter = 0;
-    p_wfmref->lerp.max_count = (uint16_t) roundf(freq_lerp / freq_wfmref);
+    p_wfmref->wfmref_data.p_buf_idx = p_wfmref->wfmref_data.p_buf_end + 1;
+
     p_wfmref->lerp.freq_lerp = freq_lerp;
     p_wfmref->lerp.freq_base = freq_wfmref;
-
-    /**
-     * TODO: Due to the FPUFastRTS library, some accuracy has been lost in the
-     * direct form of this calculating. This inverse of the division showed
-     * better results.
-     */
-    ///p_wfmref->lerp.inv_decimation = freq_wfmref / freq_lerp;
-    p_wfmref->lerp.inv_decimation = 1.0/(roundf(freq_lerp/freq_wfmref));
+    set_wfmref_lerp_step(&p_wfmref->lerp);
+    RESET_WFMREF_LERP(p_wfmref->lerp);
     p_wfmref->lerp.out = 0.0;
 }
 
+/**
+ * Configure waveform reference with parameters from ARM. It must be called
+ * from background loop: interpolation step is calculated into a local copy,
+ * with interrupts enabled, and all parameters are committed with interrupts
+ * disabled.
+ *
+ * @param p_wfmref pointer to CtoM waveform reference
+ * @param p_wfmref_new pointer to MtoC waveform reference
+ */
 void cfg_wfmref(wfmref_t *p_wfmref, wfmref_t *p_wfmref_new)
 {
-    uint16_t i;
+    wfmref_lerp_t lerp;
+
+    lerp.freq_lerp = p_wfmref->lerp.freq_lerp;
+    lerp.freq_base = p_wfmref_new->lerp.freq_base;
+    set_wfmref_lerp_step(&lerp);
+
+    DINT;
 
-    p_wfmref->wfmref_selected = p_wfmref_new->wfmref_selected;
     p_wfmref->sync_mode = p_wfmref_new->sync_mode;
     p_wfmref->gain = p_wfmref_new->gain;
     p_wfmref->offset = p_wfmref_new->offset;
 
-    p_wfmref->lerp.counter = 0;
-    p_wfmref->lerp.freq_base = p_wfmref_new->lerp.freq_base;
-    p_wfmref->lerp.max_count = (uint16_t) roundf(p_wfmref->lerp.freq_lerp /
-                                                 p_wfmref_new->lerp.freq_base);
+    p_wfmref->start_delay = p_wfmref_new->start_delay;
+    p_wfmref->lerp.freq_base = lerp.freq_base;
+    p_wfmref->lerp.step_int = lerp.step_int;
+    p_wfmref->lerp.step_frac = lerp.step_frac;
+    RESET_WFMREF_LERP(p_wfmref->lerp);
 
-    /**
-     * TODO: Due to the FPUFastRTS library, some accuracy has been lost in the
-     * direct form of this calculating. This inverse of the division showed
-     * better results.
-     */
-    ///p_wfmref->lerp.inv_decimation = freq_wfmref / freq_lerp;
-    p_wfmref->lerp.inv_decimation = 1.0/(roundf(p_wfmref->lerp.freq_lerp /
-                                                p_wfmref_new->lerp.freq_base));
+    EINT;
 }
 
 void reset_wfmref(wfmref_t *p_wfmref)
 {
-    static uint16_t i;
-
-    for(i = 0; i < NUM_WFMREF_CURVES; i++)
-    {
-        p_wfmref->wfmref_data[i].p_buf_idx = p_wfmref->wfmref_data[i].p_buf_end + 1;
-    }
-
-    p_wfmref->lerp.counter = 0;
-    //p_wfmref->lerp.out = *(p_wfmref->wfmref_data[p_wfmref->wfmref_selected].p_buf_end);
+    p_wfmref->wfmref_data.p_buf_idx = p_wfmref->wfmref_data.p_buf_end + 1;
+    RESET_WFMREF_LERP(p_wfmref->lerp);
 }
 
-void update_wfmref(wfmref_t *p_wfmref, wfmref_t *p_wfmref_new)
+/**
+ * Commit library curve selected by ARM, which is played after the end of the
+ * current one. Since its checksum is verified, execution time is proportional
+ * to curve length, so it must not be called from ISR's. Curve is validated
+ * into a temporary descriptor, with interrupts enabled, and only the final
+ * copy is done with interrupts disabled. Invalid curves are committed with
+ * length 0.
+ *
+ * @param p_wfmref pointer to CtoM waveform reference
+ * @param p_wfmref_new pointer to MtoC waveform reference
+ * @return 1 if selected curve is valid, 0 otherwise
+ */
+uint16_t update_wfmref(wfmref_t *p_wfmref, wfmref_t *p_wfmref_new)
 {
-    static uint16_t i;
+    uint16_t curve, valid;
+    wfmref_curve_t curve_new;
+
+    curve = p_wfmref_new->wfmref_selected;
 
-    for(i = 0; i < NUM_WFMREF_CURVES; i++)
+    if(curve >= NUM_WFMREF_CURVES)
     {
-        p_wfmref->wfmref_data[i] = p_wfmref_new->wfmref_data[i];
+        return 0;
     }
 
-    p_wfmref->wfmref_selected   = p_wfmref_new->wfmref_selected;
-    p_wfmref->gain              = p_wfmref_new->gain;
-    p_wfmref->offset            = p_wfmref_new->offset;
-    p_wfmref->sync_mode         = p_wfmref_new->sync_mode;
-}
+    valid = validate_wfmref_curve(curve, &curve_new);
 
-void sync_wfmref(wfmref_t *p_wfmref, wfmref_t *p_wfmref_new)
-{
-    static uint16_t sel;
+    DINT;
+    wfmref_curves[curve] = curve_new;
+    EINT;
 
-    sel = p_wfmref->wfmref_selected;
+    return valid;
+}
 
+/**
+ * Advance waveform at sync pulse, and schedule its alignment to pulse edge on
+ * next run_wfmref().
+ *
+ * @param p_wfmref pointer to CtoM waveform reference
+ * @param p_wfmref_new pointer to MtoC waveform reference
+ * @param sync_source interrupt which triggered sync pulse ISR
+ */
+void sync_wfmref(wfmref_t *p_wfmref, wfmref_t *p_wfmref_new,
+                 sync_source_t sync_source)
+{
     switch(p_wfmref->sync_mode)
     {
         case SampleBySample:
         {
-            if(p_wfmref->wfmref_data[sel].p_buf_idx++ >=
-               p_wfmref->wfmref_data[sel].p_buf_end)
+            if(p_wfmref->wfmref_data.p_buf_idx++ >=
+               p_wfmref->wfmref_data.p_buf_end)
             {
-                p_wfmref->wfmref_selected = p_wfmref_new->wfmref_selected;
-                sel = p_wfmref->wfmref_selected;
-
-                p_wfmref->wfmref_data[sel] = p_wfmref_new->wfmref_data[sel];
-
-                p_wfmref->wfmref_data[sel].p_buf_idx =
-                                    p_wfmref->wfmref_data[sel].p_buf_start;
-
-                p_wfmref->gain = p_wfmref_new->gain;
-                p_wfmref->offset = p_wfmref_new->offset;
-                p_wfmref->sync_mode = p_wfmref_new->sync_mode;
+                switch_wfmref_curve(p_wfmref, p_wfmref_new);
             }
 
             break;
@@ -144,30 +188,16 @@ void sync_wfmref(wfmref_t *p_wfmref, wfmref_t *p_wfmref_new)
 
         case SampleBySample_OneCycle:
         {
-            if(p_wfmref->wfmref_data[sel].p_buf_idx++ ==
-               p_wfmref->wfmref_data[sel].p_buf_end)
+            if(p_wfmref->wfmref_data.p_buf_idx++ ==
+               p_wfmref->wfmref_data.p_buf_end)
             {
-                p_wfmref->wfmref_data[sel].p_buf_idx =
-                        p_wfmref->wfmref_data[sel].p_buf_end;
+                p_wfmref->wfmref_data.p_buf_idx =
+                        p_wfmref->wfmref_data.p_buf_end;
             }
-            else if(p_wfmref->wfmref_data[sel].p_buf_idx >
-                    p_wfmref->wfmref_data[sel].p_buf_end)
+            else if(p_wfmref->wfmref_data.p_buf_idx >
+                    p_wfmref->wfmref_data.p_buf_end)
             {
-                p_wfmref->wfmref_selected = p_wfmref_new->wfmref_selected;
-                sel = p_wfmref->wfmref_selected;
-
-                p_wfmref->wfmref_data[sel] = p_wfmref_new->wfmref_data[sel];
-
-                p_wfmref->wfmref_data[sel].p_buf_idx =
-                                    p_wfmref->wfmref_data[sel].p_buf_start;
-
-                p_wfmref->gain = p_wfmref_new->gain;
-                p_wfmref->offset = p_wfmref_new->offset;
-                p_wfmref->sync_mode = p_wfmref_new->sync_mode;
-            }
-            else
-            {
-                //p_wfmref->wfmref_data[sel].p_buf_idx++;
+                switch_wfmref_curve(p_wfmref, p_wfmref_new);
             }
 
             break;
@@ -175,62 +205,80 @@ void sync_wfmref(wfmref_t *p_wfmref, wfmref_t *p_wfmref_new)
 
         case OneShot:
         {
-            p_wfmref->wfmref_selected = p_wfmref_new->wfmref_selected;
-            sel = p_wfmref->wfmref_selected;
-
-            p_wfmref->wfmref_data[sel] = p_wfmref_new->wfmref_data[sel];
-
-            p_wfmref->wfmref_data[sel].p_buf_idx =
-                                    p_wfmref->wfmref_data[sel].p_buf_start;
-
-            p_wfmref->gain = p_wfmref_new->gain;
-            p_wfmref->offset = p_wfmref_new->offset;
-            p_wfmref->sync_mode = p_wfmref_new->sync_mode;
-
+            switch_wfmref_curve(p_wfmref, p_wfmref_new);
             break;
         }
     }
 
-    p_wfmref->lerp.counter = 0;
+    RESET_WFMREF_LERP(p_wfmref->lerp);
+
+    if(sync_source == SyncPulse_XINT2)
+    {
+        p_wfmref->lerp.start_status = WFMREF_START_SYNC_XINT2;
+    }
+    else
+    {
+        p_wfmref->lerp.start_status = WFMREF_START_SYNC;
+    }
 }
 
 void run_wfmref(wfmref_t *p_wfmref)
 {
-    static uint16_t sel;
+    uint32_t phase;
+    uint16_t advance;
 
-    sel = p_wfmref->wfmref_selected;
+    if(p_wfmref->lerp.start_status != WFMREF_STARTED)
+    {
+        if(!start_wfmref_lerp(p_wfmref))
+        {
+            return;
+        }
+    }
 
     switch(p_wfmref->sync_mode)
     {
         case SampleBySample:
         case SampleBySample_OneCycle:
         {
-            if(p_wfmref->wfmref_data[sel].p_buf_idx <
-               p_wfmref->wfmref_data[sel].p_buf_end)
+            if(p_wfmref->wfmref_data.p_buf_idx <
+               p_wfmref->wfmref_data.p_buf_end)
             {
-                if(p_wfmref->lerp.counter < p_wfmref->lerp.max_count)
+                /**
+                 * Sample advance is given by sync pulses, so interpolation
+                 * holds next sample if it's reached before next pulse
+                 */
+                if(!p_wfmref->lerp.saturated)
                 {
-                    p_wfmref->lerp.fraction = p_wfmref->lerp.inv_decimation *
-                                              p_wfmref->lerp.counter++;
+                    phase = p_wfmref->lerp.phase;
+
+                    p_wfmref->lerp.fraction = (float) phase * Q32_TO_FLOAT;
 
                     p_wfmref->lerp.out =
-                         INTERPOLATE( *(p_wfmref->wfmref_data[sel].p_buf_idx),
-                                      *(p_wfmref->wfmref_data[sel].p_buf_idx+1),
+                         INTERPOLATE( *(p_wfmref->wfmref_data.p_buf_idx),
+                                      *(p_wfmref->wfmref_data.p_buf_idx+1),
                                         p_wfmref->lerp.fraction);
+
+                    p_wfmref->lerp.phase = phase + p_wfmref->lerp.step_frac;
+
+                    if( (p_wfmref->lerp.phase < phase) ||
+                        (p_wfmref->lerp.step_int != 0) )
+                    {
+                        p_wfmref->lerp.saturated = 1;
+                    }
                 }
 
                 else
                 {
-                    p_wfmref->lerp.out = *(p_wfmref->wfmref_data[sel].p_buf_idx+1);
+                    p_wfmref->lerp.out = *(p_wfmref->wfmref_data.p_buf_idx+1);
                 }
 
                 *(p_wfmref->p_out) = p_wfmref->lerp.out * p_wfmref->gain + p_wfmref->offset;
             }
 
-            else if( p_wfmref->wfmref_data[sel].p_buf_idx ==
-                     p_wfmref->wfmref_data[sel].p_buf_end)
+            else if( p_wfmref->wfmref_data.p_buf_idx ==
+                     p_wfmref->wfmref_data.p_buf_end)
             {
-                p_wfmref->lerp.out = *(p_wfmref->wfmref_data[sel].p_buf_idx);
+                p_wfmref->lerp.out = *(p_wfmref->wfmref_data.p_buf_idx);
                 *(p_wfmref->p_out) = p_wfmref->lerp.out * p_wfmref->gain + p_wfmref->offset;
             }
 
@@ -239,33 +287,49 @@ void run_wfmref(wfmref_t *p_wfmref)
 
         case OneShot:
         {
-            if(p_wfmref->wfmref_data[sel].p_buf_idx <
-               p_wfmref->wfmref_data[sel].p_buf_end)
+            if(p_wfmref->wfmref_data.p_buf_idx <
+               p_wfmref->wfmref_data.p_buf_end)
             {
-                if(p_wfmref->lerp.counter < p_wfmref->lerp.max_count)
-                {
-                    p_wfmref->lerp.fraction = p_wfmref->lerp.inv_decimation *
-                                              p_wfmref->lerp.counter++;
+                phase = p_wfmref->lerp.phase;
 
-                    p_wfmref->lerp.out =
-                         INTERPOLATE( *(p_wfmref->wfmref_data[sel].p_buf_idx),
-                                      *(p_wfmref->wfmref_data[sel].p_buf_idx+1),
-                                        p_wfmref->lerp.fraction);
+                p_wfmref->lerp.fraction = (float) phase * Q32_TO_FLOAT;
 
-                    if(p_wfmref->lerp.counter >= p_wfmref->lerp.max_count)
-                    {
-                        p_wfmref->lerp.counter = 0;
-                        p_wfmref->wfmref_data[sel].p_buf_idx++;
-                    }
+                p_wfmref->lerp.out =
+                     INTERPOLATE( *(p_wfmref->wfmref_data.p_buf_idx),
+                                  *(p_wfmref->wfmref_data.p_buf_idx+1),
+                                    p_wfmref->lerp.fraction);
+
+                /**
+                 * Advance integer part of step, plus one sample if phase
+                 * accumulator wraps around, limited to curve end
+                 */
+                p_wfmref->lerp.phase = phase + p_wfmref->lerp.step_frac;
+
+                advance = p_wfmref->lerp.step_int;
+
+                if(p_wfmref->lerp.phase < phase)
+                {
+                    advance++;
+                }
 
-                    *(p_wfmref->p_out) = p_wfmref->lerp.out * p_wfmref->gain + p_wfmref->offset;
+                if(advance > p_wfmref->wfmref_data.p_buf_end -
+                             p_wfmref->wfmref_data.p_buf_idx)
+                {
+                    p_wfmref->wfmref_data.p_buf_idx =
+                                            p_wfmref->wfmref_data.p_buf_end;
+                }
+                else
+                {
+                    p_wfmref->wfmref_data.p_buf_idx += advance;
                 }
+
+                *(p_wfmref->p_out) = p_wfmref->lerp.out * p_wfmref->gain + p_wfmref->offset;
             }
 
-            else if( p_wfmref->wfmref_data[sel].p_buf_idx ==
-                     p_wfmref->wfmref_data[sel].p_buf_end)
+            else if( p_wfmref->wfmref_data.p_buf_idx ==
+                     p_wfmref->wfmref_data.p_buf_end)
             {
-                p_wfmref->lerp.out = *(p_wfmref->wfmref_data[sel].p_buf_idx);
+                p_wfmref->lerp.out = *(p_wfmref->wfmref_data.p_buf_idx);
                 *(p_wfmref->p_out) = p_wfmref->lerp.out * p_wfmref->gain + p_wfmref->offset;
             }
 
@@ -281,3 +345,196 @@ void run_wfmref(wfmref_t *p_wfmref)
 
     //*(p_wfmref->p_out) = p_wfmref->lerp.out * p_wfmref->gain + p_wfmref->offset;
 }
+
+/**
+ * Validate curve from library and copy its descriptor to specified one. A
+ * curve is valid if it's not empty, it fits in the pool and its checksum
+ * matches. Otherwise, descriptor is written with length 0.
+ *
+ * @param curve library slot index, below NUM_WFMREF_CURVES
+ * @param p_curve pointer to descriptor which receives validated curve
+ * @return 1 if curve is valid, 0 otherwise
+ */
+static uint16_t validate_wfmref_curve(uint16_t curve, wfmref_curve_t *p_curve)
+{
+    uint16_t i, start, length;
+    uint32_t checksum;
+    volatile uint32_t *p_sample;
+
+    p_curve->start = 0;
+    p_curve->length = 0;
+    p_curve->checksum = 0;
+
+    start = g_wfmref_library.curve[curve].start;
+    length = g_wfmref_library.curve[curve].length;
+
+    if( (length == 0) || (start >= SIZE_WFMREF_POOL) ||
+        (length > SIZE_WFMREF_POOL - start) )
+    {
+        return 0;
+    }
+
+    checksum = 0;
+    p_sample = (volatile uint32_t *) &g_wfmref_library.pool[start];
+
+    for(i = 0; i < length; i++)
+    {
+        checksum += p_sample[i];
+    }
+
+    if(checksum != g_wfmref_library.curve[curve].checksum)
+    {
+        return 0;
+    }
+
+    p_curve->start = start;
+    p_curve->length = length;
+    p_curve->checksum = checksum;
+
+    return 1;
+}
+
+/**
+ * Switch to curve selected by ARM, restarting it. Only committed descriptors
+ * are used, so it takes constant time. If selected curve isn't valid,
+ * waveform is stopped and reference holds its last value.
+ *
+ * @param p_wfmref pointer to CtoM waveform reference
+ * @param p_wfmref_new pointer to MtoC waveform reference
+ */
+static void switch_wfmref_curve(wfmref_t *p_wfmref, wfmref_t *p_wfmref_new)
+{
+    uint16_t sel;
+
+    sel = p_wfmref_new->wfmref_selected;
+    p_wfmref->sync_mode = p_wfmref_new->sync_mode;
+
+    if( (sel >= NUM_WFMREF_CURVES) || (wfmref_curves[sel].length == 0) )
+    {
+        p_wfmref->wfmref_data.p_buf_idx = p_wfmref->wfmref_data.p_buf_end + 1;
+        return;
+    }
+
+    p_wfmref->wfmref_selected = sel;
+
+    p_wfmref->wfmref_data.p_buf_start =
+                            &g_wfmref_library.pool[wfmref_curves[sel].start];
+    p_wfmref->wfmref_data.p_buf_end = p_wfmref->wfmref_data.p_buf_start +
+                                      wfmref_curves[sel].length - 1;
+    p_wfmref->wfmref_data.p_buf_idx = p_wfmref->wfmref_data.p_buf_start;
+
+    p_wfmref->gain = p_wfmref_new->gain;
+    p_wfmref->offset = p_wfmref_new->offset;
+}
+
+/**
+ * Calculate phase accumulator step from waveform and interpolation
+ * frequencies.
+ *
+ * @param p_lerp pointer to interpolator
+ */
+static void set_wfmref_lerp_step(wfmref_lerp_t *p_lerp)
+{
+    float step;
+
+    step = p_lerp->freq_base / p_lerp->freq_lerp;
+
+    p_lerp->step_int = (uint16_t) step;
+    p_lerp->step_frac = float_to_q32(step - (float) p_lerp->step_int);
+}
+
+/**
+ * Align waveform to last sync pulse. At first run after the pulse, elapsed
+ * time since its edge is read from XINT2 counter, and waveform position is
+ * given by this time minus start delay. Counter is only used for pulses from
+ * XINT2, and if runs are frequent enough to read it before it wraps.
+ * Otherwise, elapsed time is taken as zero. Reference is held while position is
+ * negative, and it's incremented by phase step at each run. Then, its integer
+ * part advances curve index (only in OneShot mode, since sync pulses advance
+ * it on other modes), and its fractional part initializes phase accumulator.
+ *
+ * @param p_wfmref pointer to waveform reference
+ * @return 1 if waveform has started, 0 if it's still delayed
+ */
+static uint16_t start_wfmref_lerp(wfmref_t *p_wfmref)
+{
+    float elapsed;
+    uint16_t advance;
+
+    if( (p_wfmref->lerp.start_status == WFMREF_START_SYNC) ||
+        (p_wfmref->lerp.start_status == WFMREF_START_SYNC_XINT2) )
+    {
+        if( (p_wfmref->lerp.start_status == WFMREF_START_SYNC_XINT2) &&
+            (p_wfmref->lerp.freq_lerp > XINT2_CTR_MIN_FREQ) )
+        {
+            elapsed = (float) XIntruptRegs.XINT2CTR * XINT2_CTR_TO_SECONDS;
+        }
+        else
+        {
+            elapsed = 0.0;
+        }
+
+        p_wfmref->lerp.start_lead = (elapsed - p_wfmref->start_delay) *
+                                    p_wfmref->lerp.freq_base;
+        p_wfmref->lerp.start_status = WFMREF_START_DELAYED;
+    }
+    else
+    {
+        p_wfmref->lerp.start_lead += (float) p_wfmref->lerp.step_int +
+                                     (float) p_wfmref->lerp.step_frac *
+                                     Q32_TO_FLOAT;
+    }
+
+    if(p_wfmref->lerp.start_lead < 0.0)
+    {
+        return 0;
+    }
+
+    p_wfmref->lerp.start_status = WFMREF_STARTED;
+
+    advance = (uint16_t) p_wfmref->lerp.start_lead;
+    p_wfmref->lerp.phase = float_to_q32(p_wfmref->lerp.start_lead -
+                                        (float) advance);
+
+    if(advance)
+    {
+        if(p_wfmref->sync_mode != OneShot)
+        {
+            p_wfmref->lerp.saturated = 1;
+        }
+        else if(p_wfmref->wfmref_data.p_buf_idx <
+                p_wfmref->wfmref_data.p_buf_end)
+        {
+            if(advance > p_wfmref->wfmref_data.p_buf_end -
+                         p_wfmref->wfmref_data.p_buf_idx)
+            {
+                p_wfmref->wfmref_data.p_buf_idx =
+                                            p_wfmref->wfmref_data.p_buf_end;
+            }
+            else
+            {
+                p_wfmref->wfmref_data.p_buf_idx += advance;
+            }
+        }
+    }
+
+    return 1;
+}
+
+/**
+ * Convert fraction to Q0.32, in two 16-bit halves, so float resolution is kept
+ * for small fractions.
+ *
+ * @param frac fraction, from 0.0 to less than 1.0
+ * @return fraction in Q0.32
+ */
+static uint32_t float_to_q32(float frac)
+{
+    uint32_t frac_hi, frac_lo;
+
+    frac = frac * 65536.0;
+    frac_hi = (uint32_t) frac;
+    frac_lo = (uint32_t) ((frac - (float) frac_hi) * 65536.0);
+
+    return (frac_hi << 16) | frac_lo;
+}
@@ -14,6 +14,33 @@
  * 
  * This module implements waveform references functionality.
  *
+ * Waveforms are stored in a library shared by all power supplies, composed by
+ * a table of curve descriptors and a pool of samples. ARM uploads a curve by
+ * writing its samples anywhere in the pool and its descriptor (start index,
+ * length and checksum) in any slot of the table, and then commits it with
+ * Update_WfmRef. Only committed curves are played, and a power supply switches
+ * to the curve selected by ARM (a slot index) at the end of the current one,
+ * which doesn't depend on curve length. Therefore, ARM may
+ * upload new curves into unused slots and pool regions while another one is
+ * being played, but it must not overwrite regions from curves in use.
+ *
+ * Curve descriptors hold no gain or offset. These are still set per power
+ * supply, from parameter bank and Cfg_WfmRef, and applied when switching
+ * curves. So ARM must either upload curves already scaled, or send Cfg_WfmRef
+ * with the new gain and offset along with the curve selection.
+ *
+ * Library replaced the fixed curve buffers in firmware version 0.46.00, which
+ * changed wfmref_t and RAMS2345 layouts. ARM must check udc_c28_version before
+ * accessing them (see version.c for all layout changes in that version).
+ *
+ * After each sync pulse, waveform is aligned to the pulse edge, instead of
+ * the next control ISR, with a per-supply start delay (which may compensate
+ * load and cabling lags). Pulse phase is measured from XINT2 counter, so it's
+ * only available for sync pulses from XINT2. Since this 16-bit counter wraps
+ * every 437 us, it's read at the first control ISR after the pulse, and only
+ * if sync ISR was triggered by XINT2. Pulses from ARM (IPC MTOCIPC_INT2) are
+ * aligned to that ISR instead.
+ *
  * @author gabriel.brunheira
  * @date 22 de nov de 2017
  *
@@ -25,15 +52,17 @@
 #include <stdint.h>
 #include "common/structs.h"
 
-#define SIZE_WFMREF             4096
-#define SIZE_WFMREF_FBP         SIZE_WFMREF/4
-#define NUM_WFMREF_CURVES       2
+#define SIZE_WFMREF_LIBRARY     8192    // In 32-bit words
+#define NUM_WFMREF_CURVES       16
+#define SIZE_WFMREF_POOL        (SIZE_WFMREF_LIBRARY - 2*NUM_WFMREF_CURVES)
+                                        // Descriptor takes 2 words
 
 //#define WFMREF                  g_ipc_ctom.wfmref
 #define TIMESLICER_WFMREF       0
 #define WFMREF_FREQ             TIMESLICER_FREQ[TIMESLICER_WFMREF]
 
 #define INTERPOLATE(a, b, f)    (a * (1.0 - f)) + (b * f)
+#define Q32_TO_FLOAT            2.3283064365386963e-10    // 2^-32
 
 typedef enum
 {
@@ -42,126 +71,73 @@ typedef enum
     OneShot
 } sync_mode_t;
 
-typedef union
+typedef enum
+{
+    SyncPulse_IPC,
+    SyncPulse_XINT2
+} sync_source_t;
+
+/**
+ * Curve descriptor from waveform library. Curve samples are stored from
+ * pool[start] to pool[start + length - 1], and checksum is the 32-bit sum of
+ * their raw words.
+ */
+typedef volatile struct
+{
+    uint16_t        start;
+    uint16_t        length;
+    uint32_t        checksum;
+} wfmref_curve_t;
+
+typedef volatile struct
 {
-    float data[NUM_WFMREF_CURVES][SIZE_WFMREF];
-    float data_fbp[4][NUM_WFMREF_CURVES][SIZE_WFMREF_FBP];
-} u_wfmref_data_t;
+    wfmref_curve_t  curve[NUM_WFMREF_CURVES];
+    float           pool[SIZE_WFMREF_POOL];
+} wfmref_library_t;
 
+/**
+ * Linear interpolator between waveform samples. Position within current
+ * sample interval is kept by a fixed-point phase accumulator, incremented by
+ * freq_base/freq_lerp samples every run (step may be greater than 1, so any
+ * playback rate is allowed without rounding it to a multiple of ISR period).
+ */
 typedef volatile struct
 {
-    uint16_t        counter;
-    uint16_t        max_count;
+    uint32_t        phase;          // Position within interval [Q0.32]
+    uint32_t        step_frac;      // Fractional part of step [Q0.32]
+    uint16_t        step_int;       // Integer part of step [samples]
+    uint16_t        saturated;
+    uint16_t        start_status;
+    float           start_lead;     // Waveform position at start [samples]
     float           freq_lerp;
     float           freq_base;
-    float           inv_decimation;
     float           fraction;
     float           out;
 } wfmref_lerp_t;
 
 typedef volatile struct
 {
-    buf_t           wfmref_data[NUM_WFMREF_CURVES];
+    buf_t           wfmref_data;
     uint16_t        wfmref_selected;
     sync_mode_t     sync_mode;
     wfmref_lerp_t   lerp;
     float           gain;
     float           offset;
+    float           start_delay;    // Start delay from sync pulse [s]
     float           *p_out;
 } wfmref_t;
-/*
-inline void sync_wfmref(wfmref_t *p_wfmref, wfmref_t *p_wfmref_new)
-{
-    static uint16_t sel;
-
-    sel = p_wfmref->wfmref_selected;
-
-    switch(p_wfmref->sync_mode)
-    {
-        case SampleBySample:
-        {
-            if(p_wfmref->wfmref_data[sel].p_buf_idx++ >=
-               p_wfmref->wfmref_data[sel].p_buf_end)
-            {
-                p_wfmref->wfmref_selected = p_wfmref_new->wfmref_selected;
-                sel = p_wfmref->wfmref_selected;
-
-                p_wfmref->wfmref_data[sel] = p_wfmref_new->wfmref_data[sel];
-
-                p_wfmref->wfmref_data[sel].p_buf_idx =
-                                    p_wfmref->wfmref_data[sel].p_buf_start;
-
-                p_wfmref->gain = p_wfmref_new->gain;
-                p_wfmref->offset = p_wfmref_new->offset;
-                p_wfmref->sync_mode = p_wfmref_new->sync_mode;
-            }
-
-            break;
-        }
-
-        case SampleBySample_OneCycle:
-        {
-            if(p_wfmref->wfmref_data[sel].p_buf_idx++ ==
-               p_wfmref->wfmref_data[sel].p_buf_end)
-            {
-                p_wfmref->wfmref_data[sel].p_buf_idx =
-                        p_wfmref->wfmref_data[sel].p_buf_end;
-            }
-            else if(p_wfmref->wfmref_data[sel].p_buf_idx >
-                    p_wfmref->wfmref_data[sel].p_buf_end)
-            {
-                p_wfmref->wfmref_selected = p_wfmref_new->wfmref_selected;
-                sel = p_wfmref->wfmref_selected;
-
-                p_wfmref->wfmref_data[sel] = p_wfmref_new->wfmref_data[sel];
-
-                p_wfmref->wfmref_data[sel].p_buf_idx =
-                                    p_wfmref->wfmref_data[sel].p_buf_start;
-
-                p_wfmref->gain = p_wfmref_new->gain;
-                p_wfmref->offset = p_wfmref_new->offset;
-                p_wfmref->sync_mode = p_wfmref_new->sync_mode;
-            }
-            else
-            {
-                //p_wfmref->wfmref_data[sel].p_buf_idx++;
-            }
-
-            break;
-        }
-
-        case OneShot:
-        {
-            p_wfmref->wfmref_selected = p_wfmref_new->wfmref_selected;
-            sel = p_wfmref->wfmref_selected;
-
-            p_wfmref->wfmref_data[sel] = p_wfmref_new->wfmref_data[sel];
-
-            p_wfmref->wfmref_data[sel].p_buf_idx =
-                                    p_wfmref->wfmref_data[sel].p_buf_start;
-
-            p_wfmref->gain = p_wfmref_new->gain;
-            p_wfmref->offset = p_wfmref_new->offset;
-            p_wfmref->sync_mode = p_wfmref_new->sync_mode;
-
-            break;
-        }
-    }
 
-    p_wfmref->lerp.counter = 0;
-}
-*/
-extern volatile u_wfmref_data_t g_wfmref_data;
+extern volatile wfmref_library_t g_wfmref_library;
 extern volatile wfmref_lerp_t wfmref_lerp;
 
 extern void init_wfmref(wfmref_t *p_wfmref, uint16_t wfmref_selected,
                         sync_mode_t sync_mode, float freq_lerp, float freq_wfmref,
-                        float gain, float offset, float *p_start, uint16_t size,
-                        float *p_out);
+                        float gain, float offset, float *p_out);
 extern void cfg_wfmref(wfmref_t *p_wfmref, wfmref_t *p_wfmref_new);
 extern void reset_wfmref(wfmref_t *p_wfmref);
-extern void update_wfmref(wfmref_t *p_wfmref, wfmref_t *p_wfmref_new);
-extern void sync_wfmref(wfmref_t *p_wfmref, wfmref_t *p_wfmref_new);
+extern uint16_t update_wfmref(wfmref_t *p_wfmref, wfmref_t *p_wfmref_new);
+extern void sync_wfmref(wfmref_t *p_wfmref, wfmref_t *p_wfmref_new,
+                        sync_source_t sync_source);
 extern void run_wfmref(wfmref_t *p_wfmref);
 
 #endif /* WFMREF_H_ */